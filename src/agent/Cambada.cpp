@@ -21,6 +21,7 @@
  */
 
 #include "Cambada.h"
+#include "rtdb_typed.h"
 #include "Field.h"
 #include "Behaviour.h"
 
@@ -196,7 +197,7 @@ void Cambada::thinkAndAct()
 		}
 	}
 
-	DB_put( ROBOT_WS , (void*)(world->me) );
+	rtdb::put_len<ROBOT_WS>( *world->me , world->me->usedSize() );
 
 	world->updateEndCycle();
 
@@ -22,6 +22,7 @@
 
 #include "Integrator.h"
 #include "log.h"
+#include "rtdb_typed.h"
 #include <syslog.h>
 
 namespace cambada{
@@ -38,7 +39,7 @@ Integrator::Integrator( ConfigXML* config, WorldState* world , Strategy* strateg
 
 	Field* field = world->getField();
 	struct timeval start_instant;
-	gettimeofday( &start_instant , NULL );
+	cambada::util::Clock::gettime( &start_instant );
 	this->integrate_ball = new IntegrateBall(field, config->getParam("measure_deviation"), start_instant);
 	this->integrate_player = new IntegratePlayer(config); //, lines, coach.playerInfo[myID].goalColor)
 
@@ -74,7 +75,7 @@ void Integrator::integrate()
 	static struct timeval instant;
 
 	// Get time struct
-	gettimeofday( &instant , NULL );
+	cambada::util::Clock::gettime( &instant );
 
 //////////////////////////////////////////////////////////////////////////////////////////////////// Update debug points
 	for ( int i=0; i< 4; i++ ) {
@@ -148,11 +149,26 @@ void Integrator::integrate()
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////// UPDATE OTHER ROBOTS INFO
+	// read all the team mates in one batch, with a single timestamp
+	RTDBitem robotsWS[N_CAMBADAS];
+	int nRobotsWS = 0;
 	for( int i = 0 ; i < N_CAMBADAS ; i++ )
 	{
 		if( myID != i )
 		{
-			int ltime = DB_get( i+1 , ROBOT_WS , &world->robot[i] );
+			robotsWS[nRobotsWS].agent = i+1;
+			robotsWS[nRobotsWS].id = ROBOT_WS;
+			robotsWS[nRobotsWS].value = &world->robot[i];
+			nRobotsWS++;
+		}
+	}
+	DB_get_many( robotsWS , nRobotsWS );
+
+	for( int i = 0, n = 0 ; i < N_CAMBADAS ; i++ )
+	{
+		if( myID != i )
+		{
+			int ltime = robotsWS[n++].life;
 			if( ltime == -1 )
 			{
 				cerr << "[Integrator] : integrate - db_get ROBOT_WS error" << endl;
@@ -237,7 +253,7 @@ void Integrator::integrate()
 ////////////////////////////////////////////////////////////////////////////////////////////////////// Predict Avaliable
 	// GET last velocity command (used latter for WorldState Prediction)
 	CMD_Vel v;
-	DB_get( Whoami(),LAST_CMD_VEL,&v);
+	rtdb::get<LAST_CMD_VEL>( Whoami(), v );
 	buffer.pop_front();
 	buffer.push_back(v);
 
@@ -250,23 +266,23 @@ void Integrator::integrate()
 		predictNoCollision();
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////// Close Cycle
-	gettimeofday( &instant , NULL );
+	cambada::util::Clock::gettime( &instant );
 	world->timeStamp = instant.tv_sec*1000 + instant.tv_usec/1000;
 }
 
 void Integrator::loadVision(bool use_front_vision)
 {
 	// GET VisionInfo
-	if( DB_get( Whoami() , VISION_INFO , &vision ) == -1 )
-		if( DB_get( Whoami() , VISION_INFO , &vision ) == -1 )
+	if( rtdb::get<VISION_INFO>( Whoami() , vision ) == -1 )
+		if( rtdb::get<VISION_INFO>( Whoami() , vision ) == -1 )
 			cerr << "[Integrator] : integrate - db_get VISION_INFO error" << endl;
 
 	if(use_front_vision)
 	{
 		// GET FrontVisionInfo
 		int frontVisionLifeTime = 1000;
-		if( (frontVisionLifeTime = DB_get( Whoami() , FRONT_VISION_INFO , &frontVision )) == -1 )
-			if( (frontVisionLifeTime = DB_get( Whoami() , FRONT_VISION_INFO , &frontVision )) == -1 )
+		if( (frontVisionLifeTime = rtdb::get<FRONT_VISION_INFO>( Whoami() , frontVision )) == -1 )
+			if( (frontVisionLifeTime = rtdb::get<FRONT_VISION_INFO>( Whoami() , frontVision )) == -1 )
 				cerr << "[Integrator] : integrate - db_get FRONT_VISION_INFO error" << endl;
 		if( frontVisionLifeTime >= 0 && frontVisionLifeTime <= 100 ) frontVision.clear();
 	}
@@ -277,8 +293,8 @@ void Integrator::loadCoach(int coachRtdbID)
 {
 	// Load coach
 	int coachLt;
-	if( (coachLt=DB_get( coachRtdbID , COACH_INFO , &coach )) == -1 )
-		if( (coachLt=DB_get( coachRtdbID , COACH_INFO , &coach )) == -1 )
+	if( (coachLt=rtdb::get<COACH_INFO>( coachRtdbID , coach )) == -1 )
+		if( (coachLt=rtdb::get<COACH_INFO>( coachRtdbID , coach )) == -1 )
 			cerr << "[Integrator] : integrate - db_get COACH_INFO error" << endl;
 
 	world->coach = coach;  //needed for setplays
@@ -286,8 +302,8 @@ void Integrator::loadCoach(int coachRtdbID)
 	// TODO if there no coach clear finfo information
 	// Load formation
 	int formationLt;
-	if( (formationLt=DB_get( coachRtdbID , FORMATION_INFO , &strategy->finfo )) == -1 )
-		if( (formationLt=DB_get( coachRtdbID , FORMATION_INFO , &strategy->finfo )) == -1 )
+	if( (formationLt=rtdb::get<FORMATION_INFO>( coachRtdbID , strategy->finfo )) == -1 )
+		if( (formationLt=rtdb::get<FORMATION_INFO>( coachRtdbID , strategy->finfo )) == -1 )
 			cerr << "[Integrator] : integrate - db_get FORMATION_INFO error" << endl;
 
 	world->isFormationCoachAvailable = ( formationLt <= NOT_RUNNING_TIMEOUT );
@@ -437,7 +453,7 @@ void Integrator::updateGameState()
 		|| world->gameState ==  preOwnFreeKick )
 		{
 			//cout << "--- own reset timer"<< endl;
-			gettimeofday(&tv1,NULL);
+			cambada::util::Clock::gettime(&tv1);
 			grabberTouched = false;
 
 			ballPos = Vec(0.0,0.0);
@@ -463,7 +479,7 @@ void Integrator::updateGameState()
 		|| world->gameState ==  preOpponentPenalty
 		|| world->gameState ==  preOpponentFreeKick )
 		{
-			gettimeofday(&tv1,NULL);
+			cambada::util::Clock::gettime(&tv1);
 
 			ballSeen = false;
 			ballPos = Vec(0.0,0.0);
@@ -484,7 +500,7 @@ void Integrator::updateGameState()
 		|| world->gameState == postOpponentPenalty
 		|| world->gameState == postOpponentFreeKick )
 		{
-			gettimeofday(&tv2,NULL);
+			cambada::util::Clock::gettime(&tv2);
 			const int waitTime = (int)( (tv2.tv_sec+tv2.tv_usec/1e6) - (tv1.tv_sec+tv1.tv_usec/1e6) );
 
 			// myprintf("BARRIER post int. %d\n", waitTime);
@@ -502,7 +518,7 @@ void Integrator::updateGameState()
 		|| world->gameState == postOwnCornerKick
 		|| world->gameState == postOwnFreeKick )
 		{
-			gettimeofday(&tv2,NULL);
+			cambada::util::Clock::gettime(&tv2);
 			unsigned long currentTime = (tv2.tv_sec+tv2.tv_usec/1e6);
 			const int toPlayTime = (int)( (tv2.tv_sec+tv2.tv_usec/1e6) - (tv1.tv_sec+tv1.tv_usec/1e6) );
 
@@ -21,6 +21,7 @@
  */
 
 #include "ObstacleHandler.h"
+#include "Clock.h"
 
 using namespace cambada::geom;
 
@@ -523,7 +524,7 @@ double ObstacleHandler::getErrorMargin(double distance)
 void ObstacleHandler::buildAndUpdateObstacles(Vec points[], int nPoints)
 {
 	//Register the current time
-	gettimeofday( &currentTime , NULL );
+	cambada::util::Clock::gettime( &currentTime );
 	world->pointsRighOfBall = 0;
 	world->pointsLeftOfBall = 0;
 	
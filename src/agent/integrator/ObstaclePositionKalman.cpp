@@ -21,6 +21,7 @@
  */
 
 #include "ObstaclePositionKalman.h"
+#include "Clock.h"
 #include <cstdio>
 
 using namespace cambada::geom;
@@ -47,7 +48,7 @@ void ObstaclePositionKalman::init()
 	lastVel		= Vec::zero_vector;
 	
 	struct timeval tmpTime;
-	gettimeofday( &tmpTime , NULL );
+	cambada::util::Clock::gettime( &tmpTime );
 	
 	lastTime = tmpTime.tv_sec*1000 + tmpTime.tv_usec/1000;
 
@@ -21,6 +21,7 @@
  */
 
 #include "UseCompass.h"
+#include "rtdb_typed.h"
 #include <syslog.h>
 
 namespace cambada {
@@ -62,7 +63,7 @@ void UseCompass::integrate(vector<Vec> vision_lines, float lowLevelDx, float low
 
 	// Get Heading
 	CMD_Imu info;
-	DB_get( Whoami() , CMD_IMU, (void*)(&info) );
+	rtdb::get<CMD_IMU>( Whoami() , info );
 	Angle currentHeading = Angle(info.rawYaw / 180.0 * M_PI);
 
 	// Update loc
@@ -95,7 +96,7 @@ void UseCompass::updateCompass(WSColor goalColor)
 	//if( DB_get( Whoami() , CMD_COMPASS, (void*)(&compassRead) ) != -1 )
 	//if( DB_get( Whoami() , CMD_IMU, (void*)(&compassRead) ) != -1 )
 	CMD_Imu info;
-	if( DB_get( Whoami() , CMD_IMU, (void*)(&info) ) != -1 )
+	if( rtdb::get<CMD_IMU>( Whoami() , info ) != -1 )
 	{
 		compassRead = info.yaw;
 		
@@ -44,6 +44,7 @@ using namespace cambada;
 Cambada* agent = NULL;
 bool EXIT = false;
 bool		WAIT	= true;
+volatile sig_atomic_t	RECONFIGURE	= 0;
 char		pname[64]	= "agent";
 
 sigset_t configControlLoopSignals(void);
@@ -98,6 +99,9 @@ int main( int argc , char* argv[] )
 		fprintf(stderr, "cambada_agent : [%s]: PMAN_attach failed (return code %d)\n",pname,pmanstat);
 		exit(EXIT_FAILURE);
 	}
+
+	// agent timing follows the simulated time when the simulator runs pman in lockstep
+	cambada::util::Clock::setSource(PMAN_gettime);
 #endif
 
 	if( !EXIT )
@@ -115,7 +119,29 @@ int main( int argc , char* argv[] )
 	WAIT = false;
 	while( !EXIT )
 	{
-	   sigsuspend(&sig7mask);
+#if USE_PMAN
+		// activations come through the process table (PMAN_wait_activation), so the
+		// agent runs here, outside the signal handler
+		pmanstat = PMAN_wait_activation(pname);
+		if( pmanstat > 0 && !EXIT )
+		{
+			agent->thinkAndAct();
+			PMAN_epilogue(pname);
+		}
+		else if( pmanstat == -1 || pmanstat == -2 )
+		{
+			fprintf(stderr, "cambada_agent : [%s]: PMAN_wait_activation failed (return code %d)\n",pname,pmanstat);
+			EXIT = true;
+		}
+#else
+		sigsuspend(&sig7mask);
+#endif
+
+		if( RECONFIGURE )
+		{
+			RECONFIGURE = 0;
+			agent->reconfigure();
+		}
 	}
 
 	CMD_Vel_SET(0.0,0.0,0.0,false);
@@ -155,24 +181,11 @@ void controlLoop(int sig )
 	if( WAIT )
 		return;
 
-	if( sig == PMAN_ACTIVATE_SIG )
-	{
-		agent->thinkAndAct();
-
-#if USE_PMAN
-		PMAN_epilogue(pname);
-#endif
-	}
-	else
+	// only flags here, the work is done in the main loop
 	if( sig == SIGHUP )
-	{
-		if( agent->reconfigure() )
-			EXIT = false;
-	}
+		RECONFIGURE = 1;
 	else
-	{
 		EXIT = true;
-	}
 
 }
 
@@ -181,9 +194,8 @@ sigset_t configControlLoopSignals(void)
 {
 	sigset_t sigusrmask, sigemptymask;
 
-	// Install handler
+	// Install handler (not for PMAN_ACTIVATE_SIG, activations come through PMAN_wait_activation)
 	sigemptyset( &sigusrmask );
-	sigaddset( &sigusrmask , PMAN_ACTIVATE_SIG );
 	sigaddset( &sigusrmask , SIGINT );
 	sigaddset( &sigusrmask , SIGTERM );
 	sigaddset( &sigusrmask , SIGHUP );
@@ -194,7 +206,6 @@ sigset_t configControlLoopSignals(void)
 	sigact.sa_mask = sigemptymask;
 	sigact.sa_handler = (void (*)(int))controlLoop;
 
-	sigaction(PMAN_ACTIVATE_SIG, &sigact, NULL);
 	sigaction(SIGINT, &sigact, NULL);
 	sigaction(SIGTERM, &sigact, NULL);
 	sigaction(SIGHUP, &sigact, NULL);
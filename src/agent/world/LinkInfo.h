@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA AGENT
+ *
+ * CAMBADA AGENT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA AGENT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LINKINFO_H_
+#define _LINKINFO_H_
+
+// one entry per agent number (MAX_AGENTS of the comm frame)
+#define LINK_PEERS				7
+
+// peer state, as seen by comm
+#define LINK_NOT_RUNNING		0
+#define LINK_RUNNING			1
+#define LINK_INSERT				2
+#define LINK_REMOVE				3
+
+
+// quality of the link from one teammate, measured by comm
+struct LinkPeer
+{
+	int state;					// LINK_NOT_RUNNING, ...
+	int age;					// ms since its last frame (-1 = never received)
+	float lossRate;				// fraction of its frames lost (smoothed)
+	int jitter;					// inter-arrival jitter, us (RFC 3550)
+	int delay;					// one-way delay estimate, half the round trip, us (-1 = unknown)
+	int frameSize;				// bytes of its last frame
+	int bytesPerSecond;			// received from it (smoothed)
+};
+
+
+// local item written by comm every cycle (LINK_QUALITY)
+struct LinkInfo
+{
+	int txFrameSize;			// bytes of our last frame
+	int txBytesPerSecond;		// sent by us (smoothed)
+	LinkPeer peer[LINK_PEERS];	// indexed by agent number
+};
+
+#endif
@@ -52,4 +52,11 @@ Robot::Robot() {
 	this->passLine = Line();
 }
 
+int Robot::usedSize() const {
+	unsigned int n = this->nObst;
+	if( n > MAX_SHARED_OBSTACLES )
+		n = MAX_SHARED_OBSTACLES;
+	return (const char*)&this->obstacles[n] - (const char*)this;
+}
+
 } /* namespace cambada */
@@ -35,6 +35,9 @@ class Robot {
 public:
 	Robot();
 
+	/*! Bytes in use, the shared obstacles are only valid up to nObst (used by DB_put_len) */
+	int usedSize() const;
+
 	// Shared atributes
 	int		number;				// Robot number
 	BehaviourID		behaviour;	// Behaviour index
@@ -61,7 +64,7 @@ public:
 	Ball 	ball;				// Ball used by robot (can be seen or shared)
 	Line	passLine;			// Line set when there is a pass
 
-	ObstacleInfo obstacles[MAX_SHARED_OBSTACLES];
+	ObstacleInfo obstacles[MAX_SHARED_OBSTACLES];	// keep it last: only nObst entries are shared
 };
 
 } /* namespace cambada */
@@ -26,6 +26,14 @@ VisionInfo::VisionInfo()
 {
 }
 
+int VisionInfo::usedSize() const
+{
+	int n = lines.nPoints;
+	if( n < 0 || n > MAX_POINTS )
+		n = MAX_POINTS;
+	return (const char*)&lines.point[n] - (const char*)this;
+}
+
 FrontVisionInfo::FrontVisionInfo()
 {
 }
@@ -65,11 +65,14 @@ class VisionInfo
 {
 public:
 	VisionInfo();
-	
-	RadialSensor	obstacles;
-	RadialSensor	lines;
+
+	/*! Bytes in use, the line points are only valid up to lines.nPoints (used by DB_put_len) */
+	int usedSize() const;
+
 	BallSensor		ball[MAX_BALLS];
 	int nBalls;
+	RadialSensor	obstacles;
+	RadialSensor	lines;			// keep it last: only its used prefix is copied to the RTDB
 };
 
 class FrontVisionInfo
@@ -22,6 +22,7 @@
 
 #include "WorldState.h"
 #include "ConfigXML.h"
+#include "Clock.h"
 
 using namespace cambada::geom;
 
@@ -418,7 +419,7 @@ Vec WorldState::getReplacerSearchPos()
 double WorldState::parkingTimeMS()
 {
 	struct timeval tv;
-	gettimeofday(&tv,NULL);
+	cambada::util::Clock::gettime(&tv);
 
 	return ( (tv.tv_sec*1e3+tv.tv_usec/1e3) - parkingTimer );
 }
@@ -427,7 +428,7 @@ double WorldState::parkingTimeMS()
 void WorldState::resetParkingTimer()
 {
 	struct timeval tv;
-	gettimeofday(&tv,NULL);
+	cambada::util::Clock::gettime(&tv);
 	parkingTimer = tv.tv_sec*1e3+tv.tv_usec/1e3;
 }
 
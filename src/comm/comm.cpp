@@ -26,33 +26,83 @@
 #include <string.h>
 #include <stdio.h>
 #include <signal.h>
-#include <pthread.h>
 #include <errno.h>
 
 #include <unistd.h>
 
 #include <sys/time.h>
+#include <sys/timerfd.h>
+#include <sys/epoll.h>
+#include <stdint.h>
 #include <sched.h>
 
 #include <stdlib.h>
 
 #include "multicast.h"
+#include "wire.h"
 
 #include "rtdb_comm.h"
+#include "rtdb_typed.h"
+#include "pman.h"
+#include "pmandefs.h"
+#include "LinkInfo.h"
 
-#include "MersenneTwister.h"
 
+#define BUFFER_SIZE 1400		// one datagram
+#define RECV_BATCH 16			// datagrams taken from the socket at once
 
-#define BUFFER_SIZE 1400
+// frames bigger than a datagram are sent in fragments
+#define MAX_FRAGMENTS 64
+#define FRAGMENT_DATA (BUFFER_SIZE - (int)sizeof(struct _fragmentHeader))
+#define MAX_FRAME_SIZE (MAX_FRAGMENTS * FRAGMENT_DATA)
+#define FRAGMENT_TIMEOUT_US TTUP_US	// incomplete frames are dropped after this
 
 #define TTUP_US 100E3 // 10Hz -> 100E3, 20Hz -> 50E3
 #define COMM_DELAY_MS 2
 #define COMM_DELAY_US COMM_DELAY_MS*1E3
 #define MIN_UPDATE_DELAY_US 1E3
 
+// frames looked at when spreading records with different periods
+#define MAX_HYPERPERIOD 240
+
+// record ids a peer can send (delta keyframes are kept per agent and id)
+#define MAX_ITEMS 256
+
+// transmissions of a record coded against the same keyframe
+#define WIRE_KEY_PERIOD 8
+
+// channels without echoes (no acks): a keyframe every 1 + WIRE_KEY_LOSS / loss
+// transmissions at most, loss being the worst frame loss rate of the peers
+#define WIRE_KEY_LOSS 0.02
+
+// peer clock offset: minimum of (receive - send time) over this many frames
+#define OFFSET_WINDOW 64
+
+// urgent frames (DB_put_urgent): at most URGENT_PER_CYCLE per Ttup, URGENT_GAP_US
+// apart from any other transmission; in sync mode they stay URGENT_GUARD_US away
+// from the start of every slot, and URGENT_BUSY_US after it
+#define URGENT_PER_CYCLE 3
+#define URGENT_GAP_US 5E3
+#define URGENT_GUARD_US 2E3
+#define URGENT_BUSY_US 5E3
+
+// comm channels: 0 is the default group (with the RA-TDMA), the others come from
+// rtdb.ini (CHANNEL in rtdb.conf) and only carry records
+#define MAX_CHANNELS 8
+
+// link quality smoothing, new = old + (sample - old) / LINK_SMOOTH (per frame or cycle)
+#define LINK_SMOOTH 8
+
+#if LINK_PEERS != MAX_AGENTS
+#error LinkInfo must have one entry per agent of the frame
+#endif
+
+// slot error histogram, bin i counts errors below SLOT_BIN_US << i (the last one the rest)
+#define SLOT_BINS 8
+#define SLOT_BIN_US 250
+
 // #define DEBUG
 // #define FILEDEBUG
-#define UNSYNC
 
 #define PERRNO(txt) \
 	printf("ERROR: (%s / %s): " txt ": %s\n", __FILE__, __FUNCTION__, strerror(errno))
@@ -85,19 +135,28 @@
 #define NO	0
 #define YES	1
 
-int end;
-int timer;
+int quit;
+int timerFd;
 
 int MAX_DELTA;
 
-struct timeval lastSendTimeStamp;
+long long lastSendTime;				// monotonic, us
 int delay;
 int nosend;
+int syncMode;						// RA-TDMA (transmit in our slot) or free running
+int dumpStats;
 
 #ifdef DEBUF
 #endif
 
 int lostPackets[MAX_AGENTS];
+int lostFragments[MAX_AGENTS];
+int schemaMismatch[MAX_AGENTS];		// frames rejected (other version, rtdb.ini or data types)
+int missingKeys[MAX_AGENTS];		// records dropped, keyframe not received
+
+float txBytesPerCycle;
+
+unsigned int schemaHash;
 
 struct _record
 {
@@ -107,12 +166,34 @@ struct _record
 	void* pData;	// pointer to data
 };
 
-struct _frameHeader
+struct _wireKey
+{
+	unsigned char seq;					  // keyframe sequence (WIRE_KEY_MASK)
+	int sent;							        // transmissions since the keyframe (0 = none yet, sender only)
+	unsigned int keyTime;				  // send time of the frame with the keyframe (sender only)
+	unsigned int acked;					  // agents that echoed that frame (bit per agent, sender only)
+	int len;							        // keyframe bytes
+	unsigned char *data;				  // keyframe
+};
+
+struct _fragmentHeader
 {
 	unsigned char number;			    // agent number
-	unsigned int counter;			    // frame counter
-	char stateTable[MAX_AGENTS];	// table with my vision of each agent state
-	int noRecs;						        // number of records
+	unsigned char fragment;			  // fragment index
+	unsigned char nFragments;		  // fragments in the frame (1 = not fragmented)
+	unsigned char channel;			  // channel of the frame
+	unsigned char counter[4];		  // frame counter (little endian)
+};
+
+struct _reassembly
+{
+	unsigned int counter;				  // frame being reassembled
+	int nFragments;						    // fragments in the frame (0 = none pending)
+	int received;						      // fragments received
+	unsigned long long mask;			// fragments received (bit per fragment)
+	int size;							        // frame size (known when the last fragment arrives)
+	long long time;						    // first fragment receive time (monotonic, us)
+	char *buffer;						      // MAX_FRAME_SIZE bytes
 };
 
 struct _agent
@@ -120,18 +201,80 @@ struct _agent
 	char state;							          // current state
 	char dynamicID;					          // position in frame
 	char received;						        // received from agent in the last Ttup?
-	struct timeval receiveTimeStamp;	// last receive time stamp
+	long long receiveTime;				    // last receive time (monotonic, us)
 	int delta;							          // delta
-	unsigned int lastFrameCounter;		// frame number
+	int offset;							          // clock offset, receive - send time at the minimum delay (us)
+	int offsetValid;
+	int windowMin;						        // minimum of the current offset window
+	int windowSamples;
+	int excessDelay;					        // delay of the last frame above the minimum (us)
+	long long frameTime;				      // receive time of its last frame (monotonic, us, 0 = none)
+	unsigned int frameSendTime;			  // send time in its last frame (its clock)
+	int jitter;							          // inter-arrival jitter (us)
+	int rtt;							            // round trip time (us, -1 = unknown)
+	int frameSize;						        // bytes of its last frame
+	int cycleFrames, cycleLost, cycleBytes;	// received in this cycle
+	float lossRate;						        // smoothed, per cycle
+	float bytesPerCycle;
 	char stateTable[MAX_AGENTS];		  // vision of agents state
   int removeCounter;                // counter to move agent to not_running state
 };
 
 
+struct _slotStats
+{
+	unsigned int bins[SLOT_BINS];		// |slot error| histogram
+	unsigned int samples;
+	unsigned int outOfSlot;				// frames sent out of their slot (would collide)
+	long long sumError;					  // sum of |slot error| (us)
+	int maxError;
+};
+
+struct _schedule
+{
+  unsigned int next;      // frame where the record is due
+  int period;             // broadcast period, in frames (rtdb.conf)
+};
+
+
+struct _channel
+{
+	int number;							  // channel number in rtdb.ini (0 = default)
+	int socket;							  // -1 = not joined
+	int period;							  // transmission period, in cycles
+	unsigned int counter;				// next frame (each channel has its own)
+	int first, n;						    // its records, rec[first .. first + n - 1]
+	unsigned int lastFrame[MAX_AGENTS];	// last frame counter received from each agent
+	int lost[MAX_AGENTS];				// frames lost from each agent (channels other than 0)
+};
+
+
 int myNumber;
 
 struct _agent agent[MAX_AGENTS];
 
+// channels joined, and the records of each one
+struct _channel channel[MAX_CHANNELS];
+int nChannels;
+
+// our shared records (sorted by channel), their schedule, and the keyframes sent
+RTDBconf_var *rec = NULL;
+struct _schedule *sched = NULL;
+int *order = NULL;
+struct _wireKey *sendKey = NULL;
+char *urgentPending = NULL;
+unsigned char *recData;
+
+// slot error of each agent transmissions, as seen here
+struct _slotStats slotStats[MAX_AGENTS];
+
+// frames being reassembled, one per channel and agent
+struct _reassembly reassembly[MAX_CHANNELS][MAX_AGENTS];
+
+// last keyframe received of each record of each agent
+struct _wireKey recvKey[MAX_AGENTS][MAX_ITEMS];
+unsigned char *recvData;
+
 int RUNNING_AGENTS;
 
 
@@ -141,10 +284,299 @@ int RUNNING_AGENTS;
 static void signal_catch(int sig)
 {
   if (sig == SIGINT)
-    end = 1;
+    quit = 1;
+  else
+    if (sig == SIGUSR1)
+      dumpStats = 1;
+}
+
+
+
+//	*************************
+//  Monotonic time, in us
+//
+static long long monotonicUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+
+//	*************************
+//  Next transmission in firstUs, then one every Ttup
+//
+void setTimer(long firstUs)
+{
+  struct itimerspec it;
+
+  // 0 would disarm the timer
+  if (firstUs < 1)
+    firstUs = 1;
+  it.it_value.tv_sec = firstUs / 1000000;
+  it.it_value.tv_nsec = (firstUs % 1000000) * 1000;
+  it.it_interval.tv_sec = (long)TTUP_US / 1000000;
+  it.it_interval.tv_nsec = ((long)TTUP_US % 1000000) * 1000;
+  if (timerfd_settime(timerFd, 0, &it, NULL) == -1)
+    PERRNO("timerfd_settime");
+}
+
+
+
+//	*************************
+//  Clock offset of an agent, from the send time in its frames
+//    receive - send time = offset + delay, so the offset is taken at the
+//    minimum delay seen in a window, and the excess delay of each frame
+//    (queueing, retries) is what is left
+//
+//  Input:
+//    int agentNumber = agent
+//    unsigned int sendTime = frame send time, agent clock (us, wraps)
+//
+void clock_offset(int agentNumber, unsigned int sendTime)
+{
+  struct _agent *a = &agent[agentNumber];
+  int sample;
+
+  // differences are taken modulo 2^32, the clocks may wrap
+  sample = (int)((unsigned int)a->receiveTime - sendTime);
+
+  if ((a->windowSamples == 0) || (sample - a->windowMin < 0))
+    a->windowMin = sample;
+  if (++a->windowSamples == OFFSET_WINDOW)
+  {
+    a->offset = a->windowMin;
+    a->offsetValid = 1;
+    a->windowSamples = 0;
+  }
+
+  // a smaller delay than the offset, the clocks drifted
+  if (a->offsetValid && (sample - a->offset < 0))
+    a->offset = sample;
+
+  a->excessDelay = a->offsetValid ? sample - a->offset : 0;
+}
+
+
+
+//	*************************
+//  Slot error statistics
+//
+//  Input:
+//    int agentNumber = agent
+//    int error = time from its slot to its transmission (us)
+//
+void slot_stats(int agentNumber, int error)
+{
+  struct _slotStats *st = &slotStats[agentNumber];
+  int i;
+
+  if (error < 0)
+    error = -error;
+
+  for (i = 0; (i < SLOT_BINS - 1) && (error >= (SLOT_BIN_US << i)); i++)
+    ;
+  st->bins[i] ++;
+  st->samples ++;
+  st->sumError += error;
+  if (error > st->maxError)
+    st->maxError = error;
+
+  // more than half a slot away, it overlaps the transmission of a neighbour
+  if (error > (int)(TTUP_US / RUNNING_AGENTS / 2))
+    st->outOfSlot ++;
+}
+
+
+
+//	*************************
+//  Print the slot error histograms
+//
+void print_stats(void)
+{
+  int i, b;
+
+  printf("communication: slot error (%s mode), us\n", syncMode ? "sync" : "unsync");
+  printf("agent  frames  outOfSlot    mean     max |");
+  for (b = 0; b < SLOT_BINS - 1; b++)
+    printf(" <%-6d", SLOT_BIN_US << b);
+  printf(" >=%-6d\n", SLOT_BIN_US << (SLOT_BINS - 2));
+
+  for (i = 0; i < MAX_AGENTS; i++)
+  {
+    if (slotStats[i].samples == 0)
+      continue;
+    printf("%5d %7u %10u %7lld %7d |", i, slotStats[i].samples, slotStats[i].outOfSlot,
+      slotStats[i].sumError / slotStats[i].samples, slotStats[i].maxError);
+    for (b = 0; b < SLOT_BINS; b++)
+      printf(" %-7u", slotStats[i].bins[b]);
+    printf("\n");
+  }
+}
+
+
+
+//	*************************
+//  Link quality, a frame received from an agent
+//
+//  Input:
+//    int agentNumber = agent
+//    unsigned int sendTime = frame send time, agent clock (us, wraps)
+//    int frameLen = frame size
+//
+void link_frame(int agentNumber, unsigned int sendTime, int frameLen)
+{
+  struct _agent *a = &agent[agentNumber];
+  int d;
+
+  // RFC 3550: change in transit time between consecutive frames
+  if (a->frameTime != 0)
+  {
+    d = (int)(a->receiveTime - a->frameTime) - (int)(sendTime - a->frameSendTime);
+    if (d < 0)
+      d = -d;
+    a->jitter += (d - a->jitter) / 16;
+  }
+  a->frameTime = a->receiveTime;
+  a->frameSendTime = sendTime;
+
+  a->frameSize = frameLen;
+  a->cycleFrames ++;
+  a->cycleBytes += frameLen;
+}
+
+
+
+//	*************************
+//  Link quality, an agent echoed one of our frames
+//
+//  Input:
+//    int agentNumber = agent
+//    unsigned int echoTime = our frame send time (us, wraps)
+//    unsigned int hold = time the agent held it before answering (us)
+//
+void link_rtt(int agentNumber, unsigned int echoTime, unsigned int hold)
+{
+  struct _agent *a = &agent[agentNumber];
+  int rtt;
+
+  rtt = (int)((unsigned int)a->receiveTime - echoTime - hold);
+  if ((rtt < 0) || (rtt > (int)TTUP_US * 10))
+    return;
+
+  if (a->rtt < 0)
+    a->rtt = rtt;
   else
-    if (sig == SIGALRM)
-      timer++;
+    a->rtt += (rtt - a->rtt) / LINK_SMOOTH;
+}
+
+
+
+//	*************************
+//  Link quality of every agent, once per cycle, to the RTDB (LINK_QUALITY)
+//
+//  Input:
+//    int txFrameSize = bytes of the frame sent in this cycle
+//
+void link_update(int txFrameSize)
+{
+  static int warned = 0;
+  LinkInfo info;
+  struct _agent *a;
+  long long now;
+  int i;
+
+  now = monotonicUs();
+
+  txBytesPerCycle += (txFrameSize - txBytesPerCycle) / LINK_SMOOTH;
+  info.txFrameSize = txFrameSize;
+  info.txBytesPerSecond = (int)(txBytesPerCycle * 1E6 / TTUP_US);
+
+  for (i = 0; i < MAX_AGENTS; i++)
+  {
+    a = &agent[i];
+    if (a->cycleFrames + a->cycleLost > 0)
+      a->lossRate += ((float)a->cycleLost / (a->cycleFrames + a->cycleLost) - a->lossRate) / LINK_SMOOTH;
+    a->bytesPerCycle += (a->cycleBytes - a->bytesPerCycle) / LINK_SMOOTH;
+    a->cycleFrames = 0;
+    a->cycleLost = 0;
+    a->cycleBytes = 0;
+
+    info.peer[i].state = a->state;
+    info.peer[i].age = (a->frameTime == 0) ? -1 : (int)((now - a->frameTime) / 1000);
+    info.peer[i].lossRate = a->lossRate;
+    info.peer[i].jitter = a->jitter;
+    info.peer[i].delay = (a->rtt < 0) ? -1 : a->rtt / 2;
+    info.peer[i].frameSize = a->frameSize;
+    info.peer[i].bytesPerSecond = (int)(a->bytesPerCycle * 1E6 / TTUP_US);
+  }
+
+  if ((rtdb::put<LINK_QUALITY>(info) == -1) && (warned++ == 0))
+    PERR("No LINK_QUALITY record in the RTDB of this agent");
+}
+
+
+
+//	*************************
+//  Keyframes, an agent echoed one of our periodic frames of the default channel
+//    the keyframes sent in that frame reached it
+//
+//  Input:
+//    int agentNumber = agent
+//    unsigned int echoTime = our frame send time (us, wraps)
+//
+void key_ack(int agentNumber, unsigned int echoTime)
+{
+  int i;
+
+  for (i = channel[0].first; i < channel[0].first + channel[0].n; i++)
+    if ((sendKey[i].sent > 0) && (sendKey[i].keyTime == echoTime))
+      sendKey[i].acked |= 1u << agentNumber;
+}
+
+
+
+//	*************************
+//  Keyframes, the running peers (that must have a keyframe to decode deltas)
+//
+//  Output:
+//    bit per agent
+//
+unsigned int key_peers(void)
+{
+  unsigned int peers = 0;
+  int i;
+
+  for (i = 0; i < MAX_AGENTS; i++)
+    if ((i != myNumber) && (agent[i].state == RUNNING))
+      peers |= 1u << i;
+
+  return peers;
+}
+
+
+
+//	*************************
+//  Keyframes, transmissions coded against the same keyframe on channels
+//    without echoes, fewer as the measured frame loss grows
+//
+//  Output:
+//    1 (every transmission a keyframe) to WIRE_KEY_PERIOD
+//
+int key_period(void)
+{
+  float loss = 0;
+  int i;
+
+  for (i = 0; i < MAX_AGENTS; i++)
+    if ((i != myNumber) && (agent[i].state == RUNNING) && (agent[i].lossRate > loss))
+      loss = agent[i].lossRate;
+
+  if (loss * (WIRE_KEY_PERIOD - 1) <= WIRE_KEY_LOSS)
+    return WIRE_KEY_PERIOD;
+  return 1 + (int)(WIRE_KEY_LOSS / loss);
 }
 
 
@@ -152,8 +584,8 @@ static void signal_catch(int sig)
 // RA-TDMA
 int sync_ratdma(int agentNumber)
 {
-  int realDiff, expectedDiff;
-  struct itimerval it;
+  int realDiff, expectedDiff, slotError;
+  long long peerPhase;
 
   agent[agentNumber].received = YES;
 
@@ -163,19 +595,34 @@ int sync_ratdma(int agentNumber)
     return (1);
   }
 
+  // when the agent transmitted, in our clock, without the queueing delay of this frame
+  peerPhase = agent[agentNumber].receiveTime - agent[agentNumber].excessDelay;
+
   // real difference with average medium comm delay
-  realDiff = (int)((agent[agentNumber].receiveTimeStamp.tv_sec - lastSendTimeStamp.tv_sec)*1E6 + agent[agentNumber].receiveTimeStamp.tv_usec - lastSendTimeStamp.tv_usec);
+  realDiff = (int)(peerPhase - lastSendTime);
   realDiff -= (int)COMM_DELAY_US; // travel time
-  if (realDiff < 0)
-  {
-    PDEBUG("*****  realDiff to agent %d = %d  *****", agentNumber, realDiff);
-    return (2);
-  }
 
   // expected difference
   expectedDiff = (int)((agent[agentNumber].dynamicID - agent[myNumber].dynamicID) * TTUP_US / RUNNING_AGENTS);
   if (expectedDiff < 0)
     expectedDiff += (int)TTUP_US;
+
+  // slot error, in both modes, in ]-Ttup/2, Ttup/2]
+  slotError = (realDiff - expectedDiff) % (int)TTUP_US;
+  if (slotError > (int)TTUP_US / 2)
+    slotError -= (int)TTUP_US;
+  else if (slotError <= -(int)TTUP_US / 2)
+    slotError += (int)TTUP_US;
+  slot_stats(agentNumber, slotError);
+
+  if (!syncMode)
+    return (0);
+
+  if (realDiff < 0)
+  {
+    PDEBUG("*****  realDiff to agent %d = %d  *****", agentNumber, realDiff);
+    return (2);
+  }
 	
   agent[agentNumber].delta = realDiff - expectedDiff;
 
@@ -197,24 +644,11 @@ int sync_ratdma(int agentNumber)
     // only sync from dynamic agent 0
     if (agent[agentNumber].dynamicID == 0)
     {
+      // our slot, counted from its transmission
       expectedDiff = (int)(TTUP_US - expectedDiff);
-      expectedDiff -= (int)COMM_DELAY_US; // travel time
-      it.it_value.tv_usec = (long int)(expectedDiff % (int)1E6);
-      it.it_value.tv_sec = (long int)(expectedDiff / (int)1E6);
-      it.it_interval.tv_usec=(__suseconds_t)(TTUP_US);
-      it.it_interval.tv_sec=0;
-      setitimer (ITIMER_REAL, &it, NULL);
+      setTimer((long)(peerPhase - (long long)COMM_DELAY_US + expectedDiff - monotonicUs()));
     }
   }
-    
-//	PDEBUG("Delta [%d] = %d\trealDiff = %d\texpectedDiff = %d\t delay = %d", agentNumber, agent[agentNumber].delta, realDiff, expectedDiff, delay);
-
-//	for (i=0; i < agentNumber; i++)
-//		FDEBUG(filedebug, "\t");
-
-//  FDEBUG(filedebug, "%d\n", (int)(realDiff - COMM_DELAY));
-
-//			FDEBUG(filedebug, "Received from %1d->%1d(%4u)-->delay=%7d realDiff=%7d expectedDiff=%7d\n", agent[agentNumber].inFramePos, agentNumber, frameHeader.counter, agent[agentNumber].delta, realDiff, expectedDiff);
 
   return (0);
 }
@@ -283,148 +717,837 @@ void update_stateTable(void)
 
 
 // *************************
-//  Receive Thread
+//  Process a complete frame
 //
 //  Input:
-//    int *sckt = pointer of socket descriptor
+//    unsigned char *frame = frame received (header and records, wire.h)
+//    int frameLen = frame size
 //
-void *receiveDataThread(void *arg)
+void processFrame(unsigned char *frame, int frameLen)
 {
-  int recvLen;
-  char recvBuffer[BUFFER_SIZE];
   int indexBuffer;
   int agentNumber;
-  int i;
-	RTDBconf_var rec;
-	int life;
-	struct _frameHeader frameHeader;
+  int i, k, noRecs;
+	unsigned int id, life, len, counter, sendTime, hold;
+	int nEchoes, urgent, ch, timing;
+	unsigned char key;
+	unsigned char *base;
+	struct _wireKey *wk;
 
 	int size;
-	
 
-	while(!end)
+	if (frameLen < WIRE_HEADER_SIZE(MAX_AGENTS))
+		return;
+
+	agentNumber = frame[WIRE_AGENT];
+
+	// the frame only has room for MAX_AGENTS agents
+	if (agentNumber >= MAX_AGENTS)
+		return;
+
+	if ((frame[0] != WIRE_VERSION) || (wire_get_u32(frame + WIRE_HASH) != schemaHash))
 	{
-		bzero(recvBuffer, BUFFER_SIZE);
-		indexBuffer = 0;
+		if (schemaMismatch[agentNumber]++ == 0)
+			PERR("Frames from %d rejected: version %d, schema %08x (here: version %d, schema %08x)",
+				agentNumber, frame[0], wire_get_u32(frame + WIRE_HASH), WIRE_VERSION, schemaHash);
+		return;
+	}
 
-		if((recvLen = receiveData(*(int*)arg, recvBuffer, BUFFER_SIZE)) > 0 )
+	counter = wire_get_u32(frame + WIRE_COUNTER);
+	urgent = frame[WIRE_FLAGS] & WIRE_URGENT;
+	ch = frame[WIRE_FLAGS] >> WIRE_CHANNEL_SHIFT;
+	if ((ch >= nChannels) || (channel[ch].socket == -1))
+		return;
+
+	// only the periodic frames of the default channel keep the RA-TDMA and link statistics
+	timing = !urgent && (ch == 0);
+
+  // frames missing since the last one (unsigned, so it survives the counter wrap);
+  // older or repeated frames count nothing; urgent frames are out of this sequence
+	if (urgent)
+		;
+	else if ((channel[ch].lastFrame[agentNumber] != 0) &&
+		(counter - (channel[ch].lastFrame[agentNumber] + 1) < 0x80000000u))
+	{
+		if (ch == 0)
 		{
+			lostPackets[agentNumber] += counter - (channel[ch].lastFrame[agentNumber] + 1);
+			agent[agentNumber].cycleLost += counter - (channel[ch].lastFrame[agentNumber] + 1);
+		}
+		else
+			channel[ch].lost[agentNumber] += counter - (channel[ch].lastFrame[agentNumber] + 1);
+	}
+	if (!urgent)
+		channel[ch].lastFrame[agentNumber] = counter;
+
+	if (timing)
+	{
+		sendTime = wire_get_u32(frame + WIRE_TIME);
+		clock_offset(agentNumber, sendTime);
+		link_frame(agentNumber, sendTime, frameLen);
 
-			memcpy (&frameHeader, recvBuffer + indexBuffer, sizeof(frameHeader));
-			indexBuffer += sizeof(frameHeader);
+	  // state team view from received agent
+		for (i = 0; i < MAX_AGENTS; i++)
+			agent[agentNumber].stateTable[i] = (frame[WIRE_STATES + i / 4] >> (2 * (i % 4))) & 0x3;
+	}
 
-			agentNumber = frameHeader.number;
+	noRecs = wire_get_u16(frame + WIRE_RECORDS(MAX_AGENTS));
+	indexBuffer = WIRE_HEADER_SIZE(MAX_AGENTS);
 
-      gettimeofday(&(agent[agentNumber].receiveTimeStamp), NULL);
+	// echoes, ours gives the round trip time to this agent
+	if (indexBuffer == frameLen)
+		return;
+	nEchoes = frame[indexBuffer++];
+	for (i = 0; i < nEchoes; i++)
+	{
+		if ((frameLen - indexBuffer < 6) ||
+			((k = wire_get_varint(frame + indexBuffer + 5, frameLen - indexBuffer - 5, &hold)) == -1))
+			return;
+		if (frame[indexBuffer] == myNumber)
+		{
+			link_rtt(agentNumber, wire_get_u32(frame + indexBuffer + 1), hold);
+			key_ack(agentNumber, wire_get_u32(frame + indexBuffer + 1));
+		}
+		indexBuffer += 5 + k;
+	}
 
-      // receive from ourself
-      // not supposed to occur. just to prevent!
-  		if ((agentNumber == myNumber) && (nosend == 0))
-				continue;
+	for(i = 0; i < noRecs; i++)
+	{
+		// id
+		if ((k = wire_get_varint(frame + indexBuffer, frameLen - indexBuffer, &id)) == -1)
+			break;
+		indexBuffer += k;
 
-			// TODO
-      // correction when frameCounter overflows
-			if ((agent[agentNumber].lastFrameCounter + 1) != frameHeader.counter)
-				lostPackets[agentNumber] = frameHeader.counter - (agent[agentNumber].lastFrameCounter + 1);
-			agent[agentNumber].lastFrameCounter = frameHeader.counter;
+		// keyframe
+		if (indexBuffer == frameLen)
+			break;
+		key = frame[indexBuffer++];
 
-      // state team view from received agent
-			for (i = 0; i < MAX_AGENTS; i++)
-				agent[agentNumber].stateTable[i] = frameHeader.stateTable[i];
+		// life
+		if ((k = wire_get_varint(frame + indexBuffer, frameLen - indexBuffer, &life)) == -1)
+			break;
+		indexBuffer += k;
 
-			for(i = 0; i < frameHeader.noRecs; i++)
-			{
-				// id
-				memcpy (&rec.id, recvBuffer + indexBuffer, sizeof(rec.id));
-				indexBuffer += sizeof(rec.id);
+		// size
+		if (((k = wire_get_varint(frame + indexBuffer, frameLen - indexBuffer, &len)) == -1) ||
+			(len > MAX_FRAME_SIZE))
+			break;
+		indexBuffer += k;
+
+		// data, against the keyframe it was coded with (if we have it)
+		wk = (id < MAX_ITEMS) ? &recvKey[agentNumber][id] : NULL;
+		base = NULL;
+		if ((key & WIRE_DELTA) && (wk != NULL) && (wk->data != NULL) &&
+			(wk->seq == (key & WIRE_KEY_MASK)) && (wk->len == (int)len))
+			base = wk->data;
 
-				// size
-				memcpy (&rec.size, recvBuffer + indexBuffer, sizeof(rec.size));
-				indexBuffer += sizeof(rec.size);
+		if ((k = wire_decode(frame + indexBuffer, frameLen - indexBuffer, base, len, recvData)) == -1)
+			break;
+		indexBuffer += k;
 
-				// life
-				memcpy (&life, recvBuffer + indexBuffer, sizeof(life));
-				indexBuffer += sizeof(life);
+		if (wk == NULL)
+		{
+			PERR("Invalid item from %d: %u", agentNumber, id);
+			continue;
+		}
 
-        life += COMM_DELAY_MS;
+		if ((key & WIRE_DELTA) && (base == NULL))
+		{
+			// keyframe lost, wait for the next one
+			missingKeys[agentNumber] ++;
+			continue;
+		}
 
-				// data
-				if((size = DB_comm_put (agentNumber, rec.id, rec.size, recvBuffer + indexBuffer, life)) != (int)rec.size)
+		if ((key & WIRE_DELTA) == 0)
+		{
+			if ((wk->data == NULL) || (wk->len < (int)len))
+			{
+				free(wk->data);
+				if ((wk->data = (unsigned char*)malloc(len + 1)) == NULL)
 				{
-					PERR("Error in frame/rtdb: from = %d, item = %d, received size = %d, local size = %d", agentNumber, rec.id, rec.size, size);
-					break;
+					PERRNO("malloc");
+					continue;
 				}
-				PDEBUG("Receive from %d\n", agentNumber);
-
-				indexBuffer += rec.size;
 			}
+			memcpy(wk->data, recvData, len);
+			wk->len = len;
+			wk->seq = key & WIRE_KEY_MASK;
+		}
 
-#ifndef UNSYNC
-			sync_ratdma(agentNumber);
-#endif
+    life += COMM_DELAY_MS;
 
+		if((size = DB_comm_put (agentNumber, id, len, recvData, life)) != (int)len)
+		{
+			PERR("Error in frame/rtdb: from = %d, item = %u, received size = %u, local size = %d", agentNumber, id, len, size);
+			break;
 		}
+		PDEBUG("Receive from %d\n", agentNumber);
 	}
 
-	return NULL;
+	if (i < noRecs)
+		PERR("Truncated frame: from = %d, %d records missing", agentNumber, noRecs - i);
+
+	if (timing)
+		sync_ratdma(agentNumber);
 }
 
 
-void printUsage(void)
+
+// *************************
+//  Drop the frame being reassembled from an agent
+//    the fragments that did not arrive are counted as lost
+//
+void dropReassembly(struct _reassembly *reassembly, int agentNumber)
 {
-	printf("Usage: comm <interface_name> [nosend]\n\n");
-	printf("<interface_name> - eth0, wlan0, other\n");
-	printf("[nosend] - only receives data\n\n");
+	if (reassembly->nFragments == 0)
+		return;
+
+	lostFragments[agentNumber] += reassembly->nFragments - reassembly->received;
+	PDEBUG("frame %u from %d dropped, %d of %d fragments", reassembly->counter, agentNumber, reassembly->received, reassembly->nFragments);
+	reassembly->nFragments = 0;
 }
 
 
-//*************************
-//  Main
+
+// *************************
+//  Receive a datagram (a frame or one of its fragments)
 //
-int main(int argc, char *argv[])
+//  Input:
+//    char *recvBuffer = datagram
+//    int recvLen = datagram size
+//    long long stamp = time it arrived (monotonic, us)
+//
+void receiveFragment(char *recvBuffer, int recvLen, long long stamp)
 {
-	int sckt;
-	pthread_t recvThread;
-	char sendBuffer[BUFFER_SIZE];
-	int indexBuffer;
-	int sharedRecs;
-	RTDBconf_var rec[MAX_RECS];
-	unsigned int frameCounter = 0;
-	int i, j;
-	int life;
+  int agentNumber;
+  int i, c, dataLen;
+	struct _fragmentHeader fragmentHeader;
+	struct _reassembly *r;
 
-	struct sched_param proc_sched;
-	pthread_attr_t thread_attr;
+	if (recvLen < (int)sizeof(fragmentHeader))
+		return;
 
-	struct itimerval it;
-	struct _frameHeader frameHeader;
+	memcpy (&fragmentHeader, recvBuffer, sizeof(fragmentHeader));
+	dataLen = recvLen - sizeof(fragmentHeader);
 
-	struct timeval tempTimeStamp;
+	agentNumber = fragmentHeader.number;
 
-  nosend = 0;
-	if ((argc < 2) || (argc > 3))
+	// the frame only has room for MAX_AGENTS agents
+	if ((agentNumber < 0) || (agentNumber >= MAX_AGENTS))
+		return;
+
+	agent[agentNumber].receiveTime = stamp;
+
+  // receive from ourself
+  // not supposed to occur. just to prevent!
+	if ((agentNumber == myNumber) && (nosend == 0))
+		return;
+
+	// frames that will not be completed anymore
+	for (c = 0; c < nChannels; c++)
+		for (i = 0; i < MAX_AGENTS; i++)
+			if ((reassembly[c][i].nFragments != 0) &&
+				(stamp - reassembly[c][i].time > FRAGMENT_TIMEOUT_US))
+				dropReassembly(&reassembly[c][i], i);
+
+	// single datagram frame, no copy
+	if (fragmentHeader.nFragments == 1)
 	{
-		printUsage();
-		return (-1);
+		processFrame((unsigned char*)recvBuffer + sizeof(fragmentHeader), dataLen);
+		return;
 	}
-	if (argc == 3)
+
+	if ((fragmentHeader.channel >= nChannels) || (reassembly[fragmentHeader.channel][agentNumber].buffer == NULL) ||
+		(fragmentHeader.nFragments == 0) || (fragmentHeader.nFragments > MAX_FRAGMENTS) ||
+		(fragmentHeader.fragment >= fragmentHeader.nFragments) ||
+		((fragmentHeader.fragment < fragmentHeader.nFragments - 1) && (dataLen != FRAGMENT_DATA)))
 	{
-		if(strcmp(argv[2], "nosend") == 0)
-		{
-			printf("\n*** Running in listing only mode ***\n\n");
-			nosend = 1;
-		}
-		else
-		{
-			printUsage();
+		PERR("Invalid fragment %d/%d from %d", fragmentHeader.fragment, fragmentHeader.nFragments, agentNumber);
+		return;
+	}
+
+	r = &reassembly[fragmentHeader.channel][agentNumber];
+
+	// a newer frame, the previous one is incomplete
+	if ((r->nFragments != 0) && (r->counter != wire_get_u32(fragmentHeader.counter)))
+		dropReassembly(r, agentNumber);
+
+	if (r->nFragments == 0)
+	{
+		r->counter = wire_get_u32(fragmentHeader.counter);
+		r->nFragments = fragmentHeader.nFragments;
+		r->received = 0;
+		r->mask = 0;
+		r->size = 0;
+		r->time = stamp;
+	}
+
+	// duplicated
+	if (r->mask & (1ULL << fragmentHeader.fragment))
+		return;
+
+	memcpy(r->buffer + fragmentHeader.fragment * FRAGMENT_DATA, recvBuffer + sizeof(fragmentHeader), dataLen);
+	r->mask |= 1ULL << fragmentHeader.fragment;
+	r->received ++;
+	if (fragmentHeader.fragment == fragmentHeader.nFragments - 1)
+		r->size = fragmentHeader.fragment * FRAGMENT_DATA + dataLen;
+
+	if (r->received == r->nFragments)
+	{
+		r->nFragments = 0;
+		processFrame((unsigned char*)r->buffer, r->size);
+	}
+}
+
+
+
+// *************************
+//  Send a frame, in as many datagrams as needed
+//
+//  Input:
+//    int sckt = socket descriptor
+//    char *frame = frame (header and records)
+//    int frameLen = frame size
+//    unsigned int counter = frame counter
+//    int ch = channel
+//  Output:
+//    0 = OK
+//    -1 = error
+//
+int sendFrame(int sckt, char *frame, int frameLen, unsigned int counter, int ch)
+{
+	char fragment[BUFFER_SIZE];
+	struct _fragmentHeader fragmentHeader;
+	int offset, len;
+	int ret = 0;
+
+	fragmentHeader.number = myNumber;
+	fragmentHeader.nFragments = (frameLen + FRAGMENT_DATA - 1) / FRAGMENT_DATA;
+	fragmentHeader.channel = ch;
+	wire_put_u32(fragmentHeader.counter, counter);
+
+	for (fragmentHeader.fragment = 0, offset = 0; offset < frameLen; fragmentHeader.fragment++, offset += len)
+	{
+		len = (frameLen - offset < FRAGMENT_DATA) ? frameLen - offset : FRAGMENT_DATA;
+		memcpy(fragment, &fragmentHeader, sizeof(fragmentHeader));
+		memcpy(fragment + sizeof(fragmentHeader), frame + offset, len);
+		if (sendData(sckt, fragment, sizeof(fragmentHeader) + len) != (int)sizeof(fragmentHeader) + len)
+			ret = -1;
+	}
+
+	return ret;
+}
+
+
+// *************************
+//  Code a record (wire.h)
+//
+//  Input:
+//    unsigned char *buf = where to write
+//    int max = bytes available
+//    int id = record id
+//    unsigned char key = keyframe sequence, with WIRE_DELTA if coded against it
+//    int life = record life
+//    unsigned char *data = record data
+//    unsigned char *base = keyframe (NULL when sending a keyframe)
+//    int len = record bytes in use
+//  Output:
+//    bytes used
+//    -1 = does not fit
+//
+int encodeRecord(unsigned char *buf, int max, int id, unsigned char key, int life, unsigned char *data, unsigned char *base, int len)
+{
+	int n, k;
+
+	if ((n = wire_put_varint(buf, max, id)) == -1)
+		return -1;
+
+	if (n == max)
+		return -1;
+	buf[n++] = key;
+
+	if ((k = wire_put_varint(buf + n, max - n, (life < 0) ? 0 : life)) == -1)
+		return -1;
+	n += k;
+
+	if ((k = wire_put_varint(buf + n, max - n, len)) == -1)
+		return -1;
+	n += k;
+
+	if ((k = wire_encode(data, base, len, buf + n, max - n)) == -1)
+		return -1;
+
+	return n + k;
+}
+
+
+
+// *************************
+//  Start a frame: echoes, and room for the header (endFrame)
+//
+//  Input:
+//    unsigned char *buf = frame
+//    long long now = send time
+//    int echoes = with the echoes (only the default channel has them)
+//  Output:
+//    bytes used
+//
+int beginFrame(unsigned char *buf, long long now, int echoes)
+{
+	int indexBuffer, i, n;
+
+	bzero(buf, WIRE_HEADER_SIZE(MAX_AGENTS));
+	indexBuffer = WIRE_HEADER_SIZE(MAX_AGENTS) + 1;
+
+	// echo the last frame of each agent heard in the last cycles
+	n = 0;
+	for (i = 0; echoes && (i < MAX_AGENTS); i++)
+	{
+		if ((i == myNumber) || (agent[i].frameTime == 0) || (now - agent[i].frameTime > 2 * TTUP_US))
+			continue;
+		buf[indexBuffer] = i;
+		wire_put_u32(buf + indexBuffer + 1, agent[i].frameSendTime);
+		indexBuffer += 5 + wire_put_varint(buf + indexBuffer + 5, WIRE_ECHO_MAX - 5, (unsigned int)(now - agent[i].frameTime));
+		n ++;
+	}
+	buf[WIRE_HEADER_SIZE(MAX_AGENTS)] = n;
+
+	return indexBuffer;
+}
+
+
+
+// *************************
+//  Frame header
+//
+//  Input:
+//    unsigned char *buf = frame
+//    unsigned char flags = WIRE_URGENT, ...
+//    unsigned int counter = frame counter
+//    long long now = send time (as in beginFrame)
+//    int nRecs = records in the frame
+//
+void endFrame(unsigned char *buf, unsigned char flags, unsigned int counter, long long now, int nRecs)
+{
+	int i;
+
+	buf[0] = WIRE_VERSION;
+	wire_put_u32(buf + WIRE_HASH, schemaHash);
+	buf[WIRE_AGENT] = myNumber;
+	wire_put_u32(buf + WIRE_COUNTER, counter);
+	wire_put_u32(buf + WIRE_TIME, (unsigned int)now);
+	buf[WIRE_FLAGS] = flags;
+	for (i = 0; i < MAX_AGENTS; i++)
+		buf[WIRE_STATES + i / 4] |= (agent[myNumber].stateTable[i] & 0x3) << (2 * (i % 4));
+	wire_put_u16(buf + WIRE_RECORDS(MAX_AGENTS), nRecs);
+}
+
+
+
+// *************************
+//  Read a shared record and code it in the frame
+//
+//  Input:
+//    int id = record id
+//    struct _wireKey *wk = keyframe sent of the record
+//    unsigned char *recData = room for the record
+//    unsigned char *buf = where to code it
+//    int max = bytes available
+//    unsigned int sendTime = frame send time (as in endFrame)
+//    int echoed = the record is on the default channel, its periodic frames are echoed
+//  Output:
+//    bytes used
+//    -1 = does not fit
+//
+int packRecord(int id, struct _wireKey *wk, unsigned char *recData, unsigned char *buf, int max, unsigned int sendTime, int echoed)
+{
+	int life, len, delta, n;
+	unsigned char key;
+
+	if ((life = DB_comm_get(id, recData, &len)) == -1)
+	{
+		life = 0;
+		len = 0;
+	}
+
+	// coded against the last keyframe, so receivers that lost the frames in
+	// between still decode it; a new keyframe every WIRE_KEY_PERIOD frames.
+	// On the default channel the echoes are the acks: only a keyframe every
+	// running peer echoed is used, until then (a keyframe lost) it is sent
+	// again; without echoes the keyframes come more often as the loss grows
+	if (echoed)
+		delta = (wk->sent > 0) && (wk->sent < WIRE_KEY_PERIOD) && (wk->len == len) &&
+			((key_peers() & ~wk->acked) == 0);
+	else
+		delta = (wk->sent > 0) && (wk->sent < key_period()) && (wk->len == len);
+	key = delta ? (wk->seq | WIRE_DELTA) : ((wk->seq + 1) & WIRE_KEY_MASK);
+
+	if ((n = encodeRecord(buf, max, id, key, life, recData, delta ? wk->data : NULL, len)) == -1)
+		return -1;
+
+	if (delta)
+		wk->sent ++;
+	else
+	{
+		memcpy(wk->data, recData, len);
+		wk->len = len;
+		wk->seq = key;
+		wk->sent = 1;
+		wk->keyTime = sendTime;
+		wk->acked = 0;
+	}
+
+	return n;
+}
+
+
+
+// *************************
+//  Time until an urgent frame may be sent
+//
+//  Input:
+//    long long now = current time
+//    long long lastTx = last transmission (periodic or urgent)
+//    int tokens = urgent frames left in this cycle
+//  Output:
+//    us to wait (0 = send now)
+//    -1 = wait for the next periodic frame
+//
+long urgentWait(long long now, long long lastTx, int tokens)
+{
+	long wait = 0;
+	long phase, slot, start;
+	int k;
+
+	if (tokens <= 0)
+		return -1;
+
+	if (now - lastTx < URGENT_GAP_US)
+		wait = (long)(lastTx + URGENT_GAP_US - now);
+
+	// keep clear of the start of every slot, where the periodic frames are
+	if (syncMode && (RUNNING_AGENTS > 1))
+	{
+		slot = (long)(TTUP_US / RUNNING_AGENTS);
+		phase = (long)((now + wait - lastSendTime) % (long long)TTUP_US);
+		for (k = 0; k <= RUNNING_AGENTS; k++)
+		{
+			start = k * slot;
+			if ((phase >= start - (long)URGENT_GUARD_US) && (phase < start + (long)URGENT_BUSY_US))
+			{
+				wait += start + (long)URGENT_BUSY_US - phase;
+				break;
+			}
+		}
+	}
+
+	return wait;
+}
+
+
+
+// *************************
+//  Records of a channel due in its next frame, earliest deadline first
+//  (shortest period on ties), as many as fit; the others are late and go
+//  first in the next frames
+//
+//  Input:
+//    struct _channel *ch = channel (its records and frame counter)
+//    unsigned char *buf = frame, started with beginFrame
+//    int indexBuffer = bytes used
+//    unsigned int sendTime = frame send time (as in endFrame)
+//    int *nRecs = records packed
+//  Output:
+//    bytes used
+//
+int packDue(struct _channel *ch, unsigned char *buf, int indexBuffer, unsigned int sendTime, int *nRecs)
+{
+	int i, j, k, n, nDue;
+	unsigned int frameCounter = ch->counter;
+
+	nDue = 0;
+	for (i = ch->first; i < ch->first + ch->n; i++)
+	{
+		if ((sched[i].next > frameCounter) && !urgentPending[i])
+			continue;
+		for (k = nDue; (k > 0) && ((sched[order[k-1]].next > sched[i].next) ||
+				((sched[order[k-1]].next == sched[i].next) && (sched[order[k-1]].period > sched[i].period))); k--)
+			order[k] = order[k-1];
+		order[k] = i;
+		nDue ++;
+	}
+
+	*nRecs = 0;
+	for (j = 0; j < nDue; j++)
+	{
+		i = order[j];
+
+		if ((n = packRecord(rec[i].id, &sendKey[i], recData, buf + indexBuffer, MAX_FRAME_SIZE - indexBuffer, sendTime, ch == &channel[0])) == -1)
+		{
+			PDEBUG("record %d delayed, frame %u of channel %d is full", rec[i].id, frameCounter, ch->number);
+			continue;
+		}
+		indexBuffer += n;
+		(*nRecs) ++;
+		urgentPending[i] = 0;
+
+		// keep the phase, unless it is more than a period late
+		sched[i].next += sched[i].period;
+		if (sched[i].next <= frameCounter)
+			sched[i].next = frameCounter + 1;
+	}
+
+	return indexBuffer;
+}
+
+
+
+// *************************
+//  Join the channels of rtdb.ini and sort our shared records by channel
+//    the default one (0) is always joined, on sckt; with a list, only the
+//    channels in it are joined, the others are not sent nor received
+//
+//  Input:
+//    char *interface = network interface
+//    int sckt = socket of the default channel
+//    char *list = channels to join, "1,3" (NULL = all)
+//    int sharedRecs = number of shared records
+//  Output:
+//    0 = OK
+//    -1 = error
+//
+int channels_init(char *interface, int sckt, char *list, int sharedRecs)
+{
+	RTDBchannel conf[MAX_CHANNELS];
+	RTDBconf_var tmp;
+	char *p;
+	int nConf, i, j, k, join;
+
+	if ((nConf = DB_comm_channels(conf, MAX_CHANNELS)) == -1)
+	{
+		PERR("DB_comm_channels");
+		return -1;
+	}
+
+	nChannels = 1;
+	channel[0].number = 0;
+	channel[0].socket = sckt;
+	channel[0].period = 1;
+	for (i = 0; i < nConf; i++)
+	{
+		// numbered from 1, in order (rtdb.ini)
+		if (conf[i].number != nChannels)
+		{
+			PERR("Channel %d (%s) out of order in rtdb.ini", conf[i].number, conf[i].name);
+			return -1;
+		}
+		channel[nChannels].number = conf[i].number;
+		channel[nChannels].socket = -1;
+		channel[nChannels].period = (conf[i].period < 1) ? 1 : conf[i].period;
+
+		join = (list == NULL);
+		for (p = list; (p != NULL) && !join; p = strchr(p, ','))
+		{
+			if (*p == ',')
+				p ++;
+			join = (atoi(p) == conf[i].number);
+		}
+		if (join)
+		{
+			if ((channel[nChannels].socket = openSocketGroup(interface, conf[i].group, conf[i].port, conf[i].ttl)) == -1)
+			{
+				PERR("Channel %d (%s): openSocketGroup %s:%d", conf[i].number, conf[i].name, conf[i].group, conf[i].port);
+				return -1;
+			}
+			printf("communication: channel %d (%s) on %s:%d, period %d\n", conf[i].number, conf[i].name,
+				conf[i].group, conf[i].port, channel[nChannels].period);
+		}
+		nChannels ++;
+	}
+
+	// records of unknown channels go with the default one
+	for (i = 0; i < sharedRecs; i++)
+		if ((rec[i].channel < 0) || (rec[i].channel >= nChannels))
+		{
+			PERR("Record %d: channel %d not in rtdb.ini, sent on channel 0", rec[i].id, rec[i].channel);
+			rec[i].channel = 0;
+		}
+
+	// sorted by channel (stable, the order of rtdb.ini is kept within each one)
+	for (i = 1; i < sharedRecs; i++)
+	{
+		tmp = rec[i];
+		for (j = i; (j > 0) && (rec[j-1].channel > tmp.channel); j--)
+			rec[j] = rec[j-1];
+		rec[j] = tmp;
+	}
+
+	for (k = 0, i = 0; k < nChannels; k++)
+	{
+		channel[k].first = i;
+		for (; (i < sharedRecs) && (rec[i].channel == k); i++)
+			;
+		channel[k].n = i - channel[k].first;
+		channel[k].counter = 1;
+		for (j = 0; j < MAX_AGENTS; j++)
+		{
+			channel[k].lastFrame[j] = 0;
+			channel[k].lost[j] = 0;
+		}
+
+		if ((channel[k].n > 0) && (channel[k].socket == -1))
+			PERR("Channel %d not joined, its %d records are not sent", channel[k].number, channel[k].n);
+	}
+
+	return 0;
+}
+
+
+
+// *************************
+//  schedule_init: first frame of each shared record
+//    records are placed, largest first, in the frames of their period with
+//    less bytes already scheduled, so slow records are spread over the frames
+//    instead of all being sent together
+//
+//  Input:
+//    RTDBconf_var *rec = shared records
+//    struct _schedule *sched = schedule of each record
+//    int n = number of shared records
+//
+void schedule_init(RTDBconf_var *rec, struct _schedule *sched, int n)
+{
+  int load[MAX_HYPERPERIOD];
+  int hyper = 1;
+  int i, j, k, f;
+  int a, b, worst, best, bestWorst;
+
+  for (i = 0; i < n; i++)
+  {
+    sched[i].period = (rec[i].period < 1) ? 1 : rec[i].period;
+    sched[i].next = 0;
+
+    // lcm of the periods, frames repeat after it
+    for (a = hyper, b = sched[i].period; b != 0; k = a % b, a = b, b = k)
+      ;
+    if (hyper / a * sched[i].period <= MAX_HYPERPERIOD)
+      hyper = hyper / a * sched[i].period;
+  }
+
+  for (f = 0; f < hyper; f++)
+    load[f] = 0;
+
+  for (j = 0; j < n; j++)
+  {
+    // largest record not placed yet
+    k = -1;
+    for (i = 0; i < n; i++)
+      if ((sched[i].next == 0) && ((k == -1) || (rec[i].size > rec[k].size)))
+        k = i;
+
+    best = 0;
+    bestWorst = -1;
+    for (i = 0; i < sched[k].period; i++)
+    {
+      worst = 0;
+      for (f = i; f < hyper; f += sched[k].period)
+        if (load[f] > worst)
+          worst = load[f];
+      if ((bestWorst == -1) || (worst < bestWorst))
+      {
+        bestWorst = worst;
+        best = i;
+      }
+    }
+
+    for (f = best; f < hyper; f += sched[k].period)
+      load[f] += rec[k].size;
+
+    // 0 marks the records still to place, frames are counted from 1
+    sched[k].next = best + 1;
+
+    PDEBUG("record %d: size %d, period %d, first frame %u", rec[k].id, rec[k].size, sched[k].period, sched[k].next);
+  }
+}
+
+
+
+void printUsage(void)
+{
+	printf("Usage: comm <interface_name> [nosend] [sync] [channels=1,2]\n\n");
+	printf("<interface_name> - eth0, wlan0, other\n");
+	printf("[nosend] - only receives data\n");
+	printf("[sync] - RA-TDMA, each agent transmits in its own slot\n");
+	printf("[channels=1,2] - only joins these channels of rtdb.ini (0 is always joined)\n\n");
+	printf("kill -USR1 prints the slot error of each agent\n\n");
+}
+
+
+//*************************
+//  Main
+//
+int main(int argc, char *argv[])
+{
+	int sckt;
+	int epollFd;
+	struct epoll_event event, events[3 + MAX_CHANNELS];
+	char recvBuffers[RECV_BATCH][BUFFER_SIZE];
+	int recvLengths[RECV_BATCH];
+	struct timeval recvStamps[RECV_BATCH];
+	uint64_t expirations;
+	unsigned int timer;
+	int nEvents, nRecv;
+	unsigned char *sendBuffer;
+	char *channelList = NULL;
+	int urgentFd, urgentTimerFd, urgentId, urgentTokens, nUrgent;
+	unsigned int urgentCounter = 1;
+	long long lastTxTime = 0;
+	long urgentDelay;
+	struct itimerspec urgentTimer;
+	int urgentFrames = 0, urgentDeferred = 0;
+	int pmanAttached = 0;
+	int n;
+	int indexBuffer;
+	int maxSize;
+	int sharedRecs;
+	int nRecs;
+	int i, j, k, c;
+
+	struct sched_param proc_sched;
+
+
+	struct timeval realNow;
+	long long monoNow;
+
+  nosend = 0;
+  syncMode = 0;
+	if ((argc < 2) || (argc > 5))
+	{
+		printUsage();
+		return (-1);
+	}
+	for (i = 2; i < argc; i++)
+	{
+		if(strcmp(argv[i], "nosend") == 0)
+		{
+			printf("\n*** Running in listing only mode ***\n\n");
+			nosend = 1;
+		}
+		else if(strcmp(argv[i], "sync") == 0)
+			syncMode = 1;
+		else if(strncmp(argv[i], "channels=", 9) == 0)
+			channelList = argv[i] + 9;
+		else
+		{
+			printUsage();
 			return (-1);
 		}
 	}
 
 	/* initializations */
 	delay = 0;
-	timer = 0;
-	end = 0;
+	quit = 0;
+	dumpStats = 0;
 	RUNNING_AGENTS = 1;
 
 	/* Assign a real-time priority to process */
@@ -435,13 +1558,13 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
-	if(signal(SIGALRM, signal_catch) == SIG_ERR)
+	if(signal(SIGINT, signal_catch) == SIG_ERR)
 	{
 		PERRNO("signal");
 		return -1;
 	}
 
-	if(signal(SIGINT, signal_catch) == SIG_ERR)
+	if(signal(SIGUSR1, signal_catch) == SIG_ERR)
 	{
 		PERRNO("signal");
 		return -1;
@@ -460,10 +1583,85 @@ int main(int argc, char *argv[])
 		closeSocket(sckt);
 		return -1;
 	}
+
+	/* with a process table, the scheduling and the cores of comm come from its pman.conf entry */
+	if ((getenv("AGENT") != NULL) && (PMAN_init(SHMEM_OCAM_PMAN_KEY, SEM_OCAM_PMAN_KEY, NULL, 0, PMAN_ATTACH) == 0))
+	{
+		if (PMAN_attach((char*)"comm", getpid()) == 0)
+			pmanAttached = 1;
+		else
+			PMAN_close(PMAN_CLLEAVE);
+	}
+	printf("communication: %s\n", pmanAttached ? "QoS from the pman process table" : "no pman entry, SCHED_FIFO 60");
 	
-	if((sharedRecs = DB_comm_ini(rec)) < 1)
+	if(((sharedRecs = DB_comm_ini(NULL)) < 1) ||
+		((rec = (RTDBconf_var*)malloc(sharedRecs * sizeof(RTDBconf_var))) == NULL) ||
+		(DB_comm_ini(rec) != sharedRecs))
 	{
 		PERR("DB_comm_ini");
+		free(rec);
+		DB_free();
+		closeSocket(sckt);
+		return -1;
+	}
+
+	if (((sched = (struct _schedule*)malloc(sharedRecs * sizeof(struct _schedule))) == NULL) ||
+		((order = (int*)malloc(sharedRecs * sizeof(int))) == NULL))
+	{
+		PERRNO("malloc");
+		free(sched);
+		free(rec);
+		DB_free();
+		closeSocket(sckt);
+		return -1;
+	}
+
+	if (channels_init(argv[1], sckt, channelList, sharedRecs) == -1)
+	{
+		for (c = 1; c < nChannels; c++)
+			if (channel[c].socket != -1)
+				closeSocket(channel[c].socket);
+		free(order);
+		free(sched);
+		free(rec);
+		DB_free();
+		closeSocket(sckt);
+		return -1;
+	}
+
+	// each channel has its own frames
+	for (c = 0; c < nChannels; c++)
+		schedule_init(rec + channel[c].first, sched + channel[c].first, channel[c].n);
+
+	maxSize = 0;
+	for (i = 0; i < sharedRecs; i++)
+	{
+		if (WIRE_HEADER_SIZE(MAX_AGENTS) + 1 + MAX_AGENTS * WIRE_ECHO_MAX + WIRE_RECORD_MAX(rec[i].size) > MAX_FRAME_SIZE)
+			PERR("Record %d (%d bytes) may not fit in the frame", rec[i].id, rec[i].size);
+		if (rec[i].size > maxSize)
+			maxSize = rec[i].size;
+	}
+
+	if ((schemaHash = DB_comm_schema()) == 0)
+	{
+		PERR("DB_comm_schema");
+		DB_free();
+		closeSocket(sckt);
+		return -1;
+	}
+
+	// frame being coded, a record read from the RTDB, and the keyframes sent (one per record)
+	sendBuffer = (unsigned char*)malloc(MAX_FRAME_SIZE);
+	recData = (unsigned char*)malloc(maxSize + 1);
+	recvData = (unsigned char*)malloc(MAX_FRAME_SIZE);
+	n = 0;
+	urgentPending = (char*)calloc(sharedRecs, 1);
+	if ((sendKey = (struct _wireKey*)calloc(sharedRecs, sizeof(struct _wireKey))) != NULL)
+		for (n = 0; (n < sharedRecs) && ((sendKey[n].data = (unsigned char*)malloc(rec[n].size + 1)) != NULL); n++)
+			;
+	if ((sendBuffer == NULL) || (recData == NULL) || (recvData == NULL) || (urgentPending == NULL) || (n < sharedRecs))
+	{
+		PERRNO("malloc");
 		DB_free();
 		closeSocket(sckt);
 		return -1;
@@ -483,66 +1681,246 @@ int main(int argc, char *argv[])
 	for (i=0; i<MAX_AGENTS; i++)
 	{
 		lostPackets[i]=0;
-		agent[i].lastFrameCounter = 0;
+		lostFragments[i]=0;
+		schemaMismatch[i]=0;
+		missingKeys[i]=0;
+		agent[i].offsetValid = 0;
+		agent[i].windowSamples = 0;
+		agent[i].excessDelay = 0;
+		agent[i].frameTime = 0;
+		agent[i].jitter = 0;
+		agent[i].rtt = -1;
+		agent[i].frameSize = 0;
+		agent[i].cycleFrames = 0;
+		agent[i].cycleLost = 0;
+		agent[i].cycleBytes = 0;
+		agent[i].lossRate = 0;
+		agent[i].bytesPerCycle = 0;
 		agent[i].state = NOT_RUNNING;
 		agent[i].removeCounter = 0;
 	}
 	myNumber = Whoami();
+	if ((myNumber < 0) || (myNumber >= MAX_AGENTS))
+	{
+		PERR("Agent %d does not fit in the frame (MAX_AGENTS = %d)", myNumber, MAX_AGENTS);
+		free(sendBuffer);
+		free(rec);
+		DB_free();
+		closeSocket(sckt);
+		return -1;
+	}
 	agent[myNumber].state = RUNNING;
 
-	/* receive thread */
-	pthread_attr_init (&thread_attr);
-	pthread_attr_setinheritsched (&thread_attr, PTHREAD_INHERIT_SCHED);
-	if ((pthread_create(&recvThread, &thread_attr, receiveDataThread, (void *)&sckt)) != 0)
+	// only the channels joined are reassembled
+	for (c = 0; c < MAX_CHANNELS; c++)
+		for (i = 0; i < MAX_AGENTS; i++)
+		{
+			reassembly[c][i].nFragments = 0;
+			reassembly[c][i].buffer = NULL;
+			if ((c < nChannels) && (channel[c].socket != -1) &&
+				((reassembly[c][i].buffer = (char*)malloc(MAX_FRAME_SIZE)) == NULL))
+			{
+				PERRNO("malloc");
+				DB_free();
+				closeSocket(sckt);
+				return -1;
+			}
+		}
+
+	/* one thread waits for both the transmission timer and the socket */
+	if ((timerFd = timerfd_create(CLOCK_MONOTONIC, 0)) == -1)
 	{
-		PERRNO("pthread_create");
+		PERRNO("timerfd_create");
 		DB_free();
 		closeSocket(sckt);
 		return -1;
 	}
 
-	/* Set itimer to reactivate the program */
-	it.it_value.tv_usec=(__suseconds_t)(TTUP_US);
-	it.it_value.tv_sec=0;
-	it.it_interval.tv_usec=(__suseconds_t)(TTUP_US);
-	it.it_interval.tv_sec=0;
-	setitimer (ITIMER_REAL, &it, NULL);
+	if ((urgentTimerFd = timerfd_create(CLOCK_MONOTONIC, 0)) == -1)
+	{
+		PERRNO("timerfd_create");
+		DB_free();
+		closeSocket(sckt);
+		return -1;
+	}
 
-	printf("communication: STARTED in ");
-#ifdef UNSYNC
-	printf("unsync mode...\n");
-#else
-	printf("sync mode...\n");
-#endif 
+	// without it, urgent records wait for their period
+	if ((urgentFd = DB_comm_urgent()) == -1)
+		PERR("DB_comm_urgent, urgent records disabled");
+
+	if ((epollFd = epoll_create(3 + MAX_CHANNELS)) == -1)
+	{
+		PERRNO("epoll_create");
+		DB_free();
+		closeSocket(sckt);
+		return -1;
+	}
+	event.events = EPOLLIN;
+	for (c = 0; c < nChannels; c++)
+	{
+		event.data.fd = channel[c].socket;
+		if ((channel[c].socket != -1) && (epoll_ctl(epollFd, EPOLL_CTL_ADD, channel[c].socket, &event) == -1))
+		{
+			PERRNO("epoll_ctl");
+			DB_free();
+			closeSocket(sckt);
+			return -1;
+		}
+	}
+	event.data.fd = timerFd;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event) == -1)
+	{
+		PERRNO("epoll_ctl");
+		DB_free();
+		closeSocket(sckt);
+		return -1;
+	}
+	event.data.fd = urgentTimerFd;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, urgentTimerFd, &event) == -1)
+	{
+		PERRNO("epoll_ctl");
+		DB_free();
+		closeSocket(sckt);
+		return -1;
+	}
+	event.data.fd = urgentFd;
+	if ((urgentFd != -1) && (epoll_ctl(epollFd, EPOLL_CTL_ADD, urgentFd, &event) == -1))
+	{
+		PERRNO("epoll_ctl");
+		DB_free();
+		closeSocket(sckt);
+		return -1;
+	}
+	urgentTokens = URGENT_PER_CYCLE;
+
+	setTimer((long)TTUP_US);
+
+	printf("communication: STARTED in %s mode...\n", syncMode ? "sync" : "unsync");
 
 
-	MTRand randomGenerator;
-	while (!end)
+	while (!quit)
 	{
-		//pause();
-		double waitTime = randomGenerator.randNorm(0,1) * TTUP_US * 0.05 + TTUP_US;
-		usleep(waitTime);
+		if ((nEvents = epoll_wait(epollFd, events, 3 + MAX_CHANNELS, -1)) == -1)
+		{
+			if (errno != EINTR)
+				PERRNO("epoll_wait");
+			if (dumpStats)
+			{
+				print_stats();
+				dumpStats = 0;
+			}
+			continue;
+		}
+
+		timer = 0;
+		for (k = 0; k < nEvents; k++)
+		{
+			if (events[k].data.fd == timerFd)
+			{
+				if (read(timerFd, &expirations, sizeof(expirations)) == (int)sizeof(expirations))
+					timer = expirations;
+				continue;
+			}
+
+			// urgent records, sent below
+			if (events[k].data.fd == urgentTimerFd)
+			{
+				if (read(urgentTimerFd, &expirations, sizeof(expirations)) == -1)
+					PERRNO("read");
+				continue;
+			}
+			if (events[k].data.fd == urgentFd)
+			{
+				while (recv(urgentFd, &urgentId, sizeof(urgentId), 0) == (int)sizeof(urgentId))
+				{
+					for (i = 0; (i < sharedRecs) && (rec[i].id != urgentId); i++)
+						;
+					if (i < sharedRecs)
+						urgentPending[i] = 1;
+					else
+					{
+						PDEBUG("urgent record %d is not shared", urgentId);
+					}
+				}
+				continue;
+			}
+
+			// everything queued, RECV_BATCH datagrams at a time
+			do
+			{
+				if ((nRecv = receiveDataBatch(events[k].data.fd, recvBuffers[0], BUFFER_SIZE, recvLengths, recvStamps, RECV_BATCH)) == -1)
+					PERRNO("receiveDataBatch");
+
+				// kernel time stamps are wall clock, moved to the monotonic clock by their age
+				gettimeofday(&realNow, NULL);
+				monoNow = monotonicUs();
+				for (j = 0; j < nRecv; j++)
+					receiveFragment(recvBuffers[j], recvLengths[j], monoNow -
+						((long long)(realNow.tv_sec - recvStamps[j].tv_sec) * 1000000 + realNow.tv_usec - recvStamps[j].tv_usec));
+			} while (nRecv == RECV_BATCH);
+		}
+
+		// urgent records, in a frame of their own (per channel) if allowed now
+		for (i = 0, nUrgent = 0; i < sharedRecs; i++)
+			nUrgent += urgentPending[i] && (channel[rec[i].channel].socket != -1);
+		if ((nUrgent > 0) && (timer == 0) && (nosend == 0))
+		{
+			monoNow = monotonicUs();
+			if ((urgentDelay = urgentWait(monoNow, lastTxTime, urgentTokens)) > 0)
+			{
+				urgentTimer.it_value.tv_sec = urgentDelay / 1000000;
+				urgentTimer.it_value.tv_nsec = (urgentDelay % 1000000) * 1000;
+				urgentTimer.it_interval.tv_sec = 0;
+				urgentTimer.it_interval.tv_nsec = 0;
+				if (timerfd_settime(urgentTimerFd, 0, &urgentTimer, NULL) == -1)
+					PERRNO("timerfd_settime");
+				urgentDeferred ++;
+			}
+			else if (urgentDelay == 0)
+			{
+				for (c = 0; c < nChannels; c++)
+				{
+					if (channel[c].socket == -1)
+						continue;
+					indexBuffer = beginFrame(sendBuffer, monoNow, c == 0);
+					nRecs = 0;
+					for (i = channel[c].first; i < channel[c].first + channel[c].n; i++)
+					{
+						if (!urgentPending[i])
+							continue;
+						if ((n = packRecord(rec[i].id, &sendKey[i], recData, sendBuffer + indexBuffer, MAX_FRAME_SIZE - indexBuffer, (unsigned int)monoNow, c == 0)) == -1)
+							break;
+						indexBuffer += n;
+						nRecs ++;
+						urgentPending[i] = 0;
+					}
+					if (nRecs == 0)
+						continue;
+					endFrame(sendBuffer, WIRE_URGENT | (c << WIRE_CHANNEL_SHIFT), urgentCounter, monoNow, nRecs);
+
+					// fragments of urgent frames do not mix with the periodic ones
+					if (sendFrame(channel[c].socket, (char*)sendBuffer, indexBuffer, urgentCounter | 0x80000000u, c) == -1)
+						PERRNO("Error sending data");
+					urgentCounter ++;
+					urgentFrames ++;
+					PDEBUG("urgent frame on channel %d, %d records", c, nRecs);
+				}
+				urgentTokens --;
+				lastTxTime = monoNow;
+			}
+		}
 
 		// not timer event
 		if (timer == 0)
 			continue;
 
-#ifndef UNSYNC
 		// dynamic agent 0
-		if ((delay > (int)MIN_UPDATE_DELAY_US) && (agent[myNumber].dynamicID == 0) && timer == 1)
+		if (syncMode && (delay > (int)MIN_UPDATE_DELAY_US) && (agent[myNumber].dynamicID == 0) && timer == 1)
 		{
-			it.it_value.tv_usec = (__suseconds_t)(delay - (int)MIN_UPDATE_DELAY_US/2);
-			it.it_value.tv_sec = 0;
-			setitimer (ITIMER_REAL, &it, NULL);
+			setTimer(delay - (int)MIN_UPDATE_DELAY_US/2);
 			delay = 0;
 			continue;
 		}
-#endif
-
-		timer = 0;
-
-		indexBuffer = 0;
-		bzero(sendBuffer, BUFFER_SIZE);
 
 		update_stateTable();
 
@@ -561,48 +1939,38 @@ int main(int argc, char *argv[])
 
 		MAX_DELTA = (int)(TTUP_US/RUNNING_AGENTS * 2/3);
 
-		// frame header
-		frameHeader.number = myNumber;
-		frameHeader.counter = frameCounter;
-		frameCounter ++;
-		for (i = 0; i < MAX_AGENTS; i++)
-			frameHeader.stateTable[i] = agent[myNumber].stateTable[i];
-		frameHeader.noRecs = sharedRecs;
-		memcpy(sendBuffer + indexBuffer, &frameHeader, sizeof(frameHeader));
-		indexBuffer += sizeof(frameHeader);
+		// frame header (the number of records is only known at the end)
+		lastSendTime = monotonicUs();
+		indexBuffer = beginFrame(sendBuffer, lastSendTime, 1);
 
-		for(i = 0; i < sharedRecs; i++)
-		{
-			// id
-			memcpy(sendBuffer + indexBuffer, &rec[i].id, sizeof(rec[i].id));
-			indexBuffer += sizeof(rec[i].id);
-
-			// size
-			memcpy(sendBuffer + indexBuffer, &rec[i].size, sizeof(rec[i].size));
-			indexBuffer += sizeof(rec[i].size);
-
-			// life and data
-			life = DB_get(myNumber, rec[i].id, sendBuffer + indexBuffer + sizeof(life));
-			memcpy(sendBuffer + indexBuffer, &life, sizeof(life));
-			indexBuffer = indexBuffer + sizeof(life) + rec[i].size;
-		}
+		// records of the default channel due in this frame (fragmented if needed)
+		indexBuffer = packDue(&channel[0], sendBuffer, indexBuffer, (unsigned int)lastSendTime, &nRecs);
 
-		if (indexBuffer > BUFFER_SIZE)
-		{
-			PERR("Pretended frame is bigger that the available buffer.");
-			PERR("Please increase the buffer size or reduce the number of disseminated records");
-			break;
-		}
+		endFrame(sendBuffer, 0, channel[0].counter, lastSendTime, nRecs);
 	
 		if (nosend == 0) 
 		{
-			if (sendData(sckt, sendBuffer, indexBuffer) != indexBuffer)
+			if (sendFrame(sckt, (char*)sendBuffer, indexBuffer, channel[0].counter, 0) == -1)
 				PERRNO("Error sending data");
 		}
 
-		gettimeofday (&tempTimeStamp, NULL);
-		lastSendTimeStamp.tv_sec = tempTimeStamp.tv_sec;
-		lastSendTimeStamp.tv_usec = tempTimeStamp.tv_usec;
+		link_update((nosend == 0) ? indexBuffer : 0);
+
+		// the other channels, in the same slot, every period cycles
+		for (c = 1; (c < nChannels) && (nosend == 0); c++)
+		{
+			if ((channel[c].socket == -1) || (channel[c].n == 0) || (channel[0].counter % channel[c].period != 0))
+				continue;
+			indexBuffer = packDue(&channel[c], sendBuffer, beginFrame(sendBuffer, lastSendTime, 0), (unsigned int)lastSendTime, &nRecs);
+			endFrame(sendBuffer, c << WIRE_CHANNEL_SHIFT, channel[c].counter, lastSendTime, nRecs);
+			if (sendFrame(channel[c].socket, (char*)sendBuffer, indexBuffer, channel[c].counter, c) == -1)
+				PERRNO("Error sending data");
+			channel[c].counter ++;
+		}
+		channel[0].counter ++;
+		lastTxTime = monotonicUs();
+		urgentTokens = URGENT_PER_CYCLE;
+
 
 		// reset values for next round
 		for (i=0; i<MAX_AGENTS; i++)
@@ -612,20 +1980,82 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	print_stats();
+
+	printf("communication: lost frames per agent:");
+	for (i=0; i<MAX_AGENTS; i++)
+		printf(" %d", lostPackets[i]);
+	printf("\n");
+
 	FDEBUG (filedebug, "\nLost Packets:\n");
 	for (i=0; i<MAX_AGENTS; i++)
 		FDEBUG (filedebug, "%d\t", lostPackets[i]);
 	FDEBUG (filedebug, "\n");
+
+	printf("communication: lost fragments per agent:");
+	for (i=0; i<MAX_AGENTS; i++)
+		printf(" %d", lostFragments[i]);
+	printf("\n");
+
+	printf("communication: records without keyframe per agent:");
+	for (i=0; i<MAX_AGENTS; i++)
+		printf(" %d", missingKeys[i]);
+	printf("\n");
+
+	printf("communication: %d urgent frames sent, %d deferred\n", urgentFrames, urgentDeferred);
+
+	for (c = 1; c < nChannels; c++)
+	{
+		if (channel[c].socket == -1)
+			continue;
+		printf("communication: channel %d, lost frames per agent:", channel[c].number);
+		for (i=0; i<MAX_AGENTS; i++)
+			printf(" %d", channel[c].lost[i]);
+		printf("\n");
+	}
+
+	for (i=0; i<MAX_AGENTS; i++)
+		if (schemaMismatch[i] != 0)
+			printf("communication: %d frames from agent %d rejected (other rtdb.ini, data types or version)\n", schemaMismatch[i], i);
 	
 	printf("communication: STOPED.\nCleaning process...\n");
 
+	if (pmanAttached)
+	{
+		PMAN_deattach((char*)"comm");
+		PMAN_close(PMAN_CLLEAVE);
+	}
+
 #ifdef FILEDEBUG
 	fclose (filedebug);
 #endif
 
+	close(epollFd);
+	close(timerFd);
+	close(urgentTimerFd);
+	if (urgentFd != -1)
+		close(urgentFd);
 	closeSocket(sckt);
-
-	pthread_join(recvThread, NULL);
+	for (c = 1; c < nChannels; c++)
+		if (channel[c].socket != -1)
+			closeSocket(channel[c].socket);
+
+	for (i = 0; i < sharedRecs; i++)
+		free(sendKey[i].data);
+	free(sendKey);
+	for (i = 0; i < MAX_AGENTS; i++)
+		for (j = 0; j < MAX_ITEMS; j++)
+			free(recvKey[i][j].data);
+	for (c = 0; c < MAX_CHANNELS; c++)
+		for (i = 0; i < MAX_AGENTS; i++)
+			free(reassembly[c][i].buffer);
+	free(urgentPending);
+	free(recvData);
+	free(recData);
+	free(sendBuffer);
+	free(order);
+	free(sched);
+	free(rec);
 
 	DB_free();
 
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA COMM
+ *
+ * CAMBADA COMM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA COMM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// End to end benchmark of comm, usually over the emulated network (netem.h):
+//
+//	AGENT=1 NETEM="loss=0.05" ./comm lo &
+//	AGENT=2 NETEM="loss=0.05" ./comm lo &
+//	AGENT=1 ./commBench send 30 &
+//	AGENT=2 ./commBench receive 1 30 0 1 19
+//
+// The sender writes a counter and a time stamp in every shared record of its
+// agent (12 bytes or more), at the record period; the receiver reports, for each record, the
+// updates received and lost and the latency from DB_put to the local RTDB.
+// Both must run in the same machine (the stamps are CLOCK_MONOTONIC).
+
+#include "rtdb_api.h"
+#include "rtdb_comm.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAGIC	0xBE4C0001
+#define BENCH_TICK_US	101000		// a bit slower than the comm cycle (TTUP_US), so no update
+									// is overwritten before being sent, and the phase drifts
+#define BENCH_POLL_US	200
+
+struct _benchStamp
+{
+	unsigned int magic;
+	unsigned int counter;
+	unsigned int sent;		// CLOCK_MONOTONIC (us, lower 32 bits)
+};
+
+static long long benchNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int compareLatency(const void *a, const void *b)
+{
+	long long la = *(const long long*)a, lb = *(const long long*)b;
+	return (la > lb) - (la < lb);
+}
+
+static void benchSend(int seconds, bool urgent)
+{
+	int n = DB_comm_ini(NULL);
+	assert(n > 0);
+	RTDBconf_var *rec = (RTDBconf_var*)malloc(n * sizeof(RTDBconf_var));
+	assert((rec != NULL) && (DB_comm_ini(rec) == n));
+
+	// same as comm: a period below one frame means every frame
+	int maxSize = 0;
+	for (int i = 0; i < n; i++)
+	{
+		if (rec[i].period < 1)
+			rec[i].period = 1;
+		if (rec[i].size > maxSize)
+			maxSize = rec[i].size;
+	}
+	char *buf = (char*)malloc(maxSize);
+	unsigned int *counter = (unsigned int*)calloc(n, sizeof(unsigned int));
+	assert((buf != NULL) && (counter != NULL));
+
+	struct _benchStamp stamp;
+	stamp.magic = BENCH_MAGIC;
+	int updates = 0;
+
+	long long start = benchNow();
+	for (int tick = 0; tick < seconds * 1000000 / BENCH_TICK_US; tick++)
+	{
+		long long wake = start + (long long)tick * BENCH_TICK_US;
+		long long now = benchNow();
+		if (wake > now)
+			usleep(wake - now);
+
+		for (int i = 0; i < n; i++)
+		{
+			if ((rec[i].size < (int)sizeof(stamp)) || (tick % rec[i].period != 0))
+				continue;
+			memset(buf, 0, rec[i].size);
+			stamp.counter = ++counter[i];
+			stamp.sent = (unsigned int)benchNow();
+			memcpy(buf, &stamp, sizeof(stamp));
+			if (urgent)
+				DB_put_urgent(rec[i].id, buf);
+			else
+				DB_put(rec[i].id, buf);
+			updates ++;
+		}
+	}
+
+	printf("sent %d updates of %d records\n", updates, n);
+	free(counter);
+	free(buf);
+	free(rec);
+}
+
+static void benchReceive(int agent, int seconds, int nItems, char **items)
+{
+	int maxSamples = seconds * 1000000 / BENCH_TICK_US + 1;
+	int *id = (int*)malloc(nItems * sizeof(int));
+	unsigned int *last = (unsigned int*)calloc(nItems, sizeof(unsigned int));
+	int *received = (int*)calloc(nItems, sizeof(int));
+	int *lost = (int*)calloc(nItems, sizeof(int));
+	long long *latency = (long long*)malloc((long)nItems * maxSamples * sizeof(long long));
+	assert((id != NULL) && (last != NULL) && (received != NULL) && (lost != NULL) && (latency != NULL));
+
+	for (int i = 0; i < nItems; i++)
+		id[i] = atoi(items[i]);
+
+	long long end = benchNow() + (long long)seconds * 1000000;
+	while (benchNow() < end)
+	{
+		for (int i = 0; i < nItems; i++)
+		{
+			RTDBref ref;
+			struct _benchStamp stamp;
+			const void *data = DB_get_ref(agent, id[i], NULL, &ref);
+			if ((data == NULL) || (ref.length < (int)sizeof(stamp)))
+				continue;
+			memcpy(&stamp, data, sizeof(stamp));
+			long long now = benchNow();
+			if (!DB_ref_valid(&ref) || (stamp.magic != BENCH_MAGIC) || (stamp.counter == last[i]))
+				continue;
+
+			// the first update only sets the reference
+			if (last[i] != 0)
+			{
+				if (stamp.counter > last[i])
+					lost[i] += stamp.counter - last[i] - 1;
+				if (received[i] < maxSamples)
+					latency[(long)i * maxSamples + received[i]] = (unsigned int)now - stamp.sent;
+				received[i] ++;
+			}
+			last[i] = stamp.counter;
+		}
+		usleep(BENCH_POLL_US);
+	}
+
+	printf("  id  received      lost    median(ms)    p95(ms)    max(ms)\n");
+	for (int i = 0; i < nItems; i++)
+	{
+		long long *l = latency + (long)i * maxSamples;
+		int m = (received[i] < maxSamples) ? received[i] : maxSamples;
+		if (m == 0)
+		{
+			printf("%4d  no updates\n", id[i]);
+			continue;
+		}
+		qsort(l, m, sizeof(long long), compareLatency);
+		printf("%4d  %8d  %8d    %10.2f %10.2f %10.2f\n", id[i], received[i], lost[i],
+			l[m / 2] / 1000.0, l[(m * 95) / 100] / 1000.0, l[m - 1] / 1000.0);
+	}
+
+	free(latency);
+	free(lost);
+	free(received);
+	free(last);
+	free(id);
+}
+
+int main(int argc, char* argv[])
+{
+	if ((argc < 3) || ((strcmp(argv[1], "send") != 0) && (strcmp(argv[1], "receive") != 0)) ||
+		((strcmp(argv[1], "receive") == 0) && (argc < 5)))
+	{
+		fprintf(stderr, "USAGE: commBench send seconds [urgent]\n");
+		fprintf(stderr, "       commBench receive from-agent seconds id...\n");
+		exit(EXIT_FAILURE);
+	}
+
+	assert(DB_init() != -1);
+
+	if (strcmp(argv[1], "send") == 0)
+		benchSend(atoi(argv[2]), (argc > 3) && (strcmp(argv[3], "urgent") == 0));
+	else
+		benchReceive(atoi(argv[2]), atoi(argv[3]), argc - 4, argv + 4);
+
+	DB_free();
+}
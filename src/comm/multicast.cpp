@@ -31,8 +31,10 @@
 #include <linux/if.h>
 #include <unistd.h>
 #include <linux/if_ether.h>
+#include <sys/uio.h>
 
 #include "multicast.h"
+#include "netem.h"
 
 
 #define PERRNO(txt) \
@@ -49,7 +51,20 @@
 #endif
 
 
-struct sockaddr_in destAddress;
+// datagrams taken by each receiveDataBatch call
+#define MAX_BATCH 64
+
+// sockets open at the same time (one per channel)
+#define MAX_SOCKETS 8
+
+
+// group each socket sends to
+struct _destination
+{
+	int socket;
+	struct sockaddr_in address;
+} destination[MAX_SOCKETS];
+int nDestinations = 0;
 
 
 int if_NameToIndex(char *ifname, char *address)
@@ -99,6 +114,16 @@ int if_NameToIndex(char *ifname, char *address)
 //  Open Socket
 //
 int openSocket(char* interface)
+{
+	return openSocketGroup(interface, MULTICAST_IP, MULTICAST_PORT, 0);
+}
+
+
+
+//	*************************
+//  Open Socket in a multicast group
+//
+int openSocketGroup(char* interface, const char* group, int port, int ttl)
 {
     struct sockaddr_in multicastAddress;
     struct ip_mreqn mreqn;
@@ -106,16 +131,23 @@ int openSocket(char* interface)
 	int multiSocket;
 	int opt;
 	char address[20];
+	struct sockaddr_in destAddress;
 
     bzero(&multicastAddress, sizeof(struct sockaddr_in));
     multicastAddress.sin_family = AF_INET;
-    multicastAddress.sin_port = htons(MULTICAST_PORT);
+    multicastAddress.sin_port = htons(port);
     multicastAddress.sin_addr.s_addr = INADDR_ANY;
 
 	bzero(&destAddress, sizeof(struct sockaddr_in));
 	destAddress.sin_family = AF_INET;
-	destAddress.sin_port = htons(MULTICAST_PORT);
-	destAddress.sin_addr.s_addr = inet_addr(MULTICAST_IP);
+	destAddress.sin_port = htons(port);
+	destAddress.sin_addr.s_addr = inet_addr(group);
+
+	if (nDestinations == MAX_SOCKETS)
+	{
+		PERR("Too many sockets (MAX_SOCKETS = %d)", MAX_SOCKETS);
+		return -1;
+	}
 
 	if((multiSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1)
 	{
@@ -139,7 +171,7 @@ int openSocket(char* interface)
     }
  
 	memset((void *) &mreq, 0, sizeof(mreq));
-	mreq.imr_multiaddr.s_addr = inet_addr(MULTICAST_IP);
+	mreq.imr_multiaddr.s_addr = inet_addr(group);
 	mreq.imr_interface.s_addr = inet_addr(address);
 
 	if((setsockopt(multiSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq))) == -1)
@@ -156,12 +188,38 @@ int openSocket(char* interface)
 		return -1;
 	}
 
+	if (ttl > 0)
+	{
+		opt = ttl;
+		if((setsockopt(multiSocket, IPPROTO_IP, IP_MULTICAST_TTL, &opt, sizeof(opt))) == -1)
+		{
+			PERRNO("setsockopt");
+			return -1;
+		}
+	}
+
+	/* Time stamp received datagrams (receiveDataBatch) */
+	opt = 1;
+	if((setsockopt(multiSocket, SOL_SOCKET, SO_TIMESTAMP, &opt, sizeof(opt))) == -1)
+	{
+		PERRNO("setsockopt");
+		return -1;
+	}
+
 	if(bind(multiSocket, (struct sockaddr *) &multicastAddress, sizeof(struct sockaddr_in)) == -1)
 	{
 		PERRNO("bind");
 		return -1;
 	}
 
+	// emulated network, when NETEM is set
+	if ((multiSocket = netemOpen(multiSocket)) == -1)
+		return -1;
+
+	destination[nDestinations].socket = multiSocket;
+	destination[nDestinations].address = destAddress;
+	nDestinations ++;
+
 	return (multiSocket);
 }
 
@@ -172,8 +230,17 @@ int openSocket(char* interface)
 //
 void closeSocket(int multiSocket)
 {
-	if(multiSocket != -1)
-		shutdown(multiSocket, SHUT_RDWR);
+	int realSocket = netemSocket(multiSocket);
+	int i;
+
+	for (i = 0; (i < nDestinations) && (destination[i].socket != multiSocket); i++)
+		;
+	if (i < nDestinations)
+		destination[i] = destination[--nDestinations];
+
+	netemClose(multiSocket);
+	if(realSocket != -1)
+		shutdown(realSocket, SHUT_RDWR);
 }
 
 
@@ -183,7 +250,17 @@ void closeSocket(int multiSocket)
 //
 int sendData(int multiSocket, void* data, int dataSize)
 {
-	return sendto(multiSocket, data, dataSize, 0, (struct sockaddr *)&destAddress, sizeof (struct sockaddr));
+	int i;
+
+	for (i = 0; (i < nDestinations) && (destination[i].socket != multiSocket); i++)
+		;
+	if (i == nDestinations)
+	{
+		errno = EBADF;
+		return -1;
+	}
+
+	return sendto(netemSocket(multiSocket), data, dataSize, 0, (struct sockaddr *)&destination[i].address, sizeof (struct sockaddr));
 }
 
 
@@ -195,3 +272,46 @@ int receiveData(int multiSocket, void* buffer, int bufferSize)
 {
 	return recv(multiSocket, buffer, bufferSize, 0);
 }
+
+
+
+//	*************************
+//  Receive Data Batch
+//
+int receiveDataBatch(int multiSocket, char* buffers, int bufferSize, int* lengths, struct timeval* stamps, int n)
+{
+	struct mmsghdr msgs[MAX_BATCH];
+	struct iovec iovecs[MAX_BATCH];
+	char control[MAX_BATCH][CMSG_SPACE(sizeof(struct timeval))];
+	struct cmsghdr *cmsg;
+	int i, received;
+
+	if (n > MAX_BATCH)
+		n = MAX_BATCH;
+
+	memset(msgs, 0, n * sizeof(struct mmsghdr));
+	for (i = 0; i < n; i++)
+	{
+		iovecs[i].iov_base = buffers + i * bufferSize;
+		iovecs[i].iov_len = bufferSize;
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_control = control[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+	}
+
+	if ((received = recvmmsg(multiSocket, msgs, n, MSG_DONTWAIT, NULL)) == -1)
+		return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+
+	for (i = 0; i < received; i++)
+	{
+		lengths[i] = msgs[i].msg_len;
+
+		gettimeofday(&stamps[i], NULL);
+		for (cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+			if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_TIMESTAMP))
+				memcpy(&stamps[i], CMSG_DATA(cmsg), sizeof(struct timeval));
+	}
+
+	return received;
+}
@@ -20,6 +20,8 @@
  * along with this package.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <sys/time.h>
+
 #define MULTICAST_IP	"224.16.32.200"
 #define MULTICAST_PORT	2000
 #define TTL				64
@@ -39,6 +41,21 @@ int openSocket(char* interface);
 
 
 
+//	*************************
+//  Open Socket in a multicast group
+//
+//	Input:
+//		const char* = interface name {eth0, wlan0, ...}
+//		const char* group = multicast address
+//		int port = UDP port
+//		int ttl = multicast TTL (0 = system default)
+//	Output:
+//		int multiSocket = socket descriptor
+//
+int openSocketGroup(char* interface, const char* group, int port, int ttl);
+
+
+
 //	*************************
 //  Close Socket
 //
@@ -70,3 +87,22 @@ int sendData(int multiSocket, void* data, int dataSize);
 //		int bufferSize = total size of buffer
 //
 int receiveData(int multiSocket, void* buffer, int bufferSize);
+
+
+
+//	*************************
+//  Receive Data Batch
+//    takes the datagrams already queued in the socket, never blocks
+//
+//  Input:
+//		int multiSocket = socket descriptor
+//		char* buffers = n buffers of bufferSize bytes, one after the other
+//		int bufferSize = size of each buffer
+//		int* lengths = number of bytes received in each buffer
+//		struct timeval* stamps = time each datagram arrived (kernel time stamp)
+//		int n = number of buffers
+//	Output:
+//		number of datagrams received (0 = none queued)
+//		-1 = error
+//
+int receiveDataBatch(int multiSocket, char* buffers, int bufferSize, int* lengths, struct timeval* stamps, int n);
@@ -0,0 +1,394 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA COMM
+ *
+ * CAMBADA COMM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA COMM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "netem.h"
+
+
+#define PERRNO(txt) \
+	printf("ERROR: (%s / %s): " txt ": %s\n", __FILE__, __FUNCTION__, strerror(errno))
+
+#define PERR(txt, par...) \
+	printf("ERROR: (%s / %s): " txt "\n", __FILE__, __FUNCTION__, ## par)
+
+
+#define NETEM_QUEUE		256		// datagrams held at the same time
+#define NETEM_DGRAM		1500	// largest datagram
+#define NETEM_SOCKETS	8		// sockets emulated at the same time (one per channel)
+
+
+struct _held
+{
+	long long release;			// monotonic time to hand it to comm (us)
+	int len;
+	char data[NETEM_DGRAM];
+};
+
+struct _netem
+{
+	int realSocket;
+	int pair[2];				// comm reads pair[0], the thread writes pair[1]
+	pthread_t thread;
+	volatile int running;
+
+	unsigned long long random;	// xorshift state
+	double loss, burst, burstLen, reorder;
+	long delay, jitter;
+	int inBurst;
+	long long lastRelease;		// keeps the order of datagrams not reordered
+
+	struct _held queue[NETEM_QUEUE];
+	int nHeld;
+
+	int received, lost, burstLost, reordered, overflow;
+};
+
+struct _netem *netem[NETEM_SOCKETS];
+int nNetem = 0;
+
+
+
+//	*************************
+//  Random number in [0, 1), the same sequence on every machine
+//
+static double netemRandom(struct _netem *n)
+{
+	n->random ^= n->random << 13;
+	n->random ^= n->random >> 7;
+	n->random ^= n->random << 17;
+	return (n->random >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+
+static long long netemNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+
+//	*************************
+//  Parse the NETEM variable
+//
+//	Input:
+//		struct _netem *n = emulator
+//		const char *config = NETEM
+//		int index = socket opened before this one (each gets its own sequence)
+//	Output:
+//		0 = ok
+//		-1 = unknown parameter
+//
+static int netemConfig(struct _netem *n, const char *config, int index)
+{
+	char name[16];
+	double value;
+	unsigned long long seed = 1;
+	const char *agent;
+	int used;
+
+	while (sscanf(config, " %15[a-z] = %lf%n", name, &value, &used) == 2)
+	{
+		if (strcmp(name, "seed") == 0)
+			seed = (unsigned long long)value;
+		else if (strcmp(name, "loss") == 0)
+			n->loss = value;
+		else if (strcmp(name, "burst") == 0)
+			n->burst = value;
+		else if (strcmp(name, "burstlen") == 0)
+			n->burstLen = value;
+		else if (strcmp(name, "delay") == 0)
+			n->delay = (long)value;
+		else if (strcmp(name, "jitter") == 0)
+			n->jitter = (long)value;
+		else if (strcmp(name, "reorder") == 0)
+			n->reorder = value;
+		else
+		{
+			PERR("Unknown %s parameter: %s", NETEM_ENV, name);
+			return -1;
+		}
+
+		config += used;
+		if (*config == ',')
+			config ++;
+	}
+
+	if (*config != '\0')
+	{
+		PERR("Invalid %s: %s", NETEM_ENV, config);
+		return -1;
+	}
+
+	if ((agent = getenv("AGENT")) != NULL)
+		seed = seed * 1000003 + atoi(agent);
+	seed = seed * 1000003 + index;
+	n->random = seed * 0x9E3779B97F4A7C15ULL + 1;
+	if (n->burstLen < 1)
+		n->burstLen = 1;
+
+	return 0;
+}
+
+
+
+//	*************************
+//  Decide the fate of a datagram just received
+//
+static void netemArrive(struct _netem *n, char *data, int len, long long now)
+{
+	struct _held *h;
+	long long release;
+	int i;
+
+	n->received ++;
+
+	// Gilbert model: a burst ends after burstLen datagrams on average
+	if (n->inBurst)
+		n->inBurst = (netemRandom(n) >= 1.0 / n->burstLen);
+	else
+		n->inBurst = (netemRandom(n) < n->burst);
+	if (n->inBurst)
+	{
+		n->burstLost ++;
+		return;
+	}
+
+	if (netemRandom(n) < n->loss)
+	{
+		n->lost ++;
+		return;
+	}
+
+	release = now + n->delay + (long)(netemRandom(n) * n->jitter);
+	if (netemRandom(n) < n->reorder)
+	{
+		release += n->delay + n->jitter + 1;
+		n->reordered ++;
+	}
+	else
+	{
+		if (release < n->lastRelease)
+			release = n->lastRelease;
+		n->lastRelease = release;
+	}
+
+	if (n->nHeld == NETEM_QUEUE)
+	{
+		n->overflow ++;
+		return;
+	}
+
+	// sorted by release time, the same times in arrival order
+	for (i = n->nHeld; (i > 0) && (n->queue[i-1].release > release); i--)
+		memcpy(&n->queue[i], &n->queue[i-1], sizeof(struct _held));
+	h = &n->queue[i];
+	h->release = release;
+	h->len = len;
+	memcpy(h->data, data, len);
+	n->nHeld ++;
+}
+
+
+
+//	*************************
+//  Emulator thread
+//
+static void *netemThread(void *arg)
+{
+	struct _netem *n = (struct _netem*)arg;
+	char buffer[NETEM_DGRAM];
+	struct pollfd pfd;
+	struct timespec timeout;
+	long long now, wait;
+	int len, i;
+
+	pfd.fd = n->realSocket;
+	pfd.events = POLLIN;
+
+	while (n->running)
+	{
+		// until the next release, or a while to check running
+		now = netemNow();
+		wait = (n->nHeld > 0) ? n->queue[0].release - now : 100000;
+		if (wait < 0)
+			wait = 0;
+		timeout.tv_sec = wait / 1000000;
+		timeout.tv_nsec = (wait % 1000000) * 1000;
+
+		if ((ppoll(&pfd, 1, &timeout, NULL) == -1) && (errno != EINTR))
+		{
+			PERRNO("ppoll");
+			break;
+		}
+
+		now = netemNow();
+		while ((len = recv(n->realSocket, buffer, NETEM_DGRAM, MSG_DONTWAIT)) > 0)
+			netemArrive(n, buffer, len, now);
+
+		for (i = 0; (i < n->nHeld) && (n->queue[i].release <= now); i++)
+			if (send(n->pair[1], n->queue[i].data, n->queue[i].len, MSG_DONTWAIT) == -1)
+				n->overflow ++;
+		if (i > 0)
+		{
+			memmove(&n->queue[0], &n->queue[i], (n->nHeld - i) * sizeof(struct _held));
+			n->nHeld -= i;
+		}
+	}
+
+	return NULL;
+}
+
+
+
+//	*************************
+//  Emulator of a socket returned by netemOpen
+//
+static int netemFind(int multiSocket)
+{
+	int i;
+
+	for (i = 0; i < nNetem; i++)
+		if (netem[i]->pair[0] == multiSocket)
+			return i;
+	return -1;
+}
+
+
+
+//	*************************
+//  Start the emulator on an open socket
+//
+int netemOpen(int realSocket)
+{
+	struct _netem *n;
+	const char *config;
+	int opt;
+
+	if ((realSocket == -1) || ((config = getenv(NETEM_ENV)) == NULL))
+		return realSocket;
+
+	if (nNetem == NETEM_SOCKETS)
+	{
+		PERR("Too many emulated sockets (NETEM_SOCKETS = %d)", NETEM_SOCKETS);
+		return -1;
+	}
+
+	if ((n = (struct _netem*)calloc(1, sizeof(struct _netem))) == NULL)
+	{
+		PERRNO("calloc");
+		return -1;
+	}
+	n->realSocket = realSocket;
+	if (netemConfig(n, config, nNetem) == -1)
+	{
+		free(n);
+		return -1;
+	}
+
+	// the other agents are in this machine
+	opt = 1;
+	if (setsockopt(realSocket, IPPROTO_IP, IP_MULTICAST_LOOP, &opt, sizeof(opt)) == -1)
+		PERRNO("setsockopt");
+
+	if (socketpair(AF_UNIX, SOCK_DGRAM, 0, n->pair) == -1)
+	{
+		PERRNO("socketpair");
+		free(n);
+		return -1;
+	}
+
+	// time stamped when handed to comm, after the emulated delay
+	opt = 1;
+	if (setsockopt(n->pair[0], SOL_SOCKET, SO_TIMESTAMP, &opt, sizeof(opt)) == -1)
+		PERRNO("setsockopt");
+
+	n->running = 1;
+	if ((errno = pthread_create(&n->thread, NULL, netemThread, n)) != 0)
+	{
+		PERRNO("pthread_create");
+		close(n->pair[0]);
+		close(n->pair[1]);
+		free(n);
+		return -1;
+	}
+
+	printf("**** Emulated network: loss %.3f, burst %.3f x %.1f, delay %ld+%ld us, reorder %.3f ****\n",
+		n->loss, n->burst, n->burstLen, n->delay, n->jitter, n->reorder);
+
+	netem[nNetem++] = n;
+	return n->pair[0];
+}
+
+
+
+//	*************************
+//  Socket to send to
+//
+int netemSocket(int multiSocket)
+{
+	int i;
+
+	if ((i = netemFind(multiSocket)) == -1)
+		return multiSocket;
+	return netem[i]->realSocket;
+}
+
+
+
+//	*************************
+//  Stop the emulator
+//
+void netemClose(int multiSocket)
+{
+	struct _netem *n;
+	int i;
+
+	if ((i = netemFind(multiSocket)) == -1)
+		return;
+	n = netem[i];
+	netem[i] = netem[--nNetem];
+
+	n->running = 0;
+	pthread_join(n->thread, NULL);
+
+	printf("netem: %d datagrams, %d lost, %d lost in bursts, %d reordered, %d dropped (queue full)\n",
+		n->received, n->lost, n->burstLost, n->reordered, n->overflow);
+
+	close(n->pair[0]);
+	close(n->pair[1]);
+	free(n);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA COMM
+ *
+ * CAMBADA COMM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA COMM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAMBADA_NETEM_
+#define _CAMBADA_NETEM_
+
+// Emulated network for lab tests: a thread takes the datagrams from the real
+// socket and hands them to comm through a local socket, after applying loss,
+// burst loss, delay, jitter and reordering. It is only on when the NETEM
+// environment variable is set, e.g.
+//
+//	NETEM="seed=7,loss=0.02,burst=0.01,burstlen=5,delay=2000,jitter=1000,reorder=0.01" AGENT=1 ./comm lo
+//
+//	seed		random sequence (mixed with AGENT, so every receiver has its own)
+//	loss		probability of losing a datagram
+//	burst		probability of starting a burst of losses
+//	burstlen	mean length of a burst (datagrams)
+//	delay		fixed delay (us)
+//	jitter		random extra delay, uniform in [0, jitter] (us)
+//	reorder		probability of holding a datagram for another delay + jitter,
+//				so the following ones overtake it
+//
+// The same seed gives the same decisions for the same sequence of datagrams.
+// Multicast loop is turned on, so all the agents can run in the same machine.
+
+#define NETEM_ENV		"NETEM"
+
+
+//	*************************
+//  Start the emulator on an open socket
+//
+//	Input:
+//		int realSocket = multicast socket
+//	Output:
+//		socket to be used by comm (realSocket when NETEM is not set)
+//		-1 = error
+//
+int netemOpen(int realSocket);
+
+
+
+//	*************************
+//  Socket to send to
+//
+//	Input:
+//		int multiSocket = socket returned by netemOpen
+//	Output:
+//		the real socket
+//
+int netemSocket(int multiSocket);
+
+
+
+//	*************************
+//  Stop the emulator and print its statistics
+//
+//	Input:
+//		int multiSocket = socket returned by netemOpen
+//
+void netemClose(int multiSocket);
+
+#endif
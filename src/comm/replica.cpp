@@ -0,0 +1,684 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA COMM
+ *
+ * CAMBADA COMM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA COMM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// RTDB replication, a comm without the wireless part: the shared records of
+// this agent are sent, every period, to a list of peers (UDP, usually on the
+// loopback, or Unix datagram sockets), and the records received from the
+// other agents are written in the local RTDB, as comm does. No TDMA, no
+// fragmentation (one datagram per frame, up to REPLICA_FRAME_SIZE), no delta
+// coding. So the agents of a simulation may run in several processes,
+// containers or hosts, each with its own RTDB:
+//
+//	AGENT=1 ./replica udp:5001 udp:127.0.0.1:5002 udp:127.0.0.1:5003 &
+//	AGENT=2 ./replica udp:5002 udp:127.0.0.1:5001 udp:127.0.0.1:5003 &
+//	AGENT=3 ./replica unix:/tmp/rtdb3 items=0,19 udp:127.0.0.1:5001 &
+//
+// Every replica needs the same rtdb.ini (the frames carry its hash).
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/timerfd.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "wire.h"
+
+#include "rtdb_comm.h"
+
+#define REPLICA_VERSION		1
+#define REPLICA_FRAME_SIZE	60000		// one datagram
+#define REPLICA_PERIOD_MS	100			// as the comm cycle
+#define MAX_PEERS			16
+#define REPLICA_DELAY_MS	2			// travel time added to the life, as COMM_DELAY_MS in comm
+
+//	frame:	version (1) | schema hash (4) | agent (1) | counter (4) | records (2) | record ...
+//	record:	id (varint) | life (varint) | length (varint) | data (run coded, wire.h)
+#define REPLICA_HASH		1
+#define REPLICA_AGENT		5
+#define REPLICA_COUNTER		6
+#define REPLICA_RECORDS		10
+#define REPLICA_HEADER_SIZE	12
+
+#define PERRNO(txt) \
+	printf("ERROR: (%s / %s): " txt ": %s\n", __FILE__, __FUNCTION__, strerror(errno))
+
+#define PERR(txt, par...) \
+	printf("ERROR: (%s / %s): " txt "\n", __FILE__, __FUNCTION__, ## par)
+
+// #define DEBUG
+#ifdef DEBUG
+#define PDEBUG(txt, par...) \
+	printf("DEBUG: (%s / %s): " txt "\n", __FILE__, __FUNCTION__, ## par)
+#else
+#define PDEBUG(txt, par...)
+#endif
+
+
+struct _peer
+{
+	struct sockaddr_storage addr;
+	socklen_t addrLen;
+	int sckt;							// udpSocket or unixSocket
+	char name[64];
+};
+
+
+int end;
+int myNumber;
+unsigned int schemaHash;
+
+int udpSocket = -1, unixSocket = -1;
+char unixPath[sizeof(((struct sockaddr_un*)0)->sun_path)];
+
+struct _peer peer[MAX_PEERS];
+int nPeers;
+
+unsigned int lastCounter[MAX_AGENTS];
+int lostFrames[MAX_AGENTS];
+int schemaMismatch[MAX_AGENTS];
+int putErrors[MAX_AGENTS];
+
+// shared records by id, to check what a frame carries before writing it
+int nItems;								// highest shared id + 1
+int *itemSize;							// -1 = not a shared record
+unsigned char *putReported;				// [agent][id], last column for unknown ids
+
+
+
+//	*************************
+//  Signal catch
+//
+static void signal_catch(int sig)
+{
+	if (sig == SIGINT)
+		end = 1;
+}
+
+
+
+// *************************
+//  Unix datagram socket, bound to path if not NULL
+//
+//  Output:
+//    socket
+//    -1 = error
+//
+int openUnix(const char *path)
+{
+	struct sockaddr_un addr;
+	int sckt;
+
+	if ((sckt = socket(AF_UNIX, SOCK_DGRAM, 0)) == -1)
+	{
+		PERRNO("socket");
+		return -1;
+	}
+
+	if (path != NULL)
+	{
+		if (strlen(path) >= sizeof(addr.sun_path))
+		{
+			PERR("Socket path too long: %s", path);
+			close(sckt);
+			return -1;
+		}
+		bzero(&addr, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strcpy(addr.sun_path, path);
+		unlink(path);
+		if (bind(sckt, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+		{
+			PERRNO("bind");
+			close(sckt);
+			return -1;
+		}
+	}
+
+	return sckt;
+}
+
+
+
+// *************************
+//  UDP socket, bound to port (0 = any)
+//
+//  Output:
+//    socket
+//    -1 = error
+//
+int openUdp(int port)
+{
+	struct sockaddr_in addr;
+	int sckt;
+
+	if ((sckt = socket(AF_INET, SOCK_DGRAM, 0)) == -1)
+	{
+		PERRNO("socket");
+		return -1;
+	}
+
+	bzero(&addr, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(sckt, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+	{
+		PERRNO("bind");
+		close(sckt);
+		return -1;
+	}
+
+	return sckt;
+}
+
+
+
+// *************************
+//  Add a peer, udp:host:port or unix:path
+//
+//  Output:
+//    0 = OK
+//    -1 = error
+//
+int addPeer(const char *arg)
+{
+	struct _peer *p;
+	struct sockaddr_un *un;
+	struct addrinfo hints, *res;
+	char host[64];
+	const char *port;
+
+	if (nPeers == MAX_PEERS)
+	{
+		PERR("Too many peers (MAX_PEERS = %d)", MAX_PEERS);
+		return -1;
+	}
+	p = &peer[nPeers];
+	bzero(p, sizeof(*p));
+	snprintf(p->name, sizeof(p->name), "%s", arg);
+
+	if (strncmp(arg, "unix:", 5) == 0)
+	{
+		if ((unixSocket == -1) && ((unixSocket = openUnix(NULL)) == -1))
+			return -1;
+		un = (struct sockaddr_un*)&p->addr;
+		if (strlen(arg + 5) >= sizeof(un->sun_path))
+		{
+			PERR("Socket path too long: %s", arg + 5);
+			return -1;
+		}
+		un->sun_family = AF_UNIX;
+		strcpy(un->sun_path, arg + 5);
+		p->addrLen = sizeof(struct sockaddr_un);
+		p->sckt = unixSocket;
+	}
+	else if ((strncmp(arg, "udp:", 4) == 0) && ((port = strrchr(arg + 4, ':')) != NULL) &&
+		(port - arg - 4 < (int)sizeof(host)))
+	{
+		if ((udpSocket == -1) && ((udpSocket = openUdp(0)) == -1))
+			return -1;
+		memcpy(host, arg + 4, port - arg - 4);
+		host[port - arg - 4] = '\0';
+		bzero(&hints, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_DGRAM;
+		if (getaddrinfo(host, port + 1, &hints, &res) != 0)
+		{
+			PERR("Unknown peer %s", arg);
+			return -1;
+		}
+		memcpy(&p->addr, res->ai_addr, res->ai_addrlen);
+		p->addrLen = res->ai_addrlen;
+		freeaddrinfo(res);
+		p->sckt = udpSocket;
+	}
+	else
+	{
+		PERR("Invalid peer %s (udp:host:port or unix:path)", arg);
+		return -1;
+	}
+
+	nPeers ++;
+	return 0;
+}
+
+
+
+// *************************
+//  Send a frame to every peer
+//
+void sendFrame(unsigned char *frame, int frameLen)
+{
+	int i;
+
+	for (i = 0; i < nPeers; i++)
+		if ((sendto(peer[i].sckt, frame, frameLen, 0, (struct sockaddr*)&peer[i].addr, peer[i].addrLen) == -1) &&
+			(errno != ECONNREFUSED) && (errno != ENOENT))
+			PERRNO("sendto");
+}
+
+
+
+// *************************
+//  Code a record in the frame
+//
+//  Input:
+//    unsigned char *buf = where to code it
+//    int max = bytes available
+//    int id = record id
+//    int life = record life
+//    unsigned char *data = record data
+//    int len = record bytes in use
+//  Output:
+//    bytes used
+//    -1 = does not fit
+//
+int encodeRecord(unsigned char *buf, int max, int id, int life, unsigned char *data, int len)
+{
+	int n, k;
+
+	if ((n = wire_put_varint(buf, max, id)) == -1)
+		return -1;
+
+	if ((k = wire_put_varint(buf + n, max - n, (life < 0) ? 0 : life)) == -1)
+		return -1;
+	n += k;
+
+	if ((k = wire_put_varint(buf + n, max - n, len)) == -1)
+		return -1;
+	n += k;
+
+	if ((k = wire_encode(data, NULL, len, buf + n, max - n)) == -1)
+		return -1;
+
+	return n + k;
+}
+
+
+
+// *************************
+//  Fill the frame header and send the frame to every peer
+//
+void flushFrame(unsigned char *frame, int frameLen, int nRecs, unsigned int counter)
+{
+	frame[0] = REPLICA_VERSION;
+	wire_put_u32(frame + REPLICA_HASH, schemaHash);
+	frame[REPLICA_AGENT] = myNumber;
+	wire_put_u32(frame + REPLICA_COUNTER, counter);
+	wire_put_u16(frame + REPLICA_RECORDS, nRecs);
+
+	sendFrame(frame, frameLen);
+}
+
+
+
+// *************************
+//  Write the records of a frame in the RTDB
+//
+void processFrame(unsigned char *frame, int frameLen)
+{
+	static unsigned char data[REPLICA_FRAME_SIZE];
+	unsigned int id, life, len, counter;
+	int agentNumber, noRecs, indexBuffer, i, k;
+
+	if ((frameLen < REPLICA_HEADER_SIZE) || (frame[0] != REPLICA_VERSION))
+		return;
+
+	agentNumber = frame[REPLICA_AGENT];
+	if ((agentNumber < 0) || (agentNumber >= MAX_AGENTS) || (agentNumber == myNumber))
+		return;
+
+	if (wire_get_u32(frame + REPLICA_HASH) != schemaHash)
+	{
+		schemaMismatch[agentNumber] ++;
+		return;
+	}
+
+	counter = wire_get_u32(frame + REPLICA_COUNTER);
+	if ((lastCounter[agentNumber] != 0) && (counter - (lastCounter[agentNumber] + 1) < 0x80000000u))
+		lostFrames[agentNumber] += counter - (lastCounter[agentNumber] + 1);
+	lastCounter[agentNumber] = counter;
+
+	noRecs = wire_get_u16(frame + REPLICA_RECORDS);
+	indexBuffer = REPLICA_HEADER_SIZE;
+	for (i = 0; i < noRecs; i++)
+	{
+		if ((k = wire_get_varint(frame + indexBuffer, frameLen - indexBuffer, &id)) == -1)
+			break;
+		indexBuffer += k;
+		if ((k = wire_get_varint(frame + indexBuffer, frameLen - indexBuffer, &life)) == -1)
+			break;
+		indexBuffer += k;
+		if (((k = wire_get_varint(frame + indexBuffer, frameLen - indexBuffer, &len)) == -1) ||
+			(len > sizeof(data)))
+			break;
+		indexBuffer += k;
+		if ((k = wire_decode(frame + indexBuffer, frameLen - indexBuffer, NULL, len, data)) == -1)
+			break;
+		indexBuffer += k;
+
+		life += REPLICA_DELAY_MS;
+
+		if ((id >= (unsigned int)nItems) || (itemSize[id] == -1) || (len > (unsigned int)itemSize[id]) ||
+			(DB_comm_put(agentNumber, id, len, data, life) != (int)len))
+		{
+			// reported once per agent and item, the others are only counted
+			putErrors[agentNumber] ++;
+			k = agentNumber * (nItems + 1) + ((id < (unsigned int)nItems) ? (int)id : nItems);
+			if (!putReported[k])
+			{
+				putReported[k] = 1;
+				PERR("Error in frame/rtdb: from = %d, item = %u, received size = %u (not reported again)", agentNumber, id, len);
+			}
+		}
+	}
+
+	if (i < noRecs)
+		PERR("Truncated frame: from = %d, %d records missing", agentNumber, noRecs - i);
+}
+
+
+
+void printUsage(void)
+{
+	printf("Usage: replica <listen> [period=ms] [items=id,...] <peer> ...\n\n");
+	printf("<listen> - udp:port, unix:path, or - (only sends)\n");
+	printf("[period=ms] - transmission period, %d ms by default\n", REPLICA_PERIOD_MS);
+	printf("[items=id,...] - shared records sent, all by default\n");
+	printf("<peer> - udp:host:port or unix:path, each one gets every frame (up to %d)\n\n", MAX_PEERS);
+}
+
+
+//*************************
+//  Main
+//
+int main(int argc, char *argv[])
+{
+	RTDBconf_var *rec = NULL;
+	char *selected = NULL;
+	char *items = NULL;
+	const char *p;
+	unsigned char *frame, *recData;
+	int sharedRecs, maxSize;
+	int period = REPLICA_PERIOD_MS;
+	int timerFd, epollFd, listenFd = -1;
+	struct epoll_event event, events[3];
+	struct itimerspec timer;
+	uint64_t expirations;
+	unsigned int counter = 1, tick = 0;
+	int indexBuffer, nRecs, nEvents, n, k;
+	int life, len;
+	int frames = 0;
+	int i;
+
+	if (argc < 3)
+	{
+		printUsage();
+		return -1;
+	}
+
+	if (signal(SIGINT, signal_catch) == SIG_ERR)
+	{
+		PERRNO("signal");
+		return -1;
+	}
+
+	// where the other replicas send to
+	if (strncmp(argv[1], "udp:", 4) == 0)
+		listenFd = udpSocket = openUdp(atoi(argv[1] + 4));
+	else if (strncmp(argv[1], "unix:", 5) == 0)
+	{
+		snprintf(unixPath, sizeof(unixPath), "%s", argv[1] + 5);
+		listenFd = unixSocket = openUnix(unixPath);
+	}
+	else if (strcmp(argv[1], "-") != 0)
+	{
+		printUsage();
+		return -1;
+	}
+	if ((strcmp(argv[1], "-") != 0) && (listenFd == -1))
+		return -1;
+
+	for (i = 2; i < argc; i++)
+	{
+		if (strncmp(argv[i], "period=", 7) == 0)
+			period = atoi(argv[i] + 7);
+		else if (strncmp(argv[i], "items=", 6) == 0)
+			items = argv[i] + 6;
+		else if (addPeer(argv[i]) == -1)
+			return -1;
+	}
+	if (period < 1)
+	{
+		printUsage();
+		return -1;
+	}
+
+	if (DB_init() == -1)
+	{
+		PERR("DB_init");
+		return -1;
+	}
+
+	myNumber = Whoami();
+	if ((myNumber < 0) || (myNumber >= MAX_AGENTS))
+	{
+		PERR("Agent %d does not fit in the frame (MAX_AGENTS = %d)", myNumber, MAX_AGENTS);
+		DB_free();
+		return -1;
+	}
+
+	if (((sharedRecs = DB_comm_ini(NULL)) < 0) ||
+		((rec = (RTDBconf_var*)malloc((sharedRecs + 1) * sizeof(RTDBconf_var))) == NULL) ||
+		(DB_comm_ini(rec) != sharedRecs) ||
+		((schemaHash = DB_comm_schema()) == 0))
+	{
+		PERR("DB_comm_ini");
+		free(rec);
+		DB_free();
+		return -1;
+	}
+
+	// records sent, all the shared ones or the ones asked for
+	maxSize = 0;
+	selected = (char*)calloc(sharedRecs + 1, 1);
+	for (i = 0; (selected != NULL) && (i < sharedRecs); i++)
+	{
+		selected[i] = (items == NULL);
+		for (p = items; (p != NULL) && !selected[i]; p = strchr(p, ','))
+		{
+			if (*p == ',')
+				p ++;
+			selected[i] = (atoi(p) == rec[i].id);
+		}
+		if (selected[i] && (rec[i].size > maxSize))
+			maxSize = rec[i].size;
+		if (selected[i] && (REPLICA_HEADER_SIZE + WIRE_RECORD_MAX(rec[i].size) > REPLICA_FRAME_SIZE))
+			PERR("Record %d (%d bytes) may not fit in the frame", rec[i].id, rec[i].size);
+	}
+
+	nItems = 0;
+	for (i = 0; i < sharedRecs; i++)
+		if (rec[i].id >= nItems)
+			nItems = rec[i].id + 1;
+	itemSize = (int*)malloc((nItems + 1) * sizeof(int));
+	putReported = (unsigned char*)calloc(MAX_AGENTS * (nItems + 1), 1);
+	for (i = 0; (itemSize != NULL) && (i < nItems); i++)
+		itemSize[i] = -1;
+	for (i = 0; (itemSize != NULL) && (i < sharedRecs); i++)
+		itemSize[rec[i].id] = rec[i].size;
+
+	frame = (unsigned char*)malloc(REPLICA_FRAME_SIZE);
+	recData = (unsigned char*)malloc(maxSize + 1);
+	if ((selected == NULL) || (itemSize == NULL) || (putReported == NULL) || (frame == NULL) || (recData == NULL))
+	{
+		PERRNO("malloc");
+		DB_free();
+		return -1;
+	}
+
+	for (i = 0; i < MAX_AGENTS; i++)
+	{
+		lastCounter[i] = 0;
+		lostFrames[i] = 0;
+		schemaMismatch[i] = 0;
+		putErrors[i] = 0;
+	}
+
+	if ((timerFd = timerfd_create(CLOCK_MONOTONIC, 0)) == -1)
+	{
+		PERRNO("timerfd_create");
+		DB_free();
+		return -1;
+	}
+	timer.it_value.tv_sec = period / 1000;
+	timer.it_value.tv_nsec = (period % 1000) * 1000000;
+	timer.it_interval = timer.it_value;
+	if (timerfd_settime(timerFd, 0, &timer, NULL) == -1)
+	{
+		PERRNO("timerfd_settime");
+		DB_free();
+		return -1;
+	}
+
+	if ((epollFd = epoll_create(3)) == -1)
+	{
+		PERRNO("epoll_create");
+		DB_free();
+		return -1;
+	}
+	event.events = EPOLLIN;
+	event.data.fd = timerFd;
+	if ((epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event) == -1) ||
+		((event.data.fd = listenFd) != -1 && (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) == -1)))
+	{
+		PERRNO("epoll_ctl");
+		DB_free();
+		return -1;
+	}
+
+	printf("replica: STARTED, agent %d, %d peers, every %d ms...\n", myNumber, nPeers, period);
+	for (i = 0; i < nPeers; i++)
+		printf("replica: peer %s\n", peer[i].name);
+
+	end = 0;
+	while (!end)
+	{
+		if ((nEvents = epoll_wait(epollFd, events, 3, -1)) == -1)
+		{
+			if (errno != EINTR)
+				PERRNO("epoll_wait");
+			continue;
+		}
+
+		for (k = 0; k < nEvents; k++)
+		{
+			if (events[k].data.fd == listenFd)
+			{
+				while ((n = recv(listenFd, frame, REPLICA_FRAME_SIZE, MSG_DONTWAIT)) > 0)
+					processFrame(frame, n);
+				continue;
+			}
+
+			if (read(timerFd, &expirations, sizeof(expirations)) != (int)sizeof(expirations))
+				continue;
+			tick ++;
+
+			// records due (rtdb.conf period, in replica periods), as many frames as needed
+			indexBuffer = REPLICA_HEADER_SIZE;
+			nRecs = 0;
+			for (i = 0; i < sharedRecs; i++)
+			{
+				if (!selected[i] || (tick % ((rec[i].period < 1) ? 1 : rec[i].period) != 0))
+					continue;
+				if ((life = DB_comm_get(rec[i].id, recData, &len)) == -1)
+					continue;
+
+				if (((n = encodeRecord(frame + indexBuffer, REPLICA_FRAME_SIZE - indexBuffer, rec[i].id, life, recData, len)) == -1) &&
+					(nRecs > 0))
+				{
+					flushFrame(frame, indexBuffer, nRecs, counter++);
+					frames ++;
+					indexBuffer = REPLICA_HEADER_SIZE;
+					nRecs = 0;
+					n = encodeRecord(frame + indexBuffer, REPLICA_FRAME_SIZE - indexBuffer, rec[i].id, life, recData, len);
+				}
+				if (n == -1)
+				{
+					PERR("Record %d does not fit in the frame", rec[i].id);
+					continue;
+				}
+				indexBuffer += n;
+				nRecs ++;
+			}
+			if (nRecs > 0)
+			{
+				flushFrame(frame, indexBuffer, nRecs, counter++);
+				frames ++;
+			}
+		}
+	}
+
+	printf("replica: %d frames sent\n", frames);
+	printf("replica: lost frames per agent:");
+	for (i = 0; i < MAX_AGENTS; i++)
+		printf(" %d", lostFrames[i]);
+	printf("\n");
+	for (i = 0; i < MAX_AGENTS; i++)
+		if (schemaMismatch[i] != 0)
+			printf("replica: %d frames from agent %d rejected (other rtdb.ini)\n", schemaMismatch[i], i);
+	for (i = 0; i < MAX_AGENTS; i++)
+		if (putErrors[i] != 0)
+			printf("replica: %d records from agent %d not written in the rtdb\n", putErrors[i], i);
+
+	close(epollFd);
+	close(timerFd);
+	if (udpSocket != -1)
+		close(udpSocket);
+	if (unixSocket != -1)
+		close(unixSocket);
+	if (unixPath[0] != '\0')
+		unlink(unixPath);
+
+	free(recData);
+	free(frame);
+	free(putReported);
+	free(itemSize);
+	free(selected);
+	free(rec);
+
+	DB_free();
+
+	printf("replica: FINISHED.\n");
+
+	return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA COMM
+ *
+ * CAMBADA COMM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA COMM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//	wire-tester: round trip of the comm wire encoding (wire.h)
+//		integers and varints at their limits, and run coded records, as is
+//		and against a keyframe, with sizes, bounds and truncated input checked
+//
+//	wire-tester [seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wire.h"
+
+#define MAX_LEN		4096
+#define ROUNDS		2000
+
+static int failures = 0;
+
+#define CHECK(cond, txt, par...) \
+	do { if (!(cond)) { fprintf(stderr, "FAILED: " txt "\n", ## par); failures++; } } while (0)
+
+
+
+static void testIntegers(void)
+{
+	unsigned char buf[8];
+	unsigned int values[] = { 0, 1, 127, 128, 255, 256, 16383, 16384, 2097151, 2097152,
+		268435455, 268435456, 0x7fffffff, 0x80000000u, 0xffffffffu };
+	unsigned int value;
+	int i, n, k;
+
+	wire_put_u16(buf, 0xbeef);
+	CHECK((buf[0] == 0xef) && (buf[1] == 0xbe) && (wire_get_u16(buf) == 0xbeef), "u16");
+	wire_put_u32(buf, 0xdeadbeef);
+	CHECK((buf[0] == 0xef) && (buf[3] == 0xde) && (wire_get_u32(buf) == 0xdeadbeef), "u32");
+
+	for (i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++)
+	{
+		n = wire_put_varint(buf, sizeof(buf), values[i]);
+		CHECK((n >= 1) && (n <= 5), "varint %u: %d bytes", values[i], n);
+		CHECK((wire_get_varint(buf, n, &value) == n) && (value == values[i]), "varint %u read back as %u", values[i], value);
+
+		// one byte short, on both sides
+		CHECK(wire_put_varint(buf, n - 1, values[i]) == -1, "varint %u written in %d bytes", values[i], n - 1);
+		for (k = 0; k < n; k++)
+			CHECK(wire_get_varint(buf, k, &value) == -1, "varint %u read from %d bytes", values[i], k);
+	}
+
+	// more than 5 bytes is corrupted
+	memset(buf, 0x80, sizeof(buf));
+	CHECK(wire_get_varint(buf, sizeof(buf), &value) == -1, "endless varint");
+}
+
+
+
+// data with zero runs, literals and the mix of both
+static void fill(unsigned char *data, int len, int kind)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+	{
+		switch (kind)
+		{
+			case 0: data[i] = 0; break;
+			case 1: data[i] = rand() & 0xff; break;
+			case 2: data[i] = (rand() % 8 == 0) ? (rand() & 0xff) : 0; break;
+			default: data[i] = ((i / 5) % 2 == 0) ? 0 : (rand() & 0xff); break;
+		}
+	}
+}
+
+static void testRecords(void)
+{
+	static unsigned char data[MAX_LEN], base[MAX_LEN], out[MAX_LEN + 10 * (MAX_LEN / 3 + 1)], back[MAX_LEN];
+	int r, len, kind, delta, n, k, bound;
+
+	CHECK(wire_encode(data, NULL, 0, out, sizeof(out)) == 0, "empty record");
+	CHECK(wire_decode(out, 0, NULL, 0, back) == 0, "empty record decoded");
+
+	for (r = 0; r < ROUNDS; r++)
+	{
+		len = (r < 64) ? r : 1 + rand() % MAX_LEN;
+		kind = rand() % 4;
+		delta = rand() % 2;
+
+		fill(data, len, kind);
+		if (delta && (len > 0))
+		{
+			// keyframe close to the data: a few bytes changed
+			memcpy(base, data, len);
+			for (k = 0; k < len / 16 + 1; k++)
+				base[rand() % len] ^= 1 + rand() % 255;
+		}
+
+		bound = len + 10 * (len / 3 + 1);
+		n = wire_encode(data, delta ? base : NULL, len, out, sizeof(out));
+		CHECK((n >= 0) && (n <= bound), "round %d (len %d, kind %d, delta %d): %d bytes, bound %d", r, len, kind, delta, n, bound);
+		if (n < 0)
+			continue;
+		CHECK((len == 0) || (wire_encode(data, delta ? base : NULL, len, out, n - 1) == -1), "round %d: encoded in %d bytes", r, n - 1);
+
+		memset(back, 0xa5, len);
+		CHECK(wire_decode(out, n, delta ? base : NULL, len, back) == n, "round %d: decoded size", r);
+		CHECK(memcmp(back, data, len) == 0, "round %d (len %d, kind %d, delta %d): data differs", r, len, kind, delta);
+
+		// truncated input never reads past max
+		for (k = (n > 8) ? n - 8 : 0; k < n; k++)
+			CHECK(wire_decode(out, k, delta ? base : NULL, len, back) == -1, "round %d: decoded from %d of %d bytes", r, k, n);
+	}
+
+	// a record coded against its own keyframe is a single zero run
+	fill(data, 1000, 1);
+	n = wire_encode(data, data, 1000, out, sizeof(out));
+	CHECK(n == 3, "unchanged record in %d bytes", n);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	unsigned int seed = (argc > 1) ? atoi(argv[1]) : 1;
+
+	srand(seed);
+	fprintf(stdout, "wire-tester: version %d, seed %u\n", WIRE_VERSION, seed);
+
+	testIntegers();
+	testRecords();
+
+	fprintf(stdout, "%s\n", failures ? "FAILED" : "OK");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
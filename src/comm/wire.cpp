@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA COMM
+ *
+ * CAMBADA COMM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA COMM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "wire.h"
+
+// zero runs shorter than this are cheaper inside the literals
+#define MIN_ZERO_RUN 3
+
+
+void wire_put_u16(unsigned char *buf, unsigned int value)
+{
+	buf[0] = value & 0xff;
+	buf[1] = (value >> 8) & 0xff;
+}
+
+void wire_put_u32(unsigned char *buf, unsigned int value)
+{
+	buf[0] = value & 0xff;
+	buf[1] = (value >> 8) & 0xff;
+	buf[2] = (value >> 16) & 0xff;
+	buf[3] = (value >> 24) & 0xff;
+}
+
+unsigned int wire_get_u16(const unsigned char *buf)
+{
+	return buf[0] | (buf[1] << 8);
+}
+
+unsigned int wire_get_u32(const unsigned char *buf)
+{
+	return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((unsigned int)buf[3] << 24);
+}
+
+
+
+int wire_put_varint(unsigned char *buf, int max, unsigned int value)
+{
+	int n = 0;
+
+	do
+	{
+		if (n == max)
+			return -1;
+		buf[n] = value & 0x7f;
+		value >>= 7;
+		if (value != 0)
+			buf[n] |= 0x80;
+		n ++;
+	} while (value != 0);
+
+	return n;
+}
+
+int wire_get_varint(const unsigned char *buf, int max, unsigned int *value)
+{
+	int n = 0;
+
+	*value = 0;
+	do
+	{
+		if ((n == max) || (n == 5))
+			return -1;
+		*value |= (unsigned int)(buf[n] & 0x7f) << (7 * n);
+	} while (buf[n++] & 0x80);
+
+	return n;
+}
+
+
+
+// byte of data as coded (xor with the base)
+static inline unsigned char coded(const unsigned char *data, const unsigned char *base, int i)
+{
+	return (base == NULL) ? data[i] : data[i] ^ base[i];
+}
+
+int wire_encode(const unsigned char *data, const unsigned char *base, int len, unsigned char *out, int max)
+{
+	int i, start, zeros, literals, run, n, k;
+
+	n = 0;
+	i = 0;
+	while (i < len)
+	{
+		// zero run
+		start = i;
+		while ((i < len) && (coded(data, base, i) == 0))
+			i++;
+		zeros = i - start;
+
+		// literals, up to the next zero run long enough (or the end)
+		start = i;
+		while (i < len)
+		{
+			for (run = 0; (i + run < len) && (run < MIN_ZERO_RUN) && (coded(data, base, i + run) == 0); run++)
+				;
+			if ((run == MIN_ZERO_RUN) || (i + run == len && run > 0))
+				break;
+			i += (run == 0) ? 1 : run;
+		}
+		literals = i - start;
+
+		if ((k = wire_put_varint(out + n, max - n, zeros)) == -1)
+			return -1;
+		n += k;
+		if ((k = wire_put_varint(out + n, max - n, literals)) == -1)
+			return -1;
+		n += k;
+		if (n + literals > max)
+			return -1;
+		for (k = 0; k < literals; k++)
+			out[n + k] = coded(data, base, start + k);
+		n += literals;
+	}
+
+	return n;
+}
+
+int wire_decode(const unsigned char *in, int max, const unsigned char *base, int len, unsigned char *data)
+{
+	unsigned int zeros, literals;
+	int i, n, k;
+
+	n = 0;
+	i = 0;
+	while (i < len)
+	{
+		if ((k = wire_get_varint(in + n, max - n, &zeros)) == -1)
+			return -1;
+		n += k;
+		if ((k = wire_get_varint(in + n, max - n, &literals)) == -1)
+			return -1;
+		n += k;
+		if ((zeros > (unsigned int)(len - i)) || (literals > (unsigned int)(len - i) - zeros) ||
+			(literals > (unsigned int)(max - n)) || (zeros + literals == 0))
+			return -1;
+
+		if (base == NULL)
+			memset(data + i, 0, zeros);
+		else
+			memcpy(data + i, base + i, zeros);
+		i += zeros;
+
+		for (k = 0; k < (int)literals; k++, i++)
+			data[i] = (base == NULL) ? in[n + k] : in[n + k] ^ base[i];
+		n += literals;
+	}
+
+	return n;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA COMM
+ *
+ * CAMBADA COMM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA COMM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _WIRE_H
+#define _WIRE_H
+
+// frame encoding on the air: the header, echoes and record framing are
+// independent of the host byte order; record data is the host struct as is,
+// so the schema hash covers the layout of every shared data type (xrtdb
+// hashes their declarations, alignment and byte order into rtdb.ini) and
+// peers built from different declarations reject each other frames
+//
+//	frame:	version (1) | schema hash (4) | agent (1) | counter (4) | send time (4) | flags (1) |
+//			state table (2 bits per agent) | records (2) | echoes (1) | echo ... | record ...
+//	echo:	agent (1) | its last send time (4) | time since it was received (varint, us)
+//	record:	id (varint) | key (1) | life (varint) | length (varint) | data
+//
+// echoes give each agent the round trip time to the others
+//
+// key has the sequence of the record keyframe in the lower 7 bits, and the
+// WIRE_DELTA bit when data is coded against that keyframe instead of zeros;
+// data is always run coded: zeros (varint) | literals (varint) | literal bytes ...
+
+#define WIRE_VERSION	5
+
+#define WIRE_DELTA		0x80
+#define WIRE_KEY_MASK	0x7f
+
+// frame header offsets
+#define WIRE_HASH		1
+#define WIRE_AGENT		5
+#define WIRE_COUNTER	6
+#define WIRE_TIME		10		// sender monotonic clock (us, lower 32 bits)
+#define WIRE_FLAGS		14
+#define WIRE_STATES		15
+#define WIRE_RECORDS(n_agents)		(WIRE_STATES + ((n_agents) + 3) / 4)
+#define WIRE_HEADER_SIZE(n_agents)	(WIRE_RECORDS(n_agents) + 2)
+
+#define WIRE_ECHO_MAX	10		// bytes of one echo
+
+// flags
+#define WIRE_URGENT		0x01	// out of slot frame, only urgent records (own counter, not in the TDMA)
+#define WIRE_CHANNEL_SHIFT	4	// upper bits: channel (0 = default, with the TDMA)
+
+// worst case of a record with len bytes
+#define WIRE_RECORD_MAX(len)	(5 + 1 + 5 + 5 + (len) + 10 * ((len) / 3 + 1))
+
+
+
+//	*************************
+//  Little endian integers
+//
+void wire_put_u16(unsigned char *buf, unsigned int value);
+void wire_put_u32(unsigned char *buf, unsigned int value);
+unsigned int wire_get_u16(const unsigned char *buf);
+unsigned int wire_get_u32(const unsigned char *buf);
+
+
+
+//	*************************
+//  Variable length unsigned integer (7 bits per byte)
+//
+//  Input:
+//		unsigned char *buf = where to write / read
+//		int max = bytes available in buf
+//  Output:
+//		bytes used
+//		-1 = does not fit / truncated
+//
+int wire_put_varint(unsigned char *buf, int max, unsigned int value);
+int wire_get_varint(const unsigned char *buf, int max, unsigned int *value);
+
+
+
+//	*************************
+//  Run code data, as is (key) or against a base (delta)
+//    bytes equal to the base become zero runs
+//
+//  Input:
+//		const unsigned char *data = data to code
+//		const unsigned char *base = keyframe (NULL = code data as is)
+//		int len = data bytes
+//		unsigned char *out = coded data
+//		int max = bytes available in out
+//  Output:
+//		bytes used in out
+//		-1 = does not fit
+//
+int wire_encode(const unsigned char *data, const unsigned char *base, int len, unsigned char *out, int max);
+
+
+
+//	*************************
+//  Decode run coded data
+//
+//  Input:
+//		const unsigned char *in = coded data
+//		int max = bytes available in in
+//		const unsigned char *base = keyframe (NULL = data was coded as is)
+//		int len = data bytes
+//		unsigned char *data = decoded data (len bytes)
+//  Output:
+//		bytes used from in
+//		-1 = corrupted / truncated
+//
+int wire_decode(const unsigned char *in, int max, const unsigned char *base, int len, unsigned char *data);
+
+#endif
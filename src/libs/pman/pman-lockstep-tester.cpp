@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA PMAN
+ *
+ * CAMBADA PMAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA PMAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Lockstep mode: vision before agent on every step and a slow process every
+ * second step. After each PMAN_sim_wait every released instance must have
+ * finished, with the simulated time of its step. The first step comes as
+ * soon as the processes are attached, while vision is still starting up
+ * (as an agent between PMAN_attach and its first PMAN_wait_activation), so
+ * its first release reaches it before it waits. Then a process that keeps
+ * running past a wait timeout must not be counted twice: the next wait
+ * returns as soon as it finishes and the missed activation is an overrun.
+ */
+
+#include "pman.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <sys/time.h>
+
+#define TESTER_PMAN_KEY	0x9023
+#define STEPS			20
+#define STEP_US			20000LL		// simulated time of a step
+
+static const char *names[] = { "vision", "agent", "slow", "stuck" };
+static const int periods[] = { 1, 1, 2, 1 };
+static const int work[] = { 2000, 3000, 8000, 300000 };
+static const int startup[] = { 300000, 0, 0, 0 };	// between attach and the first wait (us)
+static int failures = 0;
+
+#define CHECK(cond, txt, par...) \
+	do { if (!(cond)) { fprintf(stderr, "FAILED: " txt "\n", ## par); failures++; } } while (0)
+
+static void slave(int p, int fd)
+{
+	struct timeval tv;
+	long long now;
+
+	/* gone with the master, even if it fails */
+	prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+	if ((PMAN_init_sized(TESTER_PMAN_KEY, TESTER_PMAN_KEY, NULL, 0, PMAN_ATTACH, 0, 0) < 0) ||
+		(PMAN_attach((char*)names[p], getpid()) < 0))
+	{
+		fprintf(stderr, "%s: PMAN attach failed\n", names[p]);
+		exit(EXIT_FAILURE);
+	}
+	usleep(startup[p]);
+
+	while (PMAN_wait_activation((char*)names[p]) > 0)
+	{
+		/* simulated time of the step, seen by the process */
+		PMAN_gettime(&tv);
+		now = tv.tv_sec * 1000000LL + tv.tv_usec;
+		if (write(fd, &now, sizeof(now)) != (int)sizeof(now))
+			break;
+		usleep(work[p]);
+		PMAN_epilogue((char*)names[p]);
+	}
+	exit(EXIT_SUCCESS);
+}
+
+static int query(const char *pname, PROC_TYPE *pdata)
+{
+	int r;
+
+	for (r = PMAN_query(pdata, 1); r == 0; r = PMAN_query(pdata, 0))
+		if (strcmp(pdata->PROC_name, pname) == 0)
+			return 0;
+	return -1;
+}
+
+static void waitAttached(int nprocs)
+{
+	PROC_TYPE pdata;
+	int i;
+
+	for (i = 0; i < nprocs; i++)
+		while ((query(names[i], &pdata) != 0) || (pdata.PROC_id == PMAN_NOPID))
+			usleep(1000);
+}
+
+int main()
+{
+	PMAN_QOS_TYPE qos;
+	PROC_TYPE pdata;
+	pid_t pid[4];
+	int fd[2], i, s, r, n;
+	long long simtime, seen[8];
+
+	memset(&qos, 0, sizeof(qos));
+	qos.policy = PMAN_QOS_OTHER;
+
+	if (PMAN_init_sized(TESTER_PMAN_KEY, TESTER_PMAN_KEY, (void *)linux_sched_qos, sizeof(PMAN_QOS_TYPE), PMAN_NEW, 8, 8))
+	{
+		fprintf(stderr, "ERROR: PMAN_init failed\n");
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < 3; i++)
+		CHECK(PMAN_procadd((char*)names[i], PMAN_NOPID, periods[i], 0, 0, &qos, sizeof(qos)) == 0, "procadd %s", names[i]);
+	CHECK(PMAN_prec_add((char*)"vision", (char*)"agent") == 0, "vision -> agent");
+
+	CHECK(PMAN_sim_wait(0) == -2, "sim_wait outside lockstep");
+	CHECK(PMAN_sim_mode(PMAN_SIM_LOCKSTEP) == 0, "sim_mode");
+
+	if (pipe(fd) == -1)
+	{
+		perror("pipe");
+		PMAN_close(PMAN_CLFREE);
+		return EXIT_FAILURE;
+	}
+	fcntl(fd[0], F_SETFL, O_NONBLOCK);
+
+	for (i = 0; i < 3; i++)
+		if ((pid[i] = fork()) == 0)
+			slave(i, fd[1]);
+	waitAttached(3);
+
+	/* a hang is a failure too */
+	alarm(30);
+
+	/* every instance released in a step finishes before the step ends */
+	for (s = 0; s < STEPS; s++)
+	{
+		simtime = 1000000LL + s * STEP_US;
+		PMAN_sim_tick(simtime);
+		CHECK((r = PMAN_sim_wait(2000)) == 0, "step %d: sim_wait returned %d", s, r);
+
+		n = read(fd[0], seen, sizeof(seen));
+		n = (n < 0) ? 0 : n / (int)sizeof(seen[0]);
+		CHECK(n == ((s % 2 == 0) ? 3 : 2), "step %d: %d instances ran", s, n);
+		for (i = 0; i < n; i++)
+			CHECK(seen[i] == simtime, "step %d: instance saw time %lld", s, seen[i]);
+	}
+
+	for (i = 0; i < 3; i++)
+	{
+		CHECK(query(names[i], &pdata) == 0, "query %s", names[i]);
+		CHECK(pdata.PROC_nact == (unsigned int)(STEPS / periods[i]), "%s: %u activations", names[i], pdata.PROC_nact);
+		CHECK(pdata.PROC_status == PROC_S_IDLE, "%s: status %d after the last wait", names[i], pdata.PROC_status);
+		CHECK(pdata.PROC_novr == 0, "%s: %u overruns", names[i], pdata.PROC_novr);
+	}
+
+	/* stuck runs for 300 ms: two waits time out, its next activations are overruns */
+	CHECK(PMAN_procadd((char*)names[3], PMAN_NOPID, periods[3], 0, 0, &qos, sizeof(qos)) == 0, "procadd %s", names[3]);
+	if ((pid[3] = fork()) == 0)
+		slave(3, fd[1]);
+	waitAttached(4);
+
+	for (s = STEPS; s < STEPS + 3; s++)
+	{
+		PMAN_sim_tick(1000000LL + s * STEP_US);
+		r = PMAN_sim_wait(100);
+		fprintf(stdout, "step %d: sim_wait %d\n", s, r);
+	}
+	CHECK(PMAN_sim_wait(0) == 0, "final sim_wait");
+	CHECK((query("stuck", &pdata) == 0) && (pdata.PROC_nact == 1) && (pdata.PROC_novr == 2),
+		"stuck: %u activations, %u overruns", pdata.PROC_nact, pdata.PROC_novr);
+	CHECK(PMAN_sim_wait(0) == 0, "sim_wait with nothing released");
+
+	PMAN_print();
+
+	for (i = 0; i < 4; i++)
+		kill(pid[i], SIGKILL);
+	for (i = 0; i < 4; i++)
+		waitpid(pid[i], NULL, 0);
+
+	PMAN_close(PMAN_CLFREE);
+
+	fprintf(stdout, "%s\n", failures ? "FAILED" : "OK");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -64,7 +64,7 @@ int main(int argc, char *argv[])
 	/* PMAN master initialization */
 	int pmanstat;
 	if((pmanstat = PMAN_init(SHMEM_OCAM_PMAN_KEY, SEM_OCAM_PMAN_KEY,
-	        (void *)linux_sched_fifo, sizeof(int), PMAN_NEW)))
+	        (void *)linux_sched_qos, sizeof(PMAN_QOS_TYPE), PMAN_NEW)))
     {
 		fprintf( stderr, "ERROR: PMAN_init failed (return code %d)\n", 
                 pmanstat );
@@ -76,31 +76,15 @@ int main(int argc, char *argv[])
     /* ???? */
 	fPman = true; // set PMAN cleaning flag
 
-    /* open PMAN configuration file */
-    FILE *fpPman = NULL;
+    /* load process table (policies and CPU affinity from the configuration file) */
     char *pmanFileName = argv[1];
-	if(!(fpPman = fopen(pmanFileName, "r"))) 
+    if (PMAN_conf_load(pmanFileName) < 0)
     {
-		fprintf( stderr, "ERROR: couldn't open configuration file \"%s\" from PMAN\n",
+		fprintf( stderr, "ERROR: couldn't load configuration file \"%s\" from PMAN\n",
                 pmanFileName );
 		Shutdown();
 	}
 
-    /* load process table */
-    char pname[32];
-    int pper, ppha, pddln, pprio;
-    int nv;
-    while ((nv = fscanf(fpPman,"%s %d %d %d %d", pname, &pper, &ppha, &pddln, &pprio)) == 5)
-    {
-        PMAN_procadd(pname, PMAN_NOPID, pper, ppha, pddln, &pprio, sizeof(pprio));
-        #ifdef DEBUG
-        fprintf(stderr, "\n[PMAN master]: process %s (Period = %d, Phase = %d"
-                "Deadline = %d, Priority = %d) added\n", 
-                pname, pper, ppha, pddln, pprio);
-        #endif
-    }
-    fclose(fpPman);
-
     PMAN_print();
 
     /* define precedences */
@@ -136,6 +120,9 @@ int main(int argc, char *argv[])
         fprintf(stdout, "Master: end of cycle: %d\n", timer.elapsed());
     }
 
+    /* keep the trace for pmantrace */
+    PMAN_trace_export(NULL, PMAN_TRACE_FMT_BIN);
+
     /* clean before quit */
     /* to be done after install SIGINT signal handler */
 
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA PMAN
+ *
+ * CAMBADA PMAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA PMAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Precedence DAG: four processes in a diamond (A before B and C, both
+ * before D), activated on every tick. Each instance writes its name to a
+ * pipe when it starts; the master checks the order of every tick and that
+ * a precedence closing a cycle is refused.
+ */
+
+#include "pman.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+
+#define TESTER_PMAN_KEY	0x9021
+#define TICKS			20
+
+static const char *names[] = { "A", "B", "C", "D" };
+static int failures = 0;
+
+#define CHECK(cond, txt, par...) \
+	do { if (!(cond)) { fprintf(stderr, "FAILED: " txt "\n", ## par); failures++; } } while (0)
+
+static void slave(const char *pname, int fd)
+{
+	/* gone with the master, even if it fails */
+	prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+	if ((PMAN_init_sized(TESTER_PMAN_KEY, TESTER_PMAN_KEY, NULL, 0, PMAN_ATTACH, 0, 0) < 0) ||
+		(PMAN_attach((char*)pname, getpid()) < 0))
+	{
+		fprintf(stderr, "%s: PMAN attach failed\n", pname);
+		exit(EXIT_FAILURE);
+	}
+
+	while (PMAN_wait_activation((char*)pname) > 0)
+	{
+		if (write(fd, pname, 1) != 1)
+			break;
+		usleep(2000);
+		PMAN_epilogue((char*)pname);
+	}
+	exit(EXIT_SUCCESS);
+}
+
+int main()
+{
+	PMAN_QOS_TYPE qos;
+	pid_t pid[4];
+	int fd[2], i, t, n;
+	char order[16];
+
+	memset(&qos, 0, sizeof(qos));
+	qos.policy = PMAN_QOS_OTHER;
+
+	if (PMAN_init_sized(TESTER_PMAN_KEY, TESTER_PMAN_KEY, (void *)linux_sched_qos, sizeof(PMAN_QOS_TYPE), PMAN_NEW, 8, 8))
+	{
+		fprintf(stderr, "ERROR: PMAN_init failed\n");
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < 4; i++)
+		CHECK(PMAN_procadd((char*)names[i], PMAN_NOPID, 1, 0, 0, &qos, sizeof(qos)) == 0, "procadd %s", names[i]);
+
+	CHECK(PMAN_prec_add((char*)"A", (char*)"B") == 0, "A -> B");
+	CHECK(PMAN_prec_add((char*)"A", (char*)"C") == 0, "A -> C");
+	CHECK(PMAN_prec_add((char*)"B", (char*)"D") == 0, "B -> D");
+	CHECK(PMAN_prec_add((char*)"C", (char*)"D") == 0, "C -> D");
+	CHECK(PMAN_prec_add((char*)"D", (char*)"A") == -5, "D -> A closes a cycle, must be refused");
+	CHECK(PMAN_prec_add((char*)"A", (char*)"X") == -3, "unknown successor");
+
+	PMAN_print_prec();
+
+	if (pipe(fd) == -1)
+	{
+		perror("pipe");
+		PMAN_close(PMAN_CLFREE);
+		return EXIT_FAILURE;
+	}
+	fcntl(fd[0], F_SETFL, O_NONBLOCK);
+
+	/* slaves in reverse order, so the release order does not come from the attach order */
+	for (i = 3; i >= 0; i--)
+		if ((pid[i] = fork()) == 0)
+			slave(names[i], fd[1]);
+	usleep(200 * 1000);
+
+	for (t = 0; t < TICKS; t++)
+	{
+		PMAN_tick();
+		usleep(50 * 1000);
+
+		n = read(fd[0], order, sizeof(order) - 1);
+		order[(n < 0) ? 0 : n] = '\0';
+		fprintf(stdout, "tick %2d: %s\n", t, order);
+
+		/* A, then B and C in any order, then D */
+		CHECK((strlen(order) == 4) && (order[0] == 'A') && (order[3] == 'D') &&
+			((strncmp(order + 1, "BC", 2) == 0) || (strncmp(order + 1, "CB", 2) == 0)),
+			"tick %d released %s", t, order);
+	}
+
+	for (i = 0; i < 4; i++)
+		kill(pid[i], SIGKILL);
+	for (i = 0; i < 4; i++)
+		waitpid(pid[i], NULL, 0);
+
+	PMAN_close(PMAN_CLFREE);
+
+	fprintf(stdout, "%s\n", failures ? "FAILED" : "OK");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -40,6 +40,11 @@
 #include <sched.h>
 
 #include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <dirent.h>
 
 #include <sem_utils.h>
 #include <pman.h>
@@ -54,6 +59,8 @@
 #define PMAN_DBG(string, args...)
 #endif
 
+#define PMAN_TRACE_SPIN  1000  // Yields PMAN_trace_export waits for an event being written
+
 /* 
  * Global vars
  */
@@ -65,6 +72,138 @@ int pamn_sem_id_LUT[ MAX_MASTER_INSTANCE ];                 // sempahore id look
 int pamn_shmem_id_LUT[ MAX_MASTER_INSTANCE ];               // shared memory id look up table
 PROC_TABLE_TYPE* pman_p_table_LUT[ MAX_MASTER_INSTANCE ];   // proc table address look up table
 
+static int pman_self = PMAN_NOINDEX;  // Index of this process in the table (PMAN_attach)
+
+
+/*
+ * Index of a process in the table (PMAN_NOINDEX if not found)
+ */
+static int pman_find(const char *p_name)
+{
+	int i;
+
+	for(i=0;i<p_table->size;i++)
+		if( strcmp(p_table->proc[i].PROC_name,p_name) == 0)
+			return i;
+
+	return PMAN_NOINDEX;
+}
+
+
+/*
+ * Checks if process to is reached from process from through the precedences
+ * (semaphore held)
+ */
+static int pman_reaches(int from, int to)
+{
+	PROC_PREC_TYPE *prec = PMAN_PREC(p_table);
+	int stack[p_table->size];
+	char visited[p_table->size];
+	int n, i, k;
+
+	memset(visited, 0, sizeof(visited));
+	n = 0;
+	stack[n++] = from;
+	visited[from] = 1;
+	while(n > 0) {
+		i = stack[--n];
+		if(i == to)
+			return 1;
+		for(k=0;k<p_table->nprec;k++)
+			if(prec[k].pred == i && !visited[prec[k].succ]) {
+				visited[prec[k].succ] = 1;
+				stack[n++] = prec[k].succ;
+			}
+	}
+
+	return 0;
+}
+
+
+/*
+ * Rebuilds the release order: the processes in topological order of the
+ * precedences, so predecessors activated in the same tick are released first
+ * (semaphore held; a release running meanwhile may miss a process once)
+ */
+static void pman_order_update(void)
+{
+	PROC_PREC_TYPE *prec = PMAN_PREC(p_table);
+	int *order = PMAN_ORDER(p_table);
+	int indeg[p_table->size];
+	int i, k, head, n;
+
+	n = 0;
+	for(i=0;i<p_table->size;i++) {
+		indeg[i] = p_table->proc[i].PROC_npred;
+		if(p_table->proc[i].PROC_name[0] != 0 && indeg[i] == 0)
+			order[n++] = i;
+	}
+
+	for(head=0;head<n;head++)
+		for(k=0;k<p_table->nprec;k++)
+			if(prec[k].pred == order[head] && --indeg[prec[k].succ] == 0)
+				order[n++] = prec[k].succ;
+
+	__atomic_store_n(&p_table->norder, n, __ATOMIC_RELEASE);
+}
+
+
+#ifdef PMAN_TRACE
+/*
+ * Records a trace event (without the semaphore: each event takes its own slot,
+ * the ring keeps the last PMAN_TRACE_SIZE events)
+ */
+static void pman_trace(int pindex, int etype, unsigned int inst)
+{
+	unsigned int n = __atomic_fetch_add(&p_table->evt_count, 1, __ATOMIC_RELAXED);
+	PROC_TRACE_DATA *evt = &p_table->evt_trace[n % PMAN_TRACE_SIZE];
+	struct timespec now;
+	unsigned int cpu;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if(syscall(SYS_getcpu, &cpu, NULL, NULL))
+		cpu = -1;
+
+	/* Slot being written: seq is set again once the event is complete */
+	__atomic_store_n(&evt->seq, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	evt->pindex = pindex;
+	evt->etype = etype;
+	evt->cpu = cpu;
+	evt->inst = inst;
+	evt->etime = (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+	__atomic_store_n(&evt->seq, n + 1, __ATOMIC_RELEASE);
+}
+#endif
+
+
+/*
+ * Lockstep: one released instance finished (wakes PMAN_sim_wait on the last one)
+ */
+static void pman_sim_done(void)
+{
+	if(__atomic_sub_fetch(&p_table->simbusy, 1, __ATOMIC_ACQ_REL) <= 0)
+		syscall(SYS_futex, &p_table->simbusy, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+
+/*
+ * SIGXCPU handler: the process exceeded its SCHED_DEADLINE runtime
+ */
+static void pman_overrun(int sig)
+{
+	int i = pman_self;
+
+	(void)sig;
+	if(p_table == NULL || i == PMAN_NOINDEX)
+		return;
+
+	__atomic_fetch_add(&p_table->proc[i].PROC_novr, 1, __ATOMIC_RELAXED);
+#ifdef PMAN_TRACE
+	pman_trace(i, 'O', __atomic_load_n(&p_table->proc[i].PROC_nact, __ATOMIC_RELAXED));
+#endif
+}
+
 
 /*
  * Initializes the process table
@@ -93,10 +232,18 @@ int PMAN_init(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSda
 
 int PMAN_init2(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSdata_sz, int create_flags)
 {
-	int i,j,sstat;
+	return PMAN_init_sized(shmem_pman_key, sem_pman_key, QoSfun, QoSdata_sz, create_flags,
+			PROC_TABLE_SIZE, PROC_TABLE_SIZE*PMAN_PREC_PER_PROC);
+}
+
+int PMAN_init_sized(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSdata_sz, int create_flags,
+		int table_size, int max_prec)
+{
+	int i,sstat;
 	union dsemun sem_union;
 	struct sched_param proc_sched;
 	struct timeval tv;
+	int prec_offset, order_offset, qos_offset;
 
 	PMAN_DBG("\n [PMAN_init]: shmem_pman_key %x / sem_pman_key %x, QoSfun:%p, QoSdata_sz:%d, create_flags:%d",
 			shmem_pman_key, sem_pman_key, QoSfun, QoSdata_sz, create_flags);
@@ -105,8 +252,16 @@ int PMAN_init2(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSd
 	{
 	case PMAN_NEW:
 
+		if(table_size < 1 || max_prec < 0)
+			return -10;
+
+		/* Table layout: header and process entries, precedences, release order, QoS data */
+		prec_offset = (int)(offsetof(PROC_TABLE_TYPE, proc) + table_size*sizeof(PROC_TYPE));
+		order_offset = prec_offset + max_prec*sizeof(PROC_PREC_TYPE);
+		qos_offset = order_offset + table_size*sizeof(int);
+
 		/* Get shared memory region */
-		pman_shmem_id = shmget((key_t) shmem_pman_key, sizeof(PROC_TABLE_TYPE)+PROC_TABLE_SIZE*QoSdata_sz, 0666 | IPC_CREAT);
+		pman_shmem_id = shmget((key_t) shmem_pman_key, qos_offset+table_size*QoSdata_sz, 0666 | IPC_CREAT);
 		if(pman_shmem_id == -1){
 			fprintf(stderr, "\n [PMAN_init (PMAN_NEW)]: PMAN shmget failed");
 			return -11;
@@ -121,11 +276,11 @@ int PMAN_init2(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSd
 
 		//   printf("\n sizeof: PROC_TABLE_TYPE:%d / int: %d / long:%d", sizeof(PROC_TABLE_TYPE),sizeof(int), sizeof(long));
 
-		PMAN_DBG("\n [PMAN_init (PMAN_NEW)]: PMAN shared memory attached at [%p,%x] (%d bytes)\n",
-				p_table,(void*)p_table+sizeof(PROC_TABLE_TYPE)+PROC_TABLE_SIZE*QoSdata_sz,sizeof(PROC_TABLE_TYPE)+PROC_TABLE_SIZE*QoSdata_sz);
-		PMAN_DBG("\n [PMAN_init (PMAN_NEW)]: PMAN process data [%p,%x]",p_table,(void*)p_table+sizeof(PROC_TABLE_TYPE)-1);
-		PMAN_DBG("\n [PMAN_init (PMAN_NEW)]: QoS process data [%x,%x]",
-				(void*)p_table+sizeof(PROC_TABLE_TYPE),(void*)p_table+sizeof(PROC_TABLE_TYPE)+PROC_TABLE_SIZE*QoSdata_sz-1);
+		PMAN_DBG("\n [PMAN_init (PMAN_NEW)]: PMAN shared memory attached at %p (%d bytes)\n",
+				p_table,qos_offset+table_size*QoSdata_sz);
+		PMAN_DBG("\n [PMAN_init (PMAN_NEW)]: PMAN process data [%p,%p]",p_table,(void*)p_table+prec_offset-1);
+		PMAN_DBG("\n [PMAN_init (PMAN_NEW)]: QoS process data [%p,%p]",
+				(void*)p_table+qos_offset,(void*)p_table+qos_offset+table_size*QoSdata_sz-1);
 
 
 		/* Init process table */
@@ -133,8 +288,18 @@ int PMAN_init2(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSd
 		p_table->ticks = 0;
 		p_table->QoSupd = QoSfun;
 		p_table->DdlnExcpt = NULL;
-
-		for(i=0;i<PROC_TABLE_SIZE;i++)
+		p_table->size = table_size;
+		p_table->maxprec = max_prec;
+		p_table->nprec = 0;
+		p_table->norder = 0;
+		p_table->prec_offset = prec_offset;
+		p_table->order_offset = order_offset;
+		p_table->qos_size = QoSdata_sz;
+		p_table->simmode = PMAN_SIM_WALL;
+		p_table->simbusy = 0;
+		p_table->simtime = 0;
+
+		for(i=0;i<table_size;i++)
 		{
 			p_table->proc[i].PROC_name[0]=0;
 			p_table->proc[i].PROC_id = PMAN_NOPID;
@@ -142,17 +307,15 @@ int PMAN_init2(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSd
 			p_table->proc[i].PROC_phase = 0;
 			p_table->proc[i].PROC_deadline = 0;
 
-			for(j=0;j<PMAN_MAX_PRED;j++)
-				p_table->proc[i].PROC_pred_name[j][0]=0;
-			for(j=0;j<PMAN_MAX_SUCC;j++)
-				p_table->proc[i].PROC_succ_index[j]=PMAN_NOINDEX;
-			p_table->proc[i].PROC_pred_mask=0;
-			p_table->proc[i].PROC_pred_met=0;
+			p_table->proc[i].PROC_npred=0;
 
-			p_table->proc[i].PROC_qosdata= sizeof(PROC_TABLE_TYPE)+i*QoSdata_sz;
+			p_table->proc[i].PROC_qosdata= qos_offset+i*QoSdata_sz;
 
 			p_table->proc[i].PROC_qosupdflag=0;
 
+			p_table->proc[i].PROC_actmode = PMAN_ACT_SIGNAL;
+			p_table->proc[i].PROC_actword = 0;
+
 			tv.tv_sec=tv.tv_usec =0;
 			p_table->proc[i].PROC_last_start = tv;
 			p_table->proc[i].PROC_last_finish = tv;
@@ -160,12 +323,16 @@ int PMAN_init2(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSd
 			p_table->proc[i].PROC_status = PROC_S_EMPTY;
 			p_table->proc[i].PROC_nact = 0;
 			p_table->proc[i].PROC_ndm = 0;
+			p_table->proc[i].PROC_novr = 0;
+
+		}
 
 #ifdef PMAN_TRACE
-			p_table->evt_firstindex = 0;
-			p_table->evt_lastindex = 0;
+		p_table->evt_count = 0;
+		p_table->evt_saved = 0;
+		for(i=0;i<PMAN_TRACE_SIZE;i++)
+			p_table->evt_trace[i].seq = 0;
 #endif
-		}
 
 
 		/* Create and init semaphore */
@@ -195,8 +362,8 @@ int PMAN_init2(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSd
 
 	case PMAN_ATTACH:
 
-		/* Create shared memory region */
-		pman_shmem_id = shmget((key_t) shmem_pman_key, sizeof(PROC_TABLE_TYPE), 0666 | IPC_CREAT);
+		/* Get the shared memory region created by the manager (its size is in the table) */
+		pman_shmem_id = shmget((key_t) shmem_pman_key, 0, 0666);
 		if(pman_shmem_id == -1){
 			fprintf(stderr, "\n [PMAN_init (PMAN_ATTACH)]: PMAN shmget failed");
 			return -16;
@@ -208,7 +375,7 @@ int PMAN_init2(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSd
 			return -17;
 		}
 
-		PMAN_DBG("\n [PMAN_init (PMAN_ATTACH)]: PMAN shared memory attached at [%p,%x] (%d bytes)\n", p_table,(void*)p_table+sizeof(PROC_TABLE_TYPE),sizeof(PROC_TABLE_TYPE));
+		PMAN_DBG("\n [PMAN_init (PMAN_ATTACH)]: PMAN shared memory attached at %p (%d processes)\n", p_table, p_table->size);
 
 		/* Get semaphore ID*/
 		pman_sem_id = semget((key_t)sem_pman_key,1,0666);
@@ -259,7 +426,7 @@ int PMAN_close(int close_flags)
 		sem_pwait(pman_sem_id);
 
 		/* Kills every registered processes */
-		for(i=0;i<PROC_TABLE_SIZE;i++)
+		for(i=0;i<p_table->size;i++)
 			if(p_table->proc[i].PROC_id != PMAN_NOPID)
 			{
 				sstat=kill(p_table->proc[i].PROC_id, SIGINT);
@@ -306,9 +473,9 @@ int PMAN_close(int close_flags)
  * Input args: (global var) *p_table : pointer to the process table data structure
  *              p_name                : process name (string)
  *              p_id                  : process id (OS PID)
- *              p_period              : process period (ticks)
+ *              p_period              : process period (ticks; 0: never activated)
  *              p_phase               : process initial phase (ticks)
- *              p_deadline            : process deadline (ticks)
+ *              p_deadline            : process deadline (us)
  *              p_QoSdata             : pointer to process QoS data
  *              p_QoSdata_sz          : size of QoS data sttructure
  *
@@ -316,6 +483,7 @@ int PMAN_close(int close_flags)
  *              -1 : invalid process table pointer (null) 
  *              -2 : process table full
  *              -3 : duplicated process id
+ *              -4 : QoS data larger than the table's
  */
 int PMAN_procadd(char * p_name, int p_id,int p_period, int p_phase, int p_deadline, void * p_QoSdata, int p_QoSdata_sz)
 {
@@ -333,16 +501,19 @@ int PMAN_procadd(char * p_name, int p_id,int p_period, int p_phase, int p_deadli
 	if(p_table == NULL)
 		return -1;
 
-	if(p_table->nprocs == PROC_TABLE_SIZE)
+	if(p_table->nprocs == p_table->size)
 		return -2;
 
+	if(p_QoSdata_sz > p_table->qos_size)
+		return -4;
+
 	sem_pwait(pman_sem_id);
 
 	/* Search for a free slot in the PT and check against duplicated process ids */
 	free_index = -1;
 	//unused: dup_flag = 0;
 
-	for(i=0;i<PROC_TABLE_SIZE;i++)
+	for(i=0;i<p_table->size;i++)
 	{
 		if(p_table->proc[i].PROC_name[0] == 0 && free_index == -1)
 			free_index = i;
@@ -379,8 +550,11 @@ int PMAN_procadd(char * p_name, int p_id,int p_period, int p_phase, int p_deadli
 	p_table->proc[free_index].PROC_status = PROC_S_IDLE;
 	p_table->proc[free_index].PROC_nact = 0;
 	p_table->proc[free_index].PROC_ndm = 0;
+	p_table->proc[free_index].PROC_novr = 0;
+	p_table->proc[free_index].PROC_npred = 0;
 
 	(p_table->nprocs)++;
+	pman_order_update();
 
 
 	sem_psignal(pman_sem_id);
@@ -399,7 +573,8 @@ int PMAN_procadd(char * p_name, int p_id,int p_period, int p_phase, int p_deadli
  */
 int PMAN_procdel(char *p_name)
 {
-	int i;
+	int i, k, n;
+	PROC_PREC_TYPE *prec;
 
 	PMAN_DBG("\n PMAN_procdel called (p_table:%p  p_name:%s)",p_table, p_name);
 
@@ -408,7 +583,7 @@ int PMAN_procdel(char *p_name)
 
 	sem_pwait(pman_sem_id);
 
-	for(i=0;i<PROC_TABLE_SIZE;i++)
+	for(i=0;i<p_table->size;i++)
 
 		if( strcmp(p_table->proc[i].PROC_name,p_name) == 0)
 		{
@@ -418,7 +593,20 @@ int PMAN_procdel(char *p_name)
 			p_table->proc[i].PROC_name[0] = 0;
 			p_table->proc[i].PROC_id = PMAN_NOPID;
 
+			/* Remove its precedences */
+			prec = PMAN_PREC(p_table);
+			for(k=0, n=0;k<p_table->nprec;k++)
+				if(prec[k].pred == i || prec[k].succ == i) {
+					if(prec[k].pred == i)
+						p_table->proc[prec[k].succ].PROC_npred--;
+				}
+				else
+					prec[n++] = prec[k];
+			p_table->nprec = n;
+			p_table->proc[i].PROC_npred = 0;
+
 			(p_table->nprocs)--;
+			pman_order_update();
 
 			sem_psignal(pman_sem_id);
 			return 0;
@@ -443,6 +631,7 @@ int PMAN_procdel(char *p_name)
 int PMAN_attach(char *p_name, pid_t p_id)
 {
 	int i;
+	struct sigaction sa;
 
 	PMAN_DBG("\n PMAN_attach called (p_table:%p  p_name:%s p_id:%d)",p_table, p_name, p_id);
 
@@ -453,12 +642,24 @@ int PMAN_attach(char *p_name, pid_t p_id)
 
 	sem_pwait(pman_sem_id);
 
-	for (i=0; i<PROC_TABLE_SIZE; i++)
+	for (i=0; i<p_table->size; i++)
 	{
 		if (strcmp(p_table->proc[i].PROC_name, p_name) == 0)
 		{
 			p_table->proc[i].PROC_id = p_id;
 			p_table->proc[i].PROC_qosupdflag=1; // Update process QoS on next activation
+			p_table->proc[i].PROC_actmode = PMAN_ACT_SIGNAL; // Until it calls PMAN_wait_activation
+
+			/* Runtime overruns (SIGXCPU, SCHED_DEADLINE) are counted, unless the process handles them */
+			if(p_id == getpid()) {
+				pman_self = i;
+				if(sigaction(SIGXCPU, NULL, &sa) == 0 && sa.sa_handler == SIG_DFL) {
+					sa.sa_handler = pman_overrun;
+					sigemptyset(&sa.sa_mask);
+					sa.sa_flags = SA_RESTART;
+					sigaction(SIGXCPU, &sa, NULL);
+				}
+			}
 
 			sem_psignal(pman_sem_id);
 			return 0;
@@ -492,7 +693,7 @@ int PMAN_deattach(char *p_name)
 
 	sem_pwait(pman_sem_id);
 
-	for(i=0;i<PROC_TABLE_SIZE;i++)
+	for(i=0;i<p_table->size;i++)
 
 		if( strcmp(p_table->proc[i].PROC_name,p_name) == 0)
 		{
@@ -522,7 +723,8 @@ int PMAN_deattach(char *p_name)
  */
 int PMAN_prec_add(char *p_name_pred, char *p_name_succ)
 {
-	int i, pred_index, succ_index;
+	int k, pred_index, succ_index;
+	PROC_PREC_TYPE *prec;
 
 	PMAN_DBG("\n PMAN_prec_define called (p_table:%p  p_name_pred:%s p_name_succ:%s)",p_table, p_name_pred, p_name_succ);
 
@@ -532,61 +734,48 @@ int PMAN_prec_add(char *p_name_pred, char *p_name_succ)
 	sem_pwait(pman_sem_id);
 
 	/* Look for sucessor position on PMAN table */
-	succ_index=PMAN_NOINDEX;
-	for(i=0;i<PROC_TABLE_SIZE;i++)
-		if( strcmp(p_table->proc[i].PROC_name,p_name_succ) == 0) {
-			succ_index=i;
-			break;
-		}
-
-	if(succ_index==PMAN_NOINDEX) { // Successor process not found !
+	if((succ_index = pman_find(p_name_succ)) == PMAN_NOINDEX) { // Successor process not found !
 		sem_psignal(pman_sem_id);
 		return -3;
 	}
 	/* Look for predecessor in PMAN table */
-	pred_index=PMAN_NOINDEX;
-	for(i=0;i<PROC_TABLE_SIZE;i++)
-		if( strcmp(p_table->proc[i].PROC_name,p_name_pred) == 0) {
-			pred_index=i;
-			break;
-		}
-
-	if(pred_index==PMAN_NOINDEX) { // Predecessor process not found !
+	if((pred_index = pman_find(p_name_pred)) == PMAN_NOINDEX) { // Predecessor process not found !
 		sem_psignal(pman_sem_id);
 		return -2;
 	}
 
-	/* Update pred_name and succ_index arrays */
-	for(i=0;i<PMAN_MAX_PRED;i++)
-		if(p_table->proc[succ_index].PROC_pred_name[i][0] == 0) {
-			strcpy(p_table->proc[succ_index].PROC_pred_name[i],p_name_pred);
-			break;
+	/* Already defined */
+	prec = PMAN_PREC(p_table);
+	for(k=0;k<p_table->nprec;k++)
+		if(prec[k].pred == pred_index && prec[k].succ == succ_index) {
+			sem_psignal(pman_sem_id);
+			return 0;
 		}
 
-	if(i >= PMAN_MAX_PRED) { // Did not found an empty entry to add the predecessor name
+	/* The graph must stay acyclic (the predecessor can not depend on the successor) */
+	if(pman_reaches(succ_index, pred_index)) {
 		sem_psignal(pman_sem_id);
-		return -4;
+		return -5;
 	}
 
-	for(i=0;i<PMAN_MAX_SUCC;i++)
-		if(p_table->proc[pred_index].PROC_succ_index[i] == PMAN_NOINDEX) {
-			p_table->proc[pred_index].PROC_succ_index[i]=succ_index;
-			break;
-		}
-
-	if(i >= PMAN_MAX_SUCC) { // Did not found an empty entry to add the successor index
+	if(p_table->nprec == p_table->maxprec) { // No room for the precedence
 		sem_psignal(pman_sem_id);
 		return -4;
 	}
 
-	/* Update precedence mask of successor process ...  */
-	p_table->proc[succ_index].PROC_pred_met = 0;
-	p_table->proc[succ_index].PROC_pred_mask |= (1 << (pred_index));
+	/* Add the edge; the successor waits for the next instance of the predecessor */
+	prec[p_table->nprec].pred = pred_index;
+	prec[p_table->nprec].succ = succ_index;
+	prec[p_table->nprec].done = 0;
+	prec[p_table->nprec].seen = 0;
+	__atomic_store_n(&p_table->nprec, p_table->nprec+1, __ATOMIC_RELEASE);
+	p_table->proc[succ_index].PROC_npred++;
 
+	pman_order_update();
 
 	/* Done */
 	sem_psignal(pman_sem_id);
-	return -2;
+	return 0;
 }
 
 
@@ -603,6 +792,7 @@ int PMAN_prec_add(char *p_name_pred, char *p_name_succ)
  *             -1 : invalid process table pointer (null) 
  *             -2 : process not found
  *             -3 : invalid when_flag
+ *             -4 : QoS data larger than the table's
  */
 int PMAN_QoSupd(char * p_name, void * QoSdata, int QoSdata_sz, char when_flag)
 {
@@ -614,9 +804,12 @@ int PMAN_QoSupd(char * p_name, void * QoSdata, int QoSdata_sz, char when_flag)
 	if(p_table == NULL)
 		return -1;
 
+	if(QoSdata_sz > p_table->qos_size)
+		return -4;
+
 	sem_pwait(pman_sem_id);
 
-	for(i=0;i<PROC_TABLE_SIZE;i++)
+	for(i=0;i<p_table->size;i++)
 
 		if( strcmp(p_table->proc[i].PROC_name,p_name) == 0)
 		{
@@ -675,7 +868,7 @@ int PMAN_msgupd(char * p_name, int p_period, int p_phase, int p_deadline, char w
 
 	sem_pwait(pman_sem_id);
 
-	for(i=0;i<PROC_TABLE_SIZE;i++)
+	for(i=0;i<p_table->size;i++)
 		if( strcmp(p_table->proc[i].PROC_name,p_name) == 0)
 		{
 			if((which_flag & PMAN_UPD_PERIOD) && (p_period > 0))
@@ -710,60 +903,117 @@ int PMAN_msgupd(char * p_name, int p_period, int p_phase, int p_deadline, char w
  */
 int PMAN_epilogue(char *p_name)
 {
-	int i,j, succ_index, check_preced_flag=0;
+	int i, k, nprec, status, check_preced_flag=0;
+	long dur;
+	PROC_PREC_TYPE *prec;
 
 	PMAN_DBG("\n PMAN_epilogue called (p_table:%p  p_name:%s)", p_table, p_name);
 
 	if(p_table == NULL)
 		return -1;
 
-	sem_pwait(pman_sem_id);
+	/* No semaphore: the process only changes its own status and the counters of its precedences */
+	if((i = pman_find(p_name)) == PMAN_NOINDEX)
+		return -2; // Process not found
 
-	for(i=0;i<PROC_TABLE_SIZE;i++)
+	/* Update process status and finish time */
+	gettimeofday(&p_table->proc[i].PROC_last_finish, NULL);
+	status = __atomic_exchange_n(&p_table->proc[i].PROC_status, PROC_S_IDLE, __ATOMIC_ACQ_REL);
 
-		if( strcmp(p_table->proc[i].PROC_name,p_name) == 0)
-		{
-			/* Update process status and finish time */
-			p_table->proc[i].PROC_status = PROC_S_IDLE; //
-			gettimeofday(&p_table->proc[i].PROC_last_finish, NULL);
+	/* Deadline miss: the instance took longer than the deadline since its release */
+	dur = (p_table->proc[i].PROC_last_finish.tv_sec - p_table->proc[i].PROC_last_start.tv_sec) * 1000000L
+		+ (p_table->proc[i].PROC_last_finish.tv_usec - p_table->proc[i].PROC_last_start.tv_usec);
+	if(p_table->proc[i].PROC_deadline > 0 && dur > p_table->proc[i].PROC_deadline)
+		__atomic_fetch_add(&p_table->proc[i].PROC_ndm, 1, __ATOMIC_RELAXED);
 
 #ifdef PMAN_TRACE
-			p_table->evt_trace[p_table->evt_lastindex].pindex=i;
-			p_table->evt_trace[p_table->evt_lastindex].etype='E';
-			p_table->evt_trace[p_table->evt_lastindex].etime=p_table->proc[i].PROC_last_finish;
-			p_table->evt_lastindex=(p_table->evt_lastindex+1) % PMAN_TRACE_SIZE;
-			if(p_table->evt_lastindex == p_table->evt_firstindex)
-				p_table->evt_firstindex+=1;
+	pman_trace(i, 'E', __atomic_load_n(&p_table->proc[i].PROC_nact, __ATOMIC_RELAXED));
 #endif
 
-			/* Check for successors */
-			for(j=0;j<PMAN_MAX_SUCC;j++)
-				if( (succ_index = p_table->proc[i].PROC_succ_index[j]) != PMAN_NOINDEX) // Dependent process found!
-				{
-					p_table->proc[succ_index].PROC_pred_met |=  (1 << i); // Mark precedence as met
-					check_preced_flag = 1; // Must check if successor process can be released
-				}
-
-			break; // Done
+	/* Mark the precedences of its successors as met */
+	prec = PMAN_PREC(p_table);
+	nprec = __atomic_load_n(&p_table->nprec, __ATOMIC_ACQUIRE);
+	for(k=0;k<nprec;k++)
+		if(prec[k].pred == i) {
+			__atomic_fetch_add(&prec[k].done, 1, __ATOMIC_RELEASE);
+			check_preced_flag = 1; // Must check if successor process can be released
 		}
 
-
-	/* Done */
-	sem_psignal(pman_sem_id);
-
 	/* Check if successor processes can be released */
 	if(check_preced_flag)
 		PMAN_release();
 
-	if(i == PROC_TABLE_SIZE)
-		return -2; // Process not found
-	else
-		return 0;
+	/* Lockstep: counted after the successors, so the simulator waits for them too */
+	if(status == PROC_S_READY && __atomic_load_n(&p_table->simmode, __ATOMIC_RELAXED) == PMAN_SIM_LOCKSTEP)
+		pman_sim_done();
+
+	return 0;
+}
+
+
+/*
+ * Waits for the next activation of the process, on its futex word (PMAN_release
+ * increments it). The first call switches the process to this activation mode.
+ *
+ * Input args: (global var) *p_table : pointer to the process table data structure
+ *             p_name                : process name (string)
+ *
+ * Returns:    >0 : number of activations since the last call
+ *             -1 : invalid process table pointer (null)
+ *             -2 : process not found
+ *             -3 : interrupted by a signal
+ */
+int PMAN_wait_activation(char *p_name)
+{
+	static int wait_index = PMAN_NOINDEX;  // Process waiting (one per client process)
+	static unsigned int wait_seen;        // Last value of its futex word
+	unsigned int word;
+	int i;
+
+	PMAN_DBG("\n PMAN_wait_activation called (p_table:%p  p_name:%s)", p_table, p_name);
+
+	if(p_table == NULL)
+		return -1;
+
+	if( (wait_index == PMAN_NOINDEX) || (strcmp(p_table->proc[wait_index].PROC_name,p_name) != 0) ) {
+		sem_pwait(pman_sem_id);
+
+		for(i=0;i<p_table->size;i++)
+			if( strcmp(p_table->proc[i].PROC_name,p_name) == 0)
+				break;
+
+		if(i == p_table->size) {
+			sem_psignal(pman_sem_id);
+			return -2; // Process not found
+		}
+
+		/* From now on, activations only increment the futex word */
+		wait_index = i;
+		wait_seen = __atomic_load_n(&p_table->proc[i].PROC_actword, __ATOMIC_ACQUIRE);
+		__atomic_store_n(&p_table->proc[i].PROC_actmode, PMAN_ACT_FUTEX, __ATOMIC_SEQ_CST);
+
+		/* A release sent before (as a signal, since attach) counts as one activation: its epilogue is still due */
+		if(__atomic_load_n(&p_table->proc[i].PROC_status, __ATOMIC_SEQ_CST) == PROC_S_READY)
+			wait_seen --;
+
+		sem_psignal(pman_sem_id);
+	}
+
+	/* Sleeps while the word is unchanged (no lost wakeup: the kernel checks it again) */
+	while( (word = __atomic_load_n(&p_table->proc[wait_index].PROC_actword, __ATOMIC_ACQUIRE)) == wait_seen )
+		if( (syscall(SYS_futex, &p_table->proc[wait_index].PROC_actword, FUTEX_WAIT, wait_seen, NULL, NULL, 0) == -1) &&
+				(errno == EINTR) )
+			return -3;
+
+	i = word - wait_seen;
+	wait_seen = word;
+
+	return i;
 }
 
 
 /*
- * Queries the contents of the process table 
+ * Queries the contents of the process table
  * 
  * Input args: (global var) *p_table : pointer to the process table data structure
  *                            *pdata : pointer to a process data structure
@@ -790,10 +1040,10 @@ int PMAN_query(PROC_TYPE *pdata, int reset_flag)
 	if(p_table == NULL)
 		return -1;
 
-	if(pti >= PROC_TABLE_SIZE)
+	if(pti >= p_table->size)
 		return 1;
 
-	for(i=pti;i<PROC_TABLE_SIZE;i++)
+	for(i=pti;i<p_table->size;i++)
 		if( p_table->proc[i].PROC_name[0] != 0)
 		{
 			//printf("(found at %d)",i);
@@ -825,12 +1075,12 @@ int PMAN_print(void)
 	if(p_table == NULL)
 		return -1;
 
-	printf("\n         name    ID    Per   Ph     Ddln  *QoSdta    QoSflg Stat  #Act #Dmiss  Start       Finish");
-	for(i=0;i<PROC_TABLE_SIZE;i++)
+	printf("\n         name    ID    Per   Ph     Ddln  *QoSdta    QoSflg Stat  #Act #Dmiss  #Ovr  Start       Finish");
+	for(i=0;i<p_table->size;i++)
 
 		if( p_table->proc[i].PROC_name[0] != 0)
 		{
-			printf("\n [%d] : %5s %5d  %5d %5d %9d %9p %5d %4x %5u %5u %5ld:%5ld %5ld:%5ld",i,\
+			printf("\n [%d] : %5s %5d  %5d %5d %9d %9p %5d %4x %5u %5u %5u %5ld:%5ld %5ld:%5ld",i,\
 					p_table->proc[i].PROC_name,\
 					p_table->proc[i].PROC_id,\
 					p_table->proc[i].PROC_period,\
@@ -841,6 +1091,7 @@ int PMAN_print(void)
 					p_table->proc[i].PROC_status,\
 					p_table->proc[i].PROC_nact,\
 					p_table->proc[i].PROC_ndm,\
+					p_table->proc[i].PROC_novr,\
 					p_table->proc[i].PROC_last_start.tv_sec,\
 					p_table->proc[i].PROC_last_start.tv_usec,\
 					p_table->proc[i].PROC_last_finish.tv_sec,\
@@ -857,63 +1108,251 @@ int PMAN_print(void)
 
 #ifdef PMAN_TRACE
 /*
- * Saves the current trace data 
- * 
+ * Writes the text form of the trace
+ */
+static int pman_trace_write_txt(FILE *f, const PMAN_TRACE_PROC *procs, int nprocs, const PMAN_TRACE_REC *recs, int nrecs)
+{
+	int i;
+
+	fprintf(f,"\n    PName , PInd,EVT,      Instant, CPU, Inst\n");
+	for(i=0;i<nrecs;i++)
+		fprintf(f,"%10s,%5d, %c ,%5ld,%6ld,%4d,%5u\n",
+				recs[i].pindex < nprocs ? procs[recs[i].pindex].name : "?",
+				recs[i].pindex,
+				recs[i].etype,
+				(long)(recs[i].time / 1000000),
+				(long)(recs[i].time % 1000000),
+				recs[i].cpu,
+				recs[i].inst);
+
+	return ferror(f) ? -1 : 0;
+}
+
+
+/*
+ * Writes the trace in the Chrome trace event format (chrome://tracing, Perfetto):
+ * one track per process, a slice from each release to the epilogue of the same
+ * instance and instant events when the slice exceeds the deadline or the
+ * process overruns its SCHED_DEADLINE runtime.
+ */
+static int pman_trace_write_json(FILE *f, const PMAN_TRACE_PROC *procs, int nprocs, const PMAN_TRACE_REC *recs, int nrecs)
+{
+	int i, p, first=1;
+	int64_t *rtime;
+	uint32_t *rinst;
+
+	if( !(rtime = calloc(nprocs + 1, sizeof(*rtime))) || !(rinst = calloc(nprocs + 1, sizeof(*rinst))) ) {
+		free(rtime);
+		return -1;
+	}
+
+	fprintf(f,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for(p=0;p<nprocs;p++)
+		if(procs[p].name[0] != '\0') {
+			fprintf(f,"%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+					first ? "" : ",\n", p, procs[p].name);
+			first = 0;
+		}
+
+	for(i=0;i<nrecs;i++) {
+		p = recs[i].pindex;
+		if(p < 0 || p >= nprocs)
+			continue;
+
+		if(recs[i].etype == 'R') {
+			rtime[p] = recs[i].time;
+			rinst[p] = recs[i].inst;
+			continue;
+		}
+
+		if(recs[i].etype == 'O') {
+			fprintf(f,"%s{\"ph\":\"i\",\"s\":\"t\",\"name\":\"overrun\",\"cat\":\"pman\",\"pid\":1,\"tid\":%d,\"ts\":%lld,"
+					"\"args\":{\"inst\":%u,\"cpu\":%d}}",
+					first ? "" : ",\n", p, (long long)recs[i].time, recs[i].inst, recs[i].cpu);
+			first = 0;
+			continue;
+		}
+
+		/* Epilogue: slice of the instance, if its release is in the trace */
+		if(recs[i].etype != 'E' || rtime[p] == 0 || rinst[p] != recs[i].inst)
+			continue;
+		fprintf(f,"%s{\"ph\":\"X\",\"name\":\"%s\",\"cat\":\"pman\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,"
+				"\"args\":{\"inst\":%u,\"cpu\":%d}}",
+				first ? "" : ",\n", procs[p].name, p, (long long)rtime[p], (long long)(recs[i].time - rtime[p]),
+				recs[i].inst, recs[i].cpu);
+		first = 0;
+		if(procs[p].deadline > 0 && recs[i].time - rtime[p] > procs[p].deadline)
+			fprintf(f,",\n{\"ph\":\"i\",\"s\":\"t\",\"name\":\"deadline miss\",\"cat\":\"pman\",\"pid\":1,\"tid\":%d,\"ts\":%lld,"
+					"\"args\":{\"inst\":%u,\"late\":%lld}}",
+					p, (long long)recs[i].time, recs[i].inst, (long long)(recs[i].time - rtime[p] - procs[p].deadline));
+		rtime[p] = 0;
+	}
+	fprintf(f,"\n]}\n");
+
+	free(rtime);
+	free(rinst);
+	return ferror(f) ? -1 : 0;
+}
+
+
+/*
+ * Writes events to f in the given format
+ *
+ * Returns:     0 : success
+ *             -1 : invalid format or write error
+ */
+int PMAN_trace_write(FILE *f, int format, const PMAN_TRACE_PROC *procs, int nprocs, const PMAN_TRACE_REC *recs, int nrecs)
+{
+	PMAN_TRACE_HDR hdr;
+
+	switch(format) {
+	case PMAN_TRACE_FMT_TXT:
+		return pman_trace_write_txt(f, procs, nprocs, recs, nrecs);
+
+	case PMAN_TRACE_FMT_JSON:
+		return pman_trace_write_json(f, procs, nprocs, recs, nrecs);
+
+	case PMAN_TRACE_FMT_BIN:
+		hdr.magic = PMAN_TRACE_MAGIC;
+		hdr.version = PMAN_TRACE_VERSION;
+		hdr.nprocs = nprocs;
+		hdr.nevents = nrecs;
+		if( fwrite(&hdr, sizeof(hdr), 1, f) != 1
+				|| (nprocs && fwrite(procs, sizeof(*procs), nprocs, f) != (size_t)nprocs)
+				|| (nrecs && fwrite(recs, sizeof(*recs), nrecs, f) != (size_t)nrecs) )
+			return -1;
+		return 0;
+	}
+
+	return -1;
+}
+
+
+/*
+ * Exports the trace events recorded since the last export
+ *
  * Input args: (global var) *p_table : pointer to the process table data structure
- *              
+ *             fname                 : output file (NULL: "<time>-trace.<ext>")
+ *             format                : PMAN_TRACE_FMT_{TXT,JSON,BIN}
+ *
  * Returns:     0 : success
- *             -1 : invalid process table pointer (null) 
- *             -2 : no tarce data to save
+ *             -1 : invalid process table pointer (null)
+ *             -2 : no trace data to save
+ *             -3 : can't create the file (or invalid format)
  */
-int PMAN_trace_save(void)
+int PMAN_trace_export(const char *fname, int format)
 {
-	int i, retval=0;
-	char fname[80];
+	static const char *ext[] = { "txt", "json", "bin" };
+	int i, n, spin, retval=0;
+	unsigned int k, first, end, seq;
+	char dname[80];
 	FILE *flog;
+	PMAN_TRACE_PROC *procs;
+	PMAN_TRACE_REC *recs;
+	PROC_TRACE_DATA *evt;
 
-	PMAN_DBG("\n PMAN_trace_save called (ptable: %p)",p_table);
+	PMAN_DBG("\n PMAN_trace_export called (ptable: %p)",p_table);
 
 	if(p_table == NULL)
 		return -1;
 
+	if(format < PMAN_TRACE_FMT_TXT || format > PMAN_TRACE_FMT_BIN)
+		return -3;
+
+	/* The semaphore only orders the exports: the processes keep tracing, the events are taken up to a snapshot of evt_count */
 	sem_pwait(pman_sem_id);
 
-	/* Save trace buffer */
-	if(p_table->evt_firstindex != p_table->evt_lastindex) {
+	end = __atomic_load_n(&p_table->evt_count, __ATOMIC_ACQUIRE);
+	first = p_table->evt_saved;
+	if(end == first) {
+		sem_psignal(pman_sem_id);
+		return -2;
+	}
+	if(end - first > PMAN_TRACE_SIZE)
+		first = end - PMAN_TRACE_SIZE; // Older events were overwritten
 
+	/* Copy the ring (and the process names) so the file is written from a consistent snapshot */
+	procs = calloc(p_table->size, sizeof(*procs));
+	recs = malloc((end - first) * sizeof(*recs));
+	if(procs == NULL || recs == NULL) {
+		sem_psignal(pman_sem_id);
+		free(procs);
+		free(recs);
+		return -3;
+	}
 
-		sprintf(fname,"%ld-trace.txt",time(NULL));
+	for(i=0;i<p_table->size;i++)
+		if(p_table->proc[i].PROC_status != PROC_S_EMPTY) {
+			strncpy(procs[i].name, p_table->proc[i].PROC_name, PNAME_LEN);
+			procs[i].period = p_table->proc[i].PROC_period;
+			procs[i].deadline = p_table->proc[i].PROC_deadline;
+		}
 
-		if( !(flog=fopen(fname,"wr")) ) {
-			printf("[PMAN_trace_Save] Can't create log file (%s)",fname);
+	for(n=0,k=first;k!=end;k++) {
+		evt = &p_table->evt_trace[k % PMAN_TRACE_SIZE];
 
+		/* An event still being written (its slot taken before the snapshot) is waited for, briefly */
+		for(spin=0;spin < PMAN_TRACE_SPIN;spin++) {
+			seq = __atomic_load_n(&evt->seq, __ATOMIC_ACQUIRE);
+			if(seq != 0 && (int)(seq - (k + 1)) >= 0)
+				break;
+			sched_yield();
 		}
-		else {
-			fprintf(flog,"\n    PName , PInd,EVT,      Instant\n");
-			for(i=p_table->evt_firstindex;i != p_table->evt_lastindex;i=(i+1) % PMAN_TRACE_SIZE) {
-				fprintf(flog,"%10s,%5d, %c ,%5ld,%5ld\n",			\
-						p_table->proc[p_table->evt_trace[i].pindex].PROC_name,	\
-						p_table->evt_trace[i].pindex,				\
-						p_table->evt_trace[i].etype,				\
-						p_table->evt_trace[i].etime.tv_sec,
-						p_table->evt_trace[i].etime.tv_usec);
-			}
+		if(seq != k + 1)
+			continue; // Overwritten by a later event (or its writer died)
+
+		recs[n].time = evt->etime;
+		recs[n].pindex = evt->pindex;
+		recs[n].etype = evt->etype;
+		recs[n].cpu = evt->cpu;
+		recs[n].inst = evt->inst;
+
+		/* Overwritten while copying: dropped */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(__atomic_load_n(&evt->seq, __ATOMIC_RELAXED) == seq)
+			n++;
+	}
 
-			fclose(flog);
-		}
+	p_table->evt_saved = end;
+
+	sem_psignal(pman_sem_id);
 
-		/* Reset indexes */
-		p_table->evt_firstindex=0;
-		p_table->evt_lastindex=0;
+	if(fname == NULL) {
+		sprintf(dname,"%ld-trace.%s",time(NULL),ext[format]);
+		fname = dname;
 	}
-	else
-		retval = -2;
 
+	if( !(flog=fopen(fname,"w")) ) {
+		printf("[PMAN_trace_export] Can't create log file (%s)",fname);
+		retval = -3;
+	}
+	else {
+		if(PMAN_trace_write(flog, format, procs, p_table->size, recs, n))
+			retval = -3;
+		if(fclose(flog))
+			retval = -3;
+	}
 
-	/* Done */
-	sem_psignal(pman_sem_id);
+	free(procs);
+	free(recs);
 	return retval;
+}
+
+
+/*
+ * Saves the current trace data 
+ * 
+ * Input args: (global var) *p_table : pointer to the process table data structure
+ *              
+ * Returns:     0 : success
+ *             -1 : invalid process table pointer (null) 
+ *             -2 : no tarce data to save
+ */
+int PMAN_trace_save(void)
+{
+	int retval = PMAN_trace_export(NULL, PMAN_TRACE_FMT_TXT);
 
+	return retval == -3 ? 0 : retval;
 }
 #endif
 
@@ -928,45 +1367,31 @@ int PMAN_trace_save(void)
  */
 int PMAN_print_prec(void)
 {
-	int i,j;
+	int i,k;
+	PROC_PREC_TYPE *prec;
 
 	PMAN_DBG("\n PMAN_print_prec called (ptable: %p)",p_table);
 
 	if(p_table == NULL)
 		return -1;
 
-	printf("\n [index] : name  {   process name 1,2,...,n    } { suc ind 1,2,...,n }    pred_mask   pred_met Status");
-	for(i=0;i<PROC_TABLE_SIZE;i++)
-		if( p_table->proc[i].PROC_name[0] != 0) {
-			printf("\n [%5d] : %5s {",i, p_table->proc[i].PROC_name);
-
-			/* Update pred_name and succ_index arrays */
+	prec = PMAN_PREC(p_table);
 
-			for(j=0;j<PMAN_MAX_PRED;j++) {
-				if(p_table->proc[i].PROC_pred_name[j][0] != 0)
-					printf("%5s",p_table->proc[i].PROC_pred_name[j]);
-				else
-					printf("     ");
-				if(j!=(PMAN_MAX_PRED-1))
-					printf(",");
-			}
-
-			printf("} {");
-
-			for(j=0;j<PMAN_MAX_SUCC;j++) {
-				if(p_table->proc[i].PROC_succ_index[j] != PMAN_NOINDEX)
-					printf("%3d",p_table->proc[i].PROC_succ_index[j]);
-				else
-					printf("   ");
-
-				if(j!=(PMAN_MAX_SUCC-1))
-					printf(",");
-			}
+	printf("\n [index] : name  #pred { predecessor (instances done/seen) ... } Status");
+	for(i=0;i<p_table->size;i++)
+		if( p_table->proc[i].PROC_name[0] != 0) {
+			printf("\n [%5d] : %5s %5d {",i, p_table->proc[i].PROC_name, p_table->proc[i].PROC_npred);
 
-			printf("} %8lx    %8lx   %5d",p_table->proc[i].PROC_pred_mask, \
-					p_table->proc[i].PROC_pred_met, p_table->proc[i].PROC_status);
+			for(k=0;k<p_table->nprec;k++)
+				if(prec[k].succ == i)
+					printf(" %5s (%u/%u)",p_table->proc[prec[k].pred].PROC_name, prec[k].done, prec[k].seen);
 
+			printf(" } %5d", p_table->proc[i].PROC_status);
 		}
+
+	printf("\n Release order:");
+	for(k=0;k<p_table->norder;k++)
+		printf(" %s",p_table->proc[PMAN_ORDER(p_table)[k]].PROC_name);
 	printf("\n");
 
 	/* Done */
@@ -986,43 +1411,63 @@ int PMAN_print_prec(void)
  */
 int PMAN_tick(void)
 {
-	int i, check_release_flag=0;
+	int i, ticks, status, check_release_flag=0;
 
 	PMAN_DBG("\n PMAN_tick called (ptable: %p ). Activated processes:",p_table);
 
 	if(p_table == NULL)
 		return -1;
 
-	sem_pwait(pman_sem_id);
+	/* No semaphore: only the process status changes, atomically */
+	ticks = p_table->ticks;
 
 	/* Scans the process table and activates processes*/
-	for(i=0;i<PROC_TABLE_SIZE;i++)
+	for(i=0;i<p_table->size;i++)
 	{
 		if(p_table->proc[i].PROC_id != PMAN_NOPID)
-		{ /* Filled PT slot: check if process ready */
-			if( ( (p_table->ticks - p_table->proc[i].PROC_phase) % p_table->proc[i].PROC_period) == 0)
+		{
+			if(p_table->proc[i].PROC_period <= 0)
+			{ /* Not activated by pman: only its QoS is applied */
+				if(__atomic_exchange_n(&p_table->proc[i].PROC_qosupdflag, 0, __ATOMIC_ACQ_REL))
+					(*p_table->QoSupd)(i);
+				continue;
+			}
+
+			/* Filled PT slot: check if process ready */
+			if( ( (ticks - p_table->proc[i].PROC_phase) % p_table->proc[i].PROC_period) == 0)
 			{
-				if(p_table->proc[i].PROC_qosupdflag) // Check for pending QoS update requests with PMAN_ONNEXTACT flag
+				// Check for pending QoS update requests with PMAN_ONNEXTACT flag
+				if(__atomic_exchange_n(&p_table->proc[i].PROC_qosupdflag, 0, __ATOMIC_ACQ_REL))
 				{
 					(*p_table->QoSupd)(i); // Update process's QoS
-					p_table->proc[i].PROC_qosupdflag=0; // Reset QoS update flag
 					PMAN_DBG("(QoS update on process %s)", p_table->proc[i].PROC_name);
-
-					//printf("**(QoS update on process %s)**", p_table->proc[i].PROC_name);
 				}
 
-				//printf("[PMAN_tick] process %s ACTIV");
-				p_table->proc[i].PROC_status = PROC_S_ACTIV;
+				if(__atomic_load_n(&p_table->simmode, __ATOMIC_RELAXED) == PMAN_SIM_LOCKSTEP) {
+					/* Lockstep: an instance still released (counted in simbusy) is not activated again, it overruns */
+					status = __atomic_load_n(&p_table->proc[i].PROC_status, __ATOMIC_ACQUIRE);
+					do {
+						if(status == PROC_S_READY || status == PROC_S_ACTIV)
+							break;
+					} while(!__atomic_compare_exchange_n(&p_table->proc[i].PROC_status, &status, PROC_S_ACTIV, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+					if(status == PROC_S_READY || status == PROC_S_ACTIV) {
+						__atomic_fetch_add(&p_table->proc[i].PROC_novr, 1, __ATOMIC_RELAXED);
+#ifdef PMAN_TRACE
+						pman_trace(i, 'O', __atomic_load_n(&p_table->proc[i].PROC_nact, __ATOMIC_RELAXED));
+#endif
+						PMAN_DBG(" overrun [%s (%d)] ",p_table->proc[i].PROC_name, p_table->proc[i].PROC_id);
+						continue;
+					}
+				}
+				else
+					__atomic_store_n(&p_table->proc[i].PROC_status, PROC_S_ACTIV, __ATOMIC_RELEASE);
 				check_release_flag = 1; // Signals that processes have become ready
 			}
 		}
 	}
 
 	/* Increment tick counter */
-	(p_table->ticks)++;
-
-	/* Release mutex region */
-	sem_psignal(pman_sem_id);
+	__atomic_store_n(&p_table->ticks, ticks+1, __ATOMIC_RELEASE);
 
 	/* Release processes that became ready */
 	if(check_release_flag)
@@ -1035,7 +1480,9 @@ int PMAN_tick(void)
 
 /*
  * Process release: Checks for process activations and precedences and sends activation signals when appropriate
- *               
+ *               Runs without the semaphore, from the tick and from the epilogues: a process
+ *               goes to READY with a compare and swap, so only one of them releases it.
+ *               Processes are scanned in the topological order of the precedences.
  *
  * Input args: (global var) *p_table : pointer to the process table data structure
  *
@@ -1044,59 +1491,84 @@ int PMAN_tick(void)
  */
 int PMAN_release(void)
 {
-	int i;
-
-	int p_killed_index[PROC_TABLE_SIZE];
-	int npid_killed=0;
+	int i, k, j, norder, nprec, status, met, lockstep;
+	unsigned int inst;
+	int *order;
+	PROC_PREC_TYPE *prec;
 
 	PMAN_DBG("\n PMAN_release called (ptable: %p ). Activated processes:",p_table);
 
 	if(p_table == NULL)
 		return -1;
 
-	sem_pwait(pman_sem_id);
+	order = PMAN_ORDER(p_table);
+	prec = PMAN_PREC(p_table);
+	norder = __atomic_load_n(&p_table->norder, __ATOMIC_ACQUIRE);
+	nprec = __atomic_load_n(&p_table->nprec, __ATOMIC_ACQUIRE);
+	unsigned int done[nprec > 0 ? nprec : 1];
 
 	/* Scans the process table and activates processes*/
-	for(i=0;i<PROC_TABLE_SIZE;i++)
-		if( p_table->proc[i].PROC_id != PMAN_NOPID)
-			if( (p_table->proc[i].PROC_status == PROC_S_ACTIV) || (p_table->proc[i].PROC_status == PROC_S_PEND) ) {
-				/* Activate process if activated and precedences met */
-				if( p_table->proc[i].PROC_pred_mask == p_table->proc[i].PROC_pred_met) {
-					p_table->proc[i].PROC_pred_met = 0; // Reset precedence bitmap
-
-					if(kill(p_table->proc[i].PROC_id, PMAN_ACTIVATE_SIG))
-						if(errno == ESRCH) /* Process no longer exists */
-							p_killed_index[npid_killed++] = i;
+	for(k=0;k<norder;k++)
+	{
+		i = order[k];
+		if( p_table->proc[i].PROC_id == PMAN_NOPID)
+			continue;
+
+		status = __atomic_load_n(&p_table->proc[i].PROC_status, __ATOMIC_ACQUIRE);
+		if( (status != PROC_S_ACTIV) && (status != PROC_S_PEND) )
+			continue;
+
+		/* Precedences met: each predecessor finished an instance since the last release */
+		met = 1;
+		for(j=0;j<nprec;j++)
+			if(prec[j].succ == i) {
+				done[j] = __atomic_load_n(&prec[j].done, __ATOMIC_ACQUIRE);
+				if(done[j] == prec[j].seen)
+					met = 0;
+			}
 
-					gettimeofday(&p_table->proc[i].PROC_last_start, NULL);
+		if(!met) {
+			if(status == PROC_S_ACTIV)
+				__atomic_compare_exchange_n(&p_table->proc[i].PROC_status, &status, PROC_S_PEND, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+			PMAN_DBG(" pending [%s (%d)] ",p_table->proc[i].PROC_name, p_table->proc[i].PROC_id);
+			continue;
+		}
 
-#ifdef PMAN_TRACE
-					p_table->evt_trace[p_table->evt_lastindex].pindex=i;
-					p_table->evt_trace[p_table->evt_lastindex].etype='R';
-					p_table->evt_trace[p_table->evt_lastindex].etime=p_table->proc[i].PROC_last_start;
-					p_table->evt_lastindex=(p_table->evt_lastindex+1) % PMAN_TRACE_SIZE;
-					if(p_table->evt_lastindex == p_table->evt_firstindex)
-						p_table->evt_firstindex+=1;
-#endif
+		/* Activate process (unless another release did it meanwhile); in lockstep, counted before it can finish */
+		lockstep = (__atomic_load_n(&p_table->simmode, __ATOMIC_RELAXED) == PMAN_SIM_LOCKSTEP);
+		if(lockstep)
+			__atomic_fetch_add(&p_table->simbusy, 1, __ATOMIC_ACQ_REL);
+		if(!__atomic_compare_exchange_n(&p_table->proc[i].PROC_status, &status, PROC_S_READY, 0, __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE)) {
+			if(lockstep)
+				pman_sim_done();
+			continue;
+		}
 
-					p_table->proc[i].PROC_status = PROC_S_READY;
-					p_table->proc[i].PROC_nact++;
+		/* Instances counted; later ones are for the next release */
+		for(j=0;j<nprec;j++)
+			if(prec[j].succ == i)
+				prec[j].seen = done[j];
 
-					PMAN_DBG(" activated [%s (%d)] ",p_table->proc[i].PROC_name, p_table->proc[i].PROC_id);
-				}
-				else {
-					p_table->proc[i].PROC_status = PROC_S_PEND;
-					PMAN_DBG(" pending [%s (%d)] ",p_table->proc[i].PROC_name, p_table->proc[i].PROC_id);
-				}
+		gettimeofday(&p_table->proc[i].PROC_last_start, NULL);
+		inst = __atomic_add_fetch(&p_table->proc[i].PROC_nact, 1, __ATOMIC_RELAXED);
 
-			}
+#ifdef PMAN_TRACE
+		pman_trace(i, 'R', inst);
+#endif
 
-	/* Exit mutex */
-	sem_psignal(pman_sem_id);
+		/* Against the first PMAN_wait_activation: it sees this READY, or this sees its futex mode (or both) */
+		if(__atomic_load_n(&p_table->proc[i].PROC_actmode, __ATOMIC_SEQ_CST) == PMAN_ACT_FUTEX) {
+			/* Wake the process blocked in PMAN_wait_activation */
+			__atomic_fetch_add(&p_table->proc[i].PROC_actword, 1, __ATOMIC_RELEASE);
+			syscall(SYS_futex, &p_table->proc[i].PROC_actword, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+			if(kill(p_table->proc[i].PROC_id, 0) && (errno == ESRCH)) /* Process no longer exists */
+				PMAN_deattach(p_table->proc[i].PROC_name);
+		}
+		else if(kill(p_table->proc[i].PROC_id, PMAN_ACTIVATE_SIG) && (errno == ESRCH)) /* Process no longer exists */
+			PMAN_deattach(p_table->proc[i].PROC_name);
 
-	/* Detach killed processes */
-	for(i=0;i<npid_killed;i++)
-		PMAN_deattach(p_table->proc[p_killed_index[i]].PROC_name);
+		PMAN_DBG(" activated [%s (%d)] ",p_table->proc[i].PROC_name, p_table->proc[i].PROC_id);
+	}
 
 	return 0;
 }
@@ -1128,3 +1600,332 @@ int linux_sched_fifo(int pindex)
 }
 
 
+
+
+/* SCHED_DEADLINE (not in every libc) */
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE		6
+#endif
+#ifndef SCHED_FLAG_DL_OVERRUN
+#define SCHED_FLAG_DL_OVERRUN	0x04
+#endif
+
+struct pman_sched_attr {
+	uint32_t size;
+	uint32_t sched_policy;
+	uint64_t sched_flags;
+	int32_t  sched_nice;
+	uint32_t sched_priority;
+	uint64_t sched_runtime;   // ns
+	uint64_t sched_deadline;  // ns
+	uint64_t sched_period;    // ns
+};
+
+
+/*
+ * Applies the QoS data to one thread
+ */
+static int pman_sched_task(pid_t tid, const PMAN_QOS_TYPE *qos)
+{
+	struct sched_param proc_sched;
+	struct pman_sched_attr attr;
+	unsigned long mask;
+	int retval = 0;
+
+	/* CPU affinity (threads created later inherit it); the policy is set anyway */
+	if(qos->cpus != 0 && qos->policy != PMAN_QOS_DEADLINE) {
+		mask = qos->cpus;
+		if(syscall(SYS_sched_setaffinity, tid, sizeof(mask), &mask)) {
+			fprintf(stderr,"linux_sched_qos: [QoS]: Error setting the affinity of %d (sched_setaffinity: %s)!\n", tid, strerror(errno));
+			retval = -3;
+		}
+	}
+
+#if _POSIX_PRIORITY_SCHEDULING > 0
+	switch(qos->policy) {
+	case PMAN_QOS_FIFO:
+	case PMAN_QOS_OTHER:
+		proc_sched.sched_priority = (qos->policy == PMAN_QOS_FIFO) ? qos->priority : 0;
+		if(sched_setscheduler(tid, (qos->policy == PMAN_QOS_FIFO) ? SCHED_FIFO : SCHED_OTHER, &proc_sched) == -1) {
+			fprintf(stderr,"linux_sched_qos: [QoS]: Error setting the priority of %d (sched_setscheduler)!\n", tid);
+			return -3;
+		}
+		break;
+
+	case PMAN_QOS_DEADLINE:
+#ifdef SYS_sched_setattr
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.sched_policy = SCHED_DEADLINE;
+		attr.sched_flags = SCHED_FLAG_DL_OVERRUN;
+		attr.sched_runtime = (uint64_t)qos->runtime * 1000;
+		attr.sched_period = (uint64_t)qos->dl_period * 1000;
+		attr.sched_deadline = (uint64_t)(qos->dl_deadline > 0 ? qos->dl_deadline : qos->dl_period) * 1000;
+		if(syscall(SYS_sched_setattr, tid, &attr, 0)) {
+			fprintf(stderr,"linux_sched_qos: [QoS]: Error setting SCHED_DEADLINE on %d (sched_setattr: %s)!\n", tid, strerror(errno));
+			return -3;
+		}
+#else
+		(void)attr;
+		fprintf(stderr,"linux_sched_qos: [QoS]: SCHED_DEADLINE not supported!\n");
+		return -3;
+#endif
+		break;
+
+	default:
+		fprintf(stderr,"linux_sched_qos: [QoS]: Invalid policy %d!\n", qos->policy);
+		return -3;
+	}
+#else
+	(void)proc_sched;
+	(void)attr;
+#endif
+
+	return retval;
+}
+
+
+int linux_sched_qos(int pindex)
+{
+	PMAN_QOS_TYPE qos;
+	pid_t pid;
+	char path[32];
+	DIR *dir;
+	struct dirent *task;
+	int retval = 0;
+
+	/* Tables created with a smaller QoS blob (the priority only) run SCHED_FIFO */
+	memset(&qos, 0, sizeof(qos));
+	memcpy(&qos, (char *)p_table + p_table->proc[pindex].PROC_qosdata,
+			p_table->qos_size < (int)sizeof(qos) ? p_table->qos_size : (int)sizeof(qos));
+	pid = p_table->proc[pindex].PROC_id;
+
+	fprintf(stderr, "\nMaster : <QoS, pindex=%d pid=%d policy=%d prio=%d runtime=%d period=%d cpus=%x>\n",
+			pindex, pid, qos.policy, qos.priority, qos.runtime, qos.dl_period, qos.cpus);
+
+	if(qos.cpus != 0 && qos.policy == PMAN_QOS_DEADLINE)
+		fprintf(stderr, "linux_sched_qos: [QoS]: %s: cpu list ignored for SCHED_DEADLINE (use an exclusive cpuset)\n",
+				p_table->proc[pindex].PROC_name);
+
+	/* Every thread of the process */
+	sprintf(path, "/proc/%d/task", pid);
+	if( !(dir = opendir(path)) )
+		return pman_sched_task(pid, &qos);
+
+	while((task = readdir(dir)) != NULL)
+		if(task->d_name[0] != '.' && pman_sched_task(atoi(task->d_name), &qos))
+			retval = -3;
+
+	closedir(dir);
+	return retval;
+}
+
+
+/*
+ * Parses a cpu list ("1", "0,2-3") into an affinity mask (0 on error)
+ */
+static unsigned int pman_cpu_mask(const char *list)
+{
+	unsigned int mask = 0;
+	int first, last, n;
+
+	while(*list) {
+		if(sscanf(list, "%d%n", &first, &n) != 1)
+			return 0;
+		list += n;
+		last = first;
+		if(*list == '-') {
+			if(sscanf(list + 1, "%d%n", &last, &n) != 1)
+				return 0;
+			list += n + 1;
+		}
+		if(first < 0 || last < first || last >= (int)(8*sizeof(mask)))
+			return 0;
+		for(; first <= last; first++)
+			mask |= 1u << first;
+		if(*list == ',')
+			list++;
+		else if(*list)
+			return 0;
+	}
+
+	return mask;
+}
+
+
+/*
+ * Loads the processes of a pman.conf file
+ *
+ * Input args: (global var) *p_table : pointer to the process table data structure
+ *             fname                 : configuration file
+ *
+ * Returns:   >=0 : number of processes added
+ *             -1 : invalid process table pointer (null)
+ *             -2 : can't open the file
+ */
+int PMAN_conf_load(const char *fname)
+{
+	FILE *fconf;
+	char line[256], pname[PNAME_LEN+1], *tok, *next;
+	int pper, ppha, pddln, n, nline = 0, nadded = 0, ok, sz;
+	PMAN_QOS_TYPE qos;
+
+	if(p_table == NULL)
+		return -1;
+
+	if( !(fconf = fopen(fname, "r")) ) {
+		fprintf(stderr, "[PMAN_conf_load] Can't open %s\n", fname);
+		return -2;
+	}
+
+	/* The table may keep only the priority (QoSdata_sz of PMAN_init) */
+	sz = p_table->qos_size < (int)sizeof(qos) ? p_table->qos_size : (int)sizeof(qos);
+
+	while(fgets(line, sizeof(line), fconf) != NULL) {
+		nline++;
+		if((tok = strchr(line, '#')) != NULL)
+			*tok = '\0';
+
+		memset(&qos, 0, sizeof(qos));
+		qos.policy = PMAN_QOS_FIFO;
+		n = 0;
+		if(sscanf(line, "%32s %d %d %d %d %n", pname, &pper, &ppha, &pddln, &qos.priority, &n) != 5) {
+			if(sscanf(line, "%32s", pname) == 1)
+				fprintf(stderr, "[PMAN_conf_load] %s:%d: expected name period phase deadline priority\n", fname, nline);
+			continue;
+		}
+
+		/* Optional policy and cpu list */
+		ok = 1;
+		for(tok = strtok_r(line + n, " \t\r\n", &next); tok != NULL; tok = strtok_r(NULL, " \t\r\n", &next)) {
+			if(strcmp(tok, "fifo") == 0)
+				qos.policy = PMAN_QOS_FIFO;
+			else if(strcmp(tok, "other") == 0)
+				qos.policy = PMAN_QOS_OTHER;
+			else if(strncmp(tok, "dl:", 3) == 0
+					&& sscanf(tok + 3, "%d/%d/%d", &qos.runtime, &qos.dl_period, &qos.dl_deadline) >= 2
+					&& qos.runtime > 0 && qos.dl_period >= qos.runtime)
+				qos.policy = PMAN_QOS_DEADLINE;
+			else if(strncmp(tok, "cpu:", 4) == 0 && (qos.cpus = pman_cpu_mask(tok + 4)) != 0)
+				;
+			else {
+				fprintf(stderr, "[PMAN_conf_load] %s:%d: invalid field \"%s\"\n", fname, nline, tok);
+				ok = 0;
+			}
+		}
+		if(!ok)
+			continue;
+
+		if(sz < (int)sizeof(qos) && (qos.policy != PMAN_QOS_FIFO || qos.cpus != 0))
+			fprintf(stderr, "[PMAN_conf_load] %s:%d: QoS data of the table too small, %s keeps the priority only\n",
+					fname, nline, pname);
+
+		if((n = PMAN_procadd(pname, PMAN_NOPID, pper, ppha, pddln, &qos, sz)) < 0)
+			fprintf(stderr, "[PMAN_conf_load] %s:%d: PMAN_procadd(%s) failed (return code %d)\n", fname, nline, pname, n);
+		else
+			nadded++;
+	}
+
+	fclose(fconf);
+	return nadded;
+}
+
+
+/*
+ * Selects wall clock or lockstep mode
+ *
+ * Returns:     0 : success
+ *             -1 : invalid process table pointer (null)
+ *             -2 : invalid mode
+ */
+int PMAN_sim_mode(int mode)
+{
+	if(p_table == NULL)
+		return -1;
+
+	if(mode != PMAN_SIM_WALL && mode != PMAN_SIM_LOCKSTEP)
+		return -2;
+
+	sem_pwait(pman_sem_id);
+	p_table->simbusy = 0;
+	p_table->simtime = 0;
+	__atomic_store_n(&p_table->simmode, mode, __ATOMIC_RELEASE);
+	sem_psignal(pman_sem_id);
+
+	return 0;
+}
+
+
+/*
+ * "System tick" at a simulated time (us)
+ */
+int PMAN_sim_tick(long long simtime)
+{
+	if(p_table == NULL)
+		return -1;
+
+	__atomic_store_n(&p_table->simtime, simtime, __ATOMIC_RELEASE);
+	return PMAN_tick();
+}
+
+
+/*
+ * Waits until the processes released in lockstep mode have finished
+ *
+ * Returns:     0 : success
+ *             -1 : invalid process table pointer (null)
+ *             -2 : not in lockstep mode
+ *             -3 : timeout
+ */
+int PMAN_sim_wait(int timeout)
+{
+	struct timespec slice;
+	int i, busy, waited = 0;
+
+	if(p_table == NULL)
+		return -1;
+
+	if(__atomic_load_n(&p_table->simmode, __ATOMIC_ACQUIRE) != PMAN_SIM_LOCKSTEP)
+		return -2;
+
+	/* Sleeps in slices of 100 ms, to notice processes that died while released */
+	slice.tv_sec = 0;
+	slice.tv_nsec = 100000000;
+
+	while((busy = __atomic_load_n(&p_table->simbusy, __ATOMIC_ACQUIRE)) > 0) {
+		if(timeout > 0 && waited >= timeout)
+			return -3;
+
+		if(syscall(SYS_futex, &p_table->simbusy, FUTEX_WAIT, busy, &slice, NULL, 0) == 0 || errno != ETIMEDOUT)
+			continue;
+		waited += 100;
+
+		for(i=0;i<p_table->size;i++)
+			if(p_table->proc[i].PROC_id == PMAN_NOPID || (kill(p_table->proc[i].PROC_id, 0) && errno == ESRCH)) {
+				busy = PROC_S_READY;
+				if(__atomic_compare_exchange_n(&p_table->proc[i].PROC_status, &busy, PROC_S_IDLE, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+					pman_sim_done();
+				if(p_table->proc[i].PROC_id != PMAN_NOPID)
+					PMAN_deattach(p_table->proc[i].PROC_name);
+			}
+	}
+
+	return 0;
+}
+
+
+/*
+ * Current time (simulated in lockstep mode)
+ */
+int PMAN_gettime(struct timeval *tv)
+{
+	long long now;
+
+	if(p_table == NULL || __atomic_load_n(&p_table->simmode, __ATOMIC_ACQUIRE) != PMAN_SIM_LOCKSTEP)
+		return gettimeofday(tv, NULL);
+
+	now = __atomic_load_n(&p_table->simtime, __ATOMIC_ACQUIRE);
+	tv->tv_sec = now / 1000000;
+	tv->tv_usec = now % 1000000;
+	return 0;
+}
@@ -23,8 +23,10 @@
 #ifndef PMAN_H_INCLUDED
 #define PMAN_H_INCLUDED
 
+#include <stdio.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <stdint.h>
 
 /*
  * Defines
@@ -32,6 +34,12 @@
  */
 #define PMAN_ACTIVATE_SIG	SIGCONT		// Signal used to activate processes
 
+#define PMAN_ACT_SIGNAL		0			// Process activated with PMAN_ACTIVATE_SIG
+#define PMAN_ACT_FUTEX		1			// Process activated through its futex word (PMAN_wait_activation)
+
+#define PMAN_SIM_WALL		0			// Processes run on the wall clock
+#define PMAN_SIM_LOCKSTEP	1			// Simulated time (PMAN_sim_tick); the simulator waits for the epilogues (PMAN_sim_wait)
+
 #define PMAN_ATTACH			1			// PMAN_init option: attach to an existing process table
 #define PMAN_NEW			0			// PMAN_init option: initialize a new process table
 
@@ -47,14 +55,13 @@
 #define PMAN_UPD_DEADLINE	0x10		// Update deadline
 
 
-#define PROC_TABLE_SIZE		  20		// Maximum number of processes managed
+#define PROC_TABLE_SIZE		  20		// Default number of processes managed (PMAN_init_sized sets it)
 #define PNAME_LEN		  32		// Maximum length of the process name string
 
 #define PMAN_NOPID		   0		// Process id undefined 
 #define PMAN_NOINDEX		  -1		// Process index in PMAN is undefined 
 
-#define PMAN_MAX_PRED              5    // Maximum number of predecessors that a process may have             
-#define PMAN_MAX_SUCC              5    // Maximum number of successors that a process may have             
+#define PMAN_PREC_PER_PROC         4    // Default room for precedences, per process (PMAN_init_sized sets it)
 
 #define PMAN_NOPENDACT             0    // No pending activation on process
 #define PMAN_PENDACT               1    // Pending activation on process
@@ -67,10 +74,24 @@
 #define PROC_S_PEND		4	// Process activated but with unsatisfied precedences  
 
 
+/* QoS policies (PMAN_QOS_TYPE, applied by linux_sched_qos) */
+#define PMAN_QOS_FIFO           0       // SCHED_FIFO with the given priority
+#define PMAN_QOS_OTHER          1       // SCHED_OTHER (time sharing)
+#define PMAN_QOS_DEADLINE       2       // SCHED_DEADLINE runtime/period/deadline; overruns are counted in PROC_novr
+
+
 /* TRACE parameters */
 #define PMAN_TRACE
 #define PMAN_TRACE_SIZE     10000     // Number of events to record during trace ( events/sec = FPS*SUM(1/Period_i)*2 )
 
+/* Trace export formats */
+#define PMAN_TRACE_FMT_TXT      0       // Text table (PMAN_trace_save)
+#define PMAN_TRACE_FMT_JSON     1       // Chrome trace / Perfetto JSON
+#define PMAN_TRACE_FMT_BIN      2       // Binary (see PMAN_TRACE_HDR), read by pmantrace
+
+#define PMAN_TRACE_MAGIC        0x52544d50  // "PMTR"
+#define PMAN_TRACE_VERSION      2   // 2: event times from CLOCK_MONOTONIC (1: gettimeofday)
+
 
 /*
  * Data types
@@ -78,10 +99,39 @@
  */
 #ifdef PMAN_TRACE
 typedef struct {
+  unsigned int seq;      // Event number + 1, stored last (PMAN_trace_export skips a slot being written)
   int pindex;            // Process index within PMAN table
-  int etype;             // Event type {[R]elease;[E]pilog}
-  struct timeval etime;  // Event time 
+  int etype;             // Event type {[R]elease;[E]pilog;[O]verrun of the runtime budget}
+  int cpu;               // CPU of the caller (the ticking process on R, the process itself on E)
+  unsigned int inst;     // Process instance (PROC_nact) the event belongs to
+  int64_t etime;         // Event time (us, CLOCK_MONOTONIC)
 } PROC_TRACE_DATA;
+
+/*
+ * Binary trace file: a PMAN_TRACE_HDR, nprocs PMAN_TRACE_PROC (indexed by
+ * the pindex of the events) and nevents PMAN_TRACE_REC, in host byte order.
+ */
+typedef struct {
+  uint32_t magic;        // PMAN_TRACE_MAGIC
+  uint32_t version;      // PMAN_TRACE_VERSION
+  uint32_t nprocs;       // Process entries that follow
+  uint32_t nevents;      // Events that follow the process entries
+} PMAN_TRACE_HDR;
+
+typedef struct {
+  char name[PNAME_LEN+1]; // Process name (empty if the entry is not in use)
+  char pad[3];
+  int32_t period;        // Period (ticks)
+  int32_t deadline;      // Deadline (us, 0 if none)
+} PMAN_TRACE_PROC;
+
+typedef struct {
+  int64_t time;          // Event time (us, CLOCK_MONOTONIC; since the epoch in version 1)
+  int32_t pindex;        // Process index
+  int32_t etype;         // Event type {'R','E','O'}
+  int32_t cpu;           // CPU (-1 if unknown)
+  uint32_t inst;         // Process instance
+} PMAN_TRACE_REC;
 #endif
 
 typedef struct {
@@ -93,16 +143,17 @@ typedef struct {
   int    PROC_phase;            // Process initial phase
   int    PROC_deadline;         // Process deadline (in us)
 
-  /* precedence constraints */
-  char   PROC_pred_name[PMAN_MAX_PRED][PNAME_LEN+1]; // Array with the names of the predecessor processes
-  int    PROC_succ_index[PMAN_MAX_SUCC];             // Array with the PMAN table indexes of the successors of the process
-  unsigned long   PROC_pred_mask;                    // bitmap with the index of all the predecessor processes set  
-  unsigned long   PROC_pred_met;                     // bitmap with the index of predecessor processes that had an instance
+  /* precedence constraints (the edges are in the precedence table) */
+  int    PROC_npred;            // Number of predecessors of the process
 
   /* QoS data */
   int    PROC_qosdata;            // Offset to data structure containing QoS specific data
   char   PROC_qosupdflag;         // Flag to signal if qos data has been updated
 
+  /* activation */
+  int    PROC_actmode;            // How the process is activated {PMAN_ACT_SIGNAL, PMAN_ACT_FUTEX}
+  unsigned int PROC_actword;      // Futex word, incremented on every activation
+
   /* Status & statistics data */
   struct timeval PROC_last_start;  // Activation instant (last instance)
   struct timeval PROC_last_finish; // Finish instant (last instance)
@@ -111,22 +162,64 @@ typedef struct {
   
   unsigned int PROC_nact;      // Number of activations
   unsigned int PROC_ndm;       // Number of deadline misses
+  unsigned int PROC_novr;      // Number of runtime budget overruns (SCHED_DEADLINE), or lockstep activations missed while still running
  
 } PROC_TYPE;
 
+/* Precedence: an edge of the precedence DAG */
+typedef struct {
+  int pred;              // Predecessor process index
+  int succ;              // Successor process index
+  unsigned int done;     // Instances finished by the predecessor
+  unsigned int seen;     // Value of done when the successor was last released
+} PROC_PREC_TYPE;
+
+/*
+ * QoS data of linux_sched_qos. The priority comes first, so the blob is
+ * also the int that linux_sched_fifo expects.
+ */
+typedef struct {
+  int priority;          // SCHED_FIFO priority
+  int policy;            // PMAN_QOS_FIFO, PMAN_QOS_OTHER or PMAN_QOS_DEADLINE
+  int runtime;           // SCHED_DEADLINE runtime budget (us)
+  int dl_period;         // SCHED_DEADLINE period (us)
+  int dl_deadline;       // SCHED_DEADLINE relative deadline (us)
+  unsigned int cpus;     // CPU affinity (bit n: CPU n; 0: any CPU)
+} PMAN_QOS_TYPE;
+
+/*
+ * Shared memory: this header and its proc[size] entries, the precedence
+ * table (maxprec edges), the release order (size indexes) and the QoS data.
+ * Tick, release and epilogue run without the semaphore (atomic operations
+ * on the process status and precedence counters); only the calls that
+ * change the tables take it.
+ */
 typedef struct {
   int nprocs;        // Number of active processes registered
   int ticks;         // System "tick" counter
   int (*QoSupd)();   // QoS update function hook
   int (*DdlnExcpt)();// Deadline exception handling hook
-  PROC_TYPE proc[PROC_TABLE_SIZE];
+  int size;          // Number of entries of proc
+  int maxprec;       // Number of entries of the precedence table
+  int nprec;         // Precedences defined
+  int norder;        // Processes in the release order
+  int prec_offset;   // Offset of the precedence table
+  int order_offset;  // Offset of the release order (topological order of the precedence DAG)
+  int qos_size;      // Size of the QoS data of each process
+  int simmode;       // PMAN_SIM_WALL or PMAN_SIM_LOCKSTEP
+  int simbusy;       // Lockstep: instances released and not finished yet (futex word of PMAN_sim_wait)
+  long long simtime; // Lockstep: simulated time (us), set by PMAN_sim_tick
 #ifdef PMAN_TRACE
-  int evt_lastindex;  // Index of last event recorded
-  int evt_firstindex; // Index of first event recorded
+  unsigned int evt_count; // Events recorded (never reset: event n takes slot n % PMAN_TRACE_SIZE)
+  unsigned int evt_saved; // evt_count at the last export
   PROC_TRACE_DATA evt_trace[PMAN_TRACE_SIZE]; // Trace data
 #endif
+  PROC_TYPE proc[1]; // Process table (size entries)
 } PROC_TABLE_TYPE;
 
+#define PMAN_PREC(_t)	((PROC_PREC_TYPE *)((char *)(_t) + (_t)->prec_offset))
+#define PMAN_ORDER(_t)	((int *)((char *)(_t) + (_t)->order_offset))
+
 
 
 /* 
@@ -203,6 +296,20 @@ int PMAN_init(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSda
 int PMAN_init2(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSdata_sz, int create_flags);
 
 
+/**
+ * \brief Initializes the process table, with room for table_size processes
+ *
+ * As PMAN_init2, with the sizes of the tables (PMAN_init2 uses PROC_TABLE_SIZE
+ * and PMAN_PREC_PER_PROC); they are only used with PMAN_NEW, the clients
+ * take them from the table.
+ *
+ * \param table_size number of processes
+ * \param max_prec number of precedences
+ */
+int PMAN_init_sized(key_t shmem_pman_key, key_t sem_pman_key, void * QoSfun, int QoSdata_sz, int create_flags,
+                    int table_size, int max_prec);
+
+
 /**
  * \brief Releases resources allocated by PCSHED lib 
  *
@@ -235,9 +342,9 @@ int PMAN_release(void);
  *
  * \param p_name process name (string)
  * \param p_id  process id (OS PID)
- * \param p_period  process period (ticks)
+ * \param p_period  process period (ticks; 0: never activated, only its QoS is applied)
  * \param p_phase process initial phase (ticks)
- * \param p_deadline process deadline (ticks)
+ * \param p_deadline process deadline (us)
  * \param p_QoSdata  pointer to process QoS data
  * \param p_QoSdata_sz size of QoS data sttructure
  *
@@ -245,6 +352,7 @@ int PMAN_release(void);
  *         -1 : invalid process table pointer (null) 
  *         -2 : process table full
  *         -3 : duplicated process id
+ *         -4 : QoS data larger than the table's (PMAN_init QoSdata_sz)
  */
 int PMAN_procadd(char * p_name, int p_id, int p_period, int p_phase, int p_deadline, void * p_QoSdata, int p_QoSdata_sz);
 
@@ -264,6 +372,9 @@ int PMAN_procdel(char * p_name);
 /**
  * \brief Attaches the process PID of an already registered process 
  *
+ * Also installs a SIGXCPU handler (unless the process has its own) that
+ * counts SCHED_DEADLINE runtime overruns of the process.
+ *
  * \param p_name  process name (string)
  * \param p_id    process id (OS PID)
  *
@@ -289,6 +400,10 @@ int PMAN_deattach(char * p_name);
 /**
  * \brief Defines a precedence constraint for a given process 
  *
+ * The successor is only released after an instance of each one of its
+ * predecessors; processes are released in the topological order of the
+ * precedence graph, which must stay acyclic.
+ *
  * \param p_name_pred          : process name (predecessor)
  * \param p_name_succ          : process name (successor)
  *
@@ -296,7 +411,8 @@ int PMAN_deattach(char * p_name);
  *         -1 : invalid process table pointer (null) 
  *         -2 : predecessor process not found
  *         -3 : successor process not found
- *         -4 : number of predecessors exceeded
+ *         -4 : precedence table full
+ *         -5 : the precedence would close a cycle
  */
 int PMAN_prec_add(char *p_name_pred, char *p_name_succ);
 
@@ -313,6 +429,7 @@ int PMAN_prec_add(char *p_name_pred, char *p_name_succ);
  *         -1 : invalid process table pointer (null) 
  *         -2 : process not found
  *         -3 : invalid when_flag
+ *         -4 : QoS data larger than the table's (PMAN_init QoSdata_sz)
  */
 int PMAN_QoSupd(char * p_name, void * QoSdata, int QoSdata_sz, char when_flag);
 
@@ -346,6 +463,25 @@ int PMAN_msgupd(char * p_name, int p_period, int p_phase, int p_deadline, char w
 int PMAN_epilogue(char *p_name);
 
 
+/**
+ * \brief Waits for the next activation of the process 
+ *
+ * The first call switches the process from signal activation to its futex
+ * word in the process table, so it may run on a normal thread instead of
+ * inside the PMAN_ACTIVATE_SIG handler. Activations are counted, none is lost
+ * while the process is busy; a release sent to the process between
+ * PMAN_attach and the first call is returned as one activation.
+ *
+ * \param p_name                : process name (string)
+ *              
+ * \return >0 : number of activations since the last call
+ *         -1 : invalid process table pointer (null) 
+ *         -2 : process not found
+ *         -3 : interrupted by a signal
+ */
+int PMAN_wait_activation(char *p_name);
+
+
 /**
  * \brief Queries the contents of the process table 
  * 
@@ -379,7 +515,42 @@ int PMAN_print_prec(void);
 
 
 #ifdef PMAN_TRACE
-  int PMAN_trace_save(void);
+/**
+ * \brief Saves the events since the last export as text to "<time>-trace.txt"
+ *
+ * \return  0 : success
+ *         -1 : invalid process table pointer (null)
+ *         -2 : no trace data to save
+ */
+int PMAN_trace_save(void);
+
+/**
+ * \brief Exports the events recorded since the last export
+ *
+ * The ring is not reset: the events are taken from a snapshot of the event
+ * count, so processes keep tracing meanwhile (only the last PMAN_TRACE_SIZE
+ * events are kept, older ones are lost).
+ * Epilogues are paired with the release of the same instance; the JSON
+ * form has one slice per instance (one track per process) and an instant
+ * event for each deadline miss.
+ *
+ * \param fname   output file (NULL: "<time>-trace.{txt,json,bin}")
+ * \param format  PMAN_TRACE_FMT_TXT, PMAN_TRACE_FMT_JSON or PMAN_TRACE_FMT_BIN
+ *
+ * \return  0 : success
+ *         -1 : invalid process table pointer (null)
+ *         -2 : no trace data to save
+ *         -3 : can't create the file (or invalid format)
+ */
+int PMAN_trace_export(const char *fname, int format);
+
+/**
+ * \brief Writes events to f in the given format (used by PMAN_trace_export and pmantrace)
+ *
+ * \return  0 : success
+ *         -1 : invalid format or write error
+ */
+int PMAN_trace_write(FILE *f, int format, const PMAN_TRACE_PROC *procs, int nprocs, const PMAN_TRACE_REC *recs, int nrecs);
 #endif
 
 
@@ -396,9 +567,97 @@ int PMAN_print_prec(void);
 int PMAN_tick(void);  
 
 
+/**
+ * \brief Loads the processes of a pman.conf file into the process table
+ *
+ * One process per line (# starts a comment):
+ *
+ *   name period phase deadline priority [fifo|other|dl:runtime/period[/deadline]] [cpu:list]
+ *
+ * Period and phase are in ticks, deadlines and the SCHED_DEADLINE parameters
+ * in us (the SCHED_DEADLINE deadline defaults to its period). The cpu list
+ * is like "1" or "0,2-3". A process with period 0 is never activated by
+ * pman; it attaches only to have its QoS applied (e.g. comm).
+ *
+ * \param fname : configuration file
+ *
+ * \return >=0 : number of processes added
+ *          -1 : invalid process table pointer (null)
+ *          -2 : can't open the file
+ */
+int PMAN_conf_load(const char *fname);
+
+
+/**
+ * \brief Selects wall clock or lockstep (simulated time) mode; called by the
+ * master before the first tick
+ *
+ * In lockstep the master gives the simulated time to every tick
+ * (PMAN_sim_tick) and waits with PMAN_sim_wait until the processes it
+ * released have finished (PMAN_epilogue) before it advances the simulation,
+ * so runs do not depend on the host load and go as fast as the CPUs allow.
+ * A process still running (or not yet released) at its next activation is
+ * not activated again; the activation is counted in PROC_novr.
+ *
+ * \param mode : PMAN_SIM_WALL or PMAN_SIM_LOCKSTEP
+ *
+ * \return  0 : success
+ *         -1 : invalid process table pointer (null)
+ *         -2 : invalid mode
+ */
+int PMAN_sim_mode(int mode);
+
+/**
+ * \brief "System tick" at a simulated time (lockstep mode)
+ *
+ * \param simtime : simulated time (us)
+ *
+ * \return  as PMAN_tick
+ */
+int PMAN_sim_tick(long long simtime);
+
+/**
+ * \brief Waits until every process released in lockstep mode has called
+ * PMAN_epilogue (processes that died meanwhile are detached)
+ *
+ * Processes pending on precedences do not hold the wait until released.
+ *
+ * \param timeout : maximum wait (ms, 0: no limit)
+ *
+ * \return  0 : success
+ *         -1 : invalid process table pointer (null)
+ *         -2 : not in lockstep mode
+ *         -3 : timeout (processes still running)
+ */
+int PMAN_sim_wait(int timeout);
+
+/**
+ * \brief Current time: the simulated time in lockstep mode, the wall clock
+ * otherwise (or without a process table)
+ *
+ * \return  0 : success
+ */
+int PMAN_gettime(struct timeval *tv);
+
+
 /** \todo Is function linux_sched_fifo public? */
 int linux_sched_fifo(int pindex);
 
+/**
+ * \brief QoS hook: applies the PMAN_QOS_TYPE of a process (policy and CPU
+ * affinity) to all its threads
+ *
+ * SCHED_DEADLINE processes get SCHED_FLAG_DL_OVERRUN: the kernel sends them
+ * SIGXCPU when they exceed the runtime and PMAN_attach counts it in
+ * PROC_novr (and in the trace). The kernel refuses SCHED_DEADLINE on a
+ * process restricted to part of its root domain, so their cpu list is
+ * ignored (isolate them with an exclusive cpuset).
+ *
+ * \return  0 : success
+ *         -3 : error setting the policy or the affinity
+ */
+int linux_sched_qos(int pindex);
+
   
 #ifdef __cplusplus
 }
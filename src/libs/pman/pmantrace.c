@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA PMAN
+ *
+ * CAMBADA PMAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA PMAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * pmantrace: reads binary traces saved by PMAN_trace_export and prints, per
+ * process, the release to epilogue latency histogram, the release jitter,
+ * the deadline misses along the trace and the SCHED_DEADLINE runtime
+ * overruns. With -j or -t converts the trace to Chrome trace JSON or text
+ * instead.
+ *
+ *   pmantrace [-w bucket_us] [-j|-t] trace.bin [trace.bin ...]
+ *
+ * Several traces are reported one after the other (e.g. before and after a
+ * change, to compare the worst case cycle).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <pman.h>
+
+#define HIST_MAX     64      // Maximum number of histogram buckets
+#define HIST_BAR     50      // Width of the largest histogram bar
+#define WORST_N      5       // Worst instances listed per process
+
+typedef struct {
+	int64_t time;            // Release time (us)
+	int64_t lat;             // Release to epilogue (us)
+	uint32_t inst;
+	int cpu;                 // CPU of the epilogue
+} INSTANCE;
+
+
+static int cmp_int64(const void *a, const void *b)
+{
+	int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int cmp_lat_desc(const void *a, const void *b)
+{
+	int64_t x = ((const INSTANCE *)a)->lat, y = ((const INSTANCE *)b)->lat;
+
+	return x > y ? -1 : x < y;
+}
+
+
+/*
+ * Loads a binary trace
+ *
+ * Returns:     0 : success
+ *             -1 : error (message printed)
+ */
+static int load(const char *fname, PMAN_TRACE_PROC **procs, int *nprocs, PMAN_TRACE_REC **recs, int *nrecs)
+{
+	FILE *f;
+	PMAN_TRACE_HDR hdr;
+
+	if( !(f = fopen(fname, "r")) ) {
+		perror(fname);
+		return -1;
+	}
+
+	if(fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != PMAN_TRACE_MAGIC) {
+		fprintf(stderr, "%s: not a pman binary trace\n", fname);
+		fclose(f);
+		return -1;
+	}
+	/* Version 1 has the same records, with wall clock times */
+	if(hdr.version < 1 || hdr.version > PMAN_TRACE_VERSION) {
+		fprintf(stderr, "%s: trace version %u, expected 1 to %u\n", fname, hdr.version, PMAN_TRACE_VERSION);
+		fclose(f);
+		return -1;
+	}
+
+	*procs = calloc(hdr.nprocs + 1, sizeof(**procs));
+	*recs = calloc(hdr.nevents + 1, sizeof(**recs));
+	if(*procs == NULL || *recs == NULL
+			|| fread(*procs, sizeof(**procs), hdr.nprocs, f) != hdr.nprocs
+			|| fread(*recs, sizeof(**recs), hdr.nevents, f) != hdr.nevents) {
+		fprintf(stderr, "%s: truncated trace\n", fname);
+		free(*procs);
+		free(*recs);
+		fclose(f);
+		return -1;
+	}
+
+	fclose(f);
+	*nprocs = hdr.nprocs;
+	*nrecs = hdr.nevents;
+	return 0;
+}
+
+
+/*
+ * Prints the histogram of the latencies (sorted); width 0 uses power of two buckets
+ */
+static void histogram(const int64_t *lat, int n, int width)
+{
+	int nb, b, i, k, max = 0;
+	int count[HIST_MAX];
+	int64_t lo[HIST_MAX + 1];
+
+	if(width > 0) {
+		nb = lat[n-1] / width + 1;
+		if(nb > HIST_MAX) {
+			width = (lat[n-1] + HIST_MAX) / HIST_MAX;
+			nb = lat[n-1] / width + 1;
+			if(nb > HIST_MAX)
+				nb = HIST_MAX;
+		}
+		for(b=0;b<=nb;b++)
+			lo[b] = (int64_t)b * width;
+	}
+	else {
+		for(b=0, lo[0]=0, lo[1]=1; b<HIST_MAX-1 && lo[b+1] <= lat[n-1]; b++)
+			lo[b+2] = lo[b+1] * 2;
+		nb = b + 1;
+	}
+
+	memset(count, 0, sizeof(count));
+	for(i=0, b=0; i<n; i++) {
+		while(b < nb-1 && lat[i] >= lo[b+1])
+			b++;
+		count[b]++;
+	}
+	for(b=0;b<nb;b++)
+		if(count[b] > max)
+			max = count[b];
+
+	for(b=0; b<nb && count[b]==0; b++);
+	for(; nb>b && count[nb-1]==0; nb--);
+	for(; b<nb; b++) {
+		printf("    [%8lld, %8lld) %6d ", (long long)lo[b], (long long)lo[b+1], count[b]);
+		for(k=0; k < (count[b] * HIST_BAR + max - 1) / max; k++)
+			putchar('#');
+		putchar('\n');
+	}
+}
+
+
+/*
+ * Reports one process (t0 and t1: first and last event time of the trace)
+ */
+static void report(const PMAN_TRACE_PROC *proc, int pindex, const PMAN_TRACE_REC *recs, int nrecs, int64_t t0, int64_t t1, int width)
+{
+	int i, n = 0, nrel = 0, nmiss = 0, novr = 0, last;
+	int64_t rtime = 0, prev = 0, d;
+	uint32_t rinst = 0;
+	double isum = 0, isum2 = 0, imin = 0, imax = 0, mean;
+	int nint = 0;
+	INSTANCE *in;
+	int64_t *lat;
+	int *persec;
+	int nsec, sec;
+
+	in = calloc(nrecs + 1, sizeof(*in));
+	lat = calloc(nrecs + 1, sizeof(*lat));
+	nsec = (t1 - t0) / 1000000 + 1;
+	persec = calloc(nsec, sizeof(*persec));
+	if(in == NULL || lat == NULL || persec == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Pair each epilogue with the release of its instance */
+	for(i=0;i<nrecs;i++) {
+		if(recs[i].pindex != pindex)
+			continue;
+
+		if(recs[i].etype == 'R') {
+			if(nrel++ > 0) {
+				d = recs[i].time - prev;
+				if(nint == 0 || d < imin) imin = d;
+				if(nint == 0 || d > imax) imax = d;
+				isum += d;
+				isum2 += (double)d * d;
+				nint++;
+			}
+			prev = rtime = recs[i].time;
+			rinst = recs[i].inst;
+		}
+		else if(recs[i].etype == 'E' && rtime != 0 && recs[i].inst == rinst) {
+			in[n].time = rtime;
+			in[n].lat = recs[i].time - rtime;
+			in[n].inst = rinst;
+			in[n].cpu = recs[i].cpu;
+			lat[n] = in[n].lat;
+			if(proc->deadline > 0 && in[n].lat > proc->deadline) {
+				nmiss++;
+				sec = (recs[i].time - t0) / 1000000;
+				persec[sec < 0 ? 0 : sec >= nsec ? nsec - 1 : sec]++;
+			}
+			n++;
+			rtime = 0;
+		}
+		else if(recs[i].etype == 'O')
+			novr++;
+	}
+
+	if(nrel == 0)
+		goto out;
+
+	printf("\n%s (index %d, period %d, deadline %d us)\n", proc->name, pindex, proc->period, proc->deadline);
+	printf("  releases %d, completed %d\n", nrel, n);
+	if(novr > 0)
+		printf("  runtime overruns (SCHED_DEADLINE): %d\n", novr);
+
+	if(nint > 0) {
+		mean = isum / nint;
+		printf("  release interval (us): mean %.1f  stddev %.1f  min %.0f  max %.0f  jitter %.0f\n",
+				mean, sqrt(fabs(isum2 / nint - mean * mean)), imin, imax, imax - imin);
+	}
+
+	if(n == 0)
+		goto out;
+
+	qsort(lat, n, sizeof(*lat), cmp_int64);
+	printf("  latency (us): min %lld  p50 %lld  p90 %lld  p99 %lld  max %lld\n",
+			(long long)lat[0], (long long)lat[n/2], (long long)lat[(n*9)/10],
+			(long long)lat[(n*99)/100], (long long)lat[n-1]);
+	histogram(lat, n, width);
+
+	qsort(in, n, sizeof(*in), cmp_lat_desc);
+	printf("  worst instances:\n");
+	for(i=0; i<n && i<WORST_N; i++)
+		printf("    inst %6u at %+10.6f s: %8lld us (cpu %d)\n",
+				in[i].inst, (in[i].time - t0) / 1e6, (long long)in[i].lat, in[i].cpu);
+
+	if(proc->deadline > 0) {
+		printf("  deadline misses: %d (%.2f%%)\n", nmiss, 100.0 * nmiss / n);
+		if(nmiss > 0) {
+			for(last=nsec; last>0 && persec[last-1]==0; last--);
+			printf("  misses per second:");
+			for(i=0;i<last;i++)
+				printf("%s%d", i % 20 ? " " : "\n   ", persec[i]);
+			printf("\n");
+		}
+	}
+
+out:
+	free(in);
+	free(lat);
+	free(persec);
+}
+
+
+int main(int argc, char *argv[])
+{
+	int c, i, p, nprocs, nrecs, width = 0, format = -1, ret = EXIT_SUCCESS;
+	int64_t t0, t1;
+	PMAN_TRACE_PROC *procs;
+	PMAN_TRACE_REC *recs;
+
+	while((c = getopt(argc, argv, "w:jt")) != -1) {
+		switch(c) {
+		case 'w': width = atoi(optarg); break;
+		case 'j': format = PMAN_TRACE_FMT_JSON; break;
+		case 't': format = PMAN_TRACE_FMT_TXT; break;
+		default:
+			fprintf(stderr, "USAGE: %s [-w bucket_us] [-j|-t] trace.bin [trace.bin ...]\n", argv[0]);
+			fprintf(stderr, "  -w   linear histogram buckets of bucket_us (default: powers of two)\n");
+			fprintf(stderr, "  -j   write the trace as Chrome trace JSON (Perfetto) to stdout\n");
+			fprintf(stderr, "  -t   write the trace as text to stdout\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	if(optind >= argc) {
+		fprintf(stderr, "USAGE: %s [-w bucket_us] [-j|-t] trace.bin [trace.bin ...]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	for(; optind < argc; optind++) {
+		if(load(argv[optind], &procs, &nprocs, &recs, &nrecs)) {
+			ret = EXIT_FAILURE;
+			continue;
+		}
+
+		if(format >= 0) {
+			if(PMAN_trace_write(stdout, format, procs, nprocs, recs, nrecs))
+				ret = EXIT_FAILURE;
+		}
+		else {
+			/* The events are in the order their slots were taken, not strictly in time order */
+			t0 = t1 = nrecs > 0 ? recs[0].time : 0;
+			for(i=1; i<nrecs; i++) {
+				if(recs[i].time < t0) t0 = recs[i].time;
+				if(recs[i].time > t1) t1 = recs[i].time;
+			}
+
+			printf("== %s: %d events", argv[optind], nrecs);
+			if(nrecs > 0)
+				printf(", %.3f s", (t1 - t0) / 1e6);
+			printf("\n");
+			for(p=0; p<nprocs && nrecs>0; p++)
+				if(procs[p].name[0] != '\0')
+					report(&procs[p], p, recs, nrecs, t0, t1, width);
+			printf("\n");
+		}
+
+		free(procs);
+		free(recs);
+	}
+
+	return ret;
+}
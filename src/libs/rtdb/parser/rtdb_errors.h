@@ -28,8 +28,11 @@
 #define _ERR_INITIAL_ "À espera de uma declaração de um tipo válido!"
 #define _ERR_AGENTS_ "Agentes mal declarados! À espera de uma lista de agntes válida!"
 #define _ERR_ITEMOPEN_ "Item mal declarado! À espera de \"{\""
-#define _ERR_ITEMFIELD_ "Item mal declarado! À espera de \"datatype =\" id, \"period =\" num, \"headerfile =\" ficheiro.h ou \"}\""
+#define _ERR_ITEMFIELD_ "Item mal declarado! À espera de \"datatype =\" id, \"period =\" num, \"headerfile =\" ficheiro.h, \"history =\" num, \"channel =\" id ou \"}\""
 #define _ERR_ITEMAFTERFIELD_ "Item mal declarado! À espera de \";\", fim de linha ou \"}\""
+#define _ERR_CHANNELOPEN_ "Canal mal declarado! À espera de \"{\""
+#define _ERR_CHANNELFIELD_ "Canal mal declarado! À espera de \"group =\" num, \"port =\" num, \"period =\" num, \"ttl =\" num ou \"}\""
+#define _ERR_CHANNELAFTERFIELD_ "Canal mal declarado! À espera de \";\", fim de linha ou \"}\""
 #define _ERR_SCHEMAOPEN_ "Esquema mal declarado! À espera de \"{\""
 #define _ERR_SCHEMAFIELD_ "Esquema mal declarado! À espera de \"shared =\" ListaItems, \"local =\" ListaItems ou \"}\""
 #define _ERR_ITEMSLIST_ "Esquema mal declarado! À espera de uma lista de items válida!"
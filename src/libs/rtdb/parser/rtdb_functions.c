@@ -59,6 +59,112 @@ void agentCreate(char* newId)
 	}
 }
 
+/**************  Channels manipulation Functions  **************/
+
+//Add a channel to the channels global list if it wasn't previouly declared
+rtdb_Channel* channelCreate(char* keyword, char* newId)
+{
+	unsigned i; 
+	//The lexer has no keyword for channels, the declaration starts with the identifier CHANNEL
+	if (strcmp(keyword, "CHANNEL") != 0)
+	{
+		char * err= malloc((1+strlen("Declaração desconhecida \e[33m")+strlen(keyword)+strlen("\e[0m!")) * sizeof(char));
+		sprintf(err, "Declaração desconhecida \e[33m%s\e[0m!", keyword);
+		abortOnError(err);
+	}
+	//Run through the channels list
+	for(i = 0; i < chList.numCh; i++)
+	{
+		//If the channel is found, notify the user and abort
+		if (strcmp(chList.channels[i].id, newId) == 0)
+		{
+			char * err= malloc((1+strlen("O canal \e[33m")+ strlen(newId)+strlen("\e[0m já foi declarado!")) * sizeof(char));
+			sprintf(err, "O canal \e[33m%s\e[0m já foi declarado!", newId);
+			abortOnError(err);
+		}
+	}
+	//Add the channel to the list, 0 is the default channel
+	chList.channels[chList.numCh].num = chList.numCh + 1;
+	chList.channels[chList.numCh].id = strdup(newId);
+	chList.channels[chList.numCh].group = 0;
+	chList.channels[chList.numCh].port = 0;
+	chList.channels[chList.numCh].period = 0;
+	chList.channels[chList.numCh].ttl = 0;
+	//Increment the list counter
+	chList.numCh++;
+
+	//Reallocate memory to the list
+	chList.channels = realloc(chList.channels, (chList.numCh+1)*sizeof(rtdb_Channel));
+
+	//If in Debug mode print info about the channel just added
+	if (DEBUG)
+	{
+		printf("\nCanal \e[32m%s\e[0m adicionado com sucesso à lista de \e[32m%u\e[0m Canais com o número \e[32m%u\e[0m!\n", chList.channels[chList.numCh-1].id, chList.numCh, chList.numCh); 
+	}
+
+	//Return a pointer to the channel
+	return &chList.channels[chList.numCh-1];
+}
+
+//Define a field (name = number) in the channel specified if it wasn't previouly defined
+void channelAddField(rtdb_Channel* ch, char* field, char* val)
+{
+	//Convert the string of the value to an unsigned
+	unsigned v= ((unsigned)atoi(val));
+	unsigned* f;
+
+	if (strcmp(field, "group") == 0)
+		f = &ch->group;
+	else if (strcmp(field, "port") == 0)
+		f = &ch->port;
+	else if (strcmp(field, "period") == 0)
+		f = &ch->period;
+	else if (strcmp(field, "ttl") == 0)
+		f = &ch->ttl;
+	else
+	{
+		//Unknown field, abort
+		char * err= malloc((1+strlen("Campo \e[33m")+strlen(field)+strlen("\e[0m desconhecido no canal \e[33m")+strlen(ch->id)+strlen("\e[0m!")) * sizeof(char));
+		sprintf(err, "Campo \e[33m%s\e[0m desconhecido no canal \e[33m%s\e[0m!", field, ch->id);
+		abortOnError(err);
+		return;
+	}
+
+	//Check if the field wasn't alrealy defined, and that it is not 0
+	if ((*f != 0) || (v == 0))
+	{
+		char * err= malloc((1+strlen("Valor \e[33m")+strlen(val)+strlen("\e[0m inválido ou repetido no campo \e[33m")+strlen(field)+strlen("\e[0m do canal \e[33m")+strlen(ch->id)+strlen("\e[0m!")) * sizeof(char));
+		sprintf(err, "Valor \e[33m%s\e[0m inválido ou repetido no campo \e[33m%s\e[0m do canal \e[33m%s\e[0m!", val, field, ch->id);
+		abortOnError(err);
+	}
+	*f = v;
+	//If in Debug mode tell the user that the field was correctly defined
+	if (DEBUG)
+	{
+		printf("\nCampo %s \e[32m%u\e[0m definido com sucesso no canal \e[32m%s\e[0m\n", field, v, ch->id); 
+	}
+}
+
+//Check if the channel is well defined, fields non specified get their default values
+void channelVerify(rtdb_Channel* ch)
+{
+	//The group and the port are mandatory, and the group must be a valid address byte
+	if ((ch->group == 0) || (ch->group > 254) || (ch->port == 0) || (ch->port > 65535))
+	{
+		char * err= malloc((1+strlen("O canal \e[32m")+strlen(ch->id)+strlen("\e[0m precisa de \e[33mgroup\e[0m (1-254) e \e[33mport\e[0m!")) * sizeof(char));
+		sprintf(err, "O canal \e[32m%s\e[0m precisa de \e[33mgroup\e[0m (1-254) e \e[33mport\e[0m!", ch->id);
+		abortOnError(err);
+	}
+	//If the period isn't defined, assign it the default value
+	if (ch->period == 0)
+		ch->period = 1;
+	//If in Debug mode tell the user that the channel was correctly defined
+	if (DEBUG)
+	{
+		printf("\nO canal \e[32m%s\e[0m foi verificado com sucesso!\n", ch->id);
+	}
+}
+
 /**************  Items manipulation Functions  **************/
 
 //Add an item to the items global list if it wasn't previouly declared
@@ -82,6 +188,8 @@ rtdb_Item* itemCreate(char* newId)
 	itList.items[itList.numIt].datatype = strdup("\0");
 	itList.items[itList.numIt].headerfile = strdup("\0");
 	itList.items[itList.numIt].period = 0;
+	itList.items[itList.numIt].history = 0;
+	itList.items[itList.numIt].channel = 0;
 	//Increment the list counter
 	itList.numIt++;
 	
@@ -168,6 +276,81 @@ void itemAddHeaderfile(rtdb_Item* it, char* hdf)
 	}
 }
 
+//Define an optional field (name = number) in the item specified if it wasn't previouly defined
+void itemAddField(rtdb_Item* it, char* field, char* val)
+{
+	//Convert the string of the value to an unsigned
+	unsigned v= ((unsigned)atoi(val));
+	//Number of past samples of the item kept in the DB
+	if (strcmp(field, "history") == 0)
+	{
+		//Check if the history wasn't alrealy defined
+		if (it->history == 0)
+		{
+			it->history = v;
+			//If in Debug mode tell the user that the history was correctly defined
+			if (DEBUG)
+			{
+				printf("\nHistory \e[32m%u\e[0m definido com sucesso no item \e[32m%s\e[0m\n", v, it->id); 
+			}
+		}
+		else
+		{
+			//If it was already defined abort
+			char strhistory[12];
+			sprintf(strhistory, "%u", it->history);		
+			char * err= malloc((1+strlen("Tentativa de definição do history \e[33m")+strlen(val)+strlen("\e[0m no item \e[33m")+strlen(it->id)+strlen("\e[0m já com o history \e[33m")+strlen(strhistory)+strlen("\e[0m definido!")) * sizeof(char));
+			sprintf(err, "Tentativa de definição do history \e[33m%s\e[0m no item \e[33m%s\e[0m já com o history \e[33m%s\e[0m definido!", val, it->id, strhistory);
+			abortOnError(err);
+		}
+	}
+	else
+	{
+		//Unknown field, abort
+		char * err= malloc((1+strlen("Campo \e[33m")+strlen(field)+strlen("\e[0m desconhecido no item \e[33m")+strlen(it->id)+strlen("\e[0m!")) * sizeof(char));
+		sprintf(err, "Campo \e[33m%s\e[0m desconhecido no item \e[33m%s\e[0m!", field, it->id);
+		abortOnError(err);
+	}
+}
+
+//Define an optional field (name = identifier) in the item specified if it wasn't previouly defined
+void itemAddName(rtdb_Item* it, char* field, char* val)
+{
+	unsigned i;
+	//Comm channel of the item, it must be already declared
+	if (strcmp(field, "channel") == 0)
+	{
+		for (i = 0; (i < chList.numCh) && (strcmp(chList.channels[i].id, val) != 0); i++)
+			;
+		if (i == chList.numCh)
+		{
+			char * err= malloc((1+strlen("O canal \e[33m")+strlen(val)+strlen("\e[0m do item \e[33m")+strlen(it->id)+strlen("\e[0m não foi declarado!")) * sizeof(char));
+			sprintf(err, "O canal \e[33m%s\e[0m do item \e[33m%s\e[0m não foi declarado!", val, it->id);
+			abortOnError(err);
+		}
+		//Check if the channel wasn't alrealy defined
+		if (it->channel != 0)
+		{
+			char * err= malloc((1+strlen("Tentativa de definição do canal \e[33m")+strlen(val)+strlen("\e[0m no item \e[33m")+strlen(it->id)+strlen("\e[0m já com canal definido!")) * sizeof(char));
+			sprintf(err, "Tentativa de definição do canal \e[33m%s\e[0m no item \e[33m%s\e[0m já com canal definido!", val, it->id);
+			abortOnError(err);
+		}
+		it->channel = chList.channels[i].num;
+		//If in Debug mode tell the user that the channel was correctly defined
+		if (DEBUG)
+		{
+			printf("\nCanal \e[32m%s\e[0m definido com sucesso no item \e[32m%s\e[0m\n", val, it->id); 
+		}
+	}
+	else
+	{
+		//Unknown field, abort
+		char * err= malloc((1+strlen("Campo \e[33m")+strlen(field)+strlen("\e[0m desconhecido no item \e[33m")+strlen(it->id)+strlen("\e[0m!")) * sizeof(char));
+		sprintf(err, "Campo \e[33m%s\e[0m desconhecido no item \e[33m%s\e[0m!", field, it->id);
+		abortOnError(err);
+	}
+}
+
 //Check if the item is well defined, all fields non specified, with default fields, are defined here
 void itemVerify(rtdb_Item* it)
  {
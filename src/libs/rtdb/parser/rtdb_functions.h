@@ -28,6 +28,7 @@
 
 // Global Lists to store all read data from the input file
 rtdb_AgentList agList;
+rtdb_ChannelList chList;
 rtdb_ItemList itList;
 rtdb_SchemaList schemaList;
 rtdb_AssignmentList assignList;
@@ -38,6 +39,15 @@ rtdb_AssignmentList assignList;
 //Add an agent to the agents global list if it wasn't previouly declared
 void agentCreate(char* );
 
+/**************  Channels manipulation Functions  **************/
+
+//Add a channel to the channels global list if it wasn't previouly declared
+rtdb_Channel* channelCreate(char* , char* );
+//Define a field (name = number) in the channel specified if it wasn't previouly defined
+void channelAddField(rtdb_Channel* , char* , char* );
+//Check if the channel is well defined, fields non specified get their default values
+void channelVerify(rtdb_Channel* );
+
 /**************  Items manipulation Functions  **************/
 
 //Add an item to the items global list if it wasn't previouly declared
@@ -48,6 +58,10 @@ void itemAddDatatype(rtdb_Item* , char* );
 void itemAddPeriod(rtdb_Item* , char* );
 //Define an headerfile in the item specified if it wasn't previouly defined
 void itemAddHeaderfile(rtdb_Item* , char* );
+//Define an optional field (name = number) in the item specified if it wasn't previouly defined
+void itemAddField(rtdb_Item* , char* , char* );
+//Define an optional field (name = identifier) in the item specified if it wasn't previouly defined
+void itemAddName(rtdb_Item* , char* , char* );
 //Check if the item is well defined, all fields non specified, with default fields, are defined here
 void itemVerify(rtdb_Item* );
 
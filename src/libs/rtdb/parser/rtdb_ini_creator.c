@@ -26,21 +26,56 @@
 #include <malloc.h>
 #include <assert.h>
 #include <libgen.h>
+#include <ctype.h>
 
 #include "rtdb_ini_creator.h"
 #include "rtdb_structs.h"
 #include "rtdb_configuration.h"
 
+/*
+Function to hash (FNV-1a) the text of a preprocessed file, without white space
+   and without the system headers: what is left declares the datatype and
+   every type of the project it is made of
+*/
+static unsigned int hashPreprocessed(FILE *f, unsigned int hash)
+{
+	char line[1024], *p;
+	int systemhdr= 0;
+
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		//Line markers are # linenum "file" flags, the flag 3 tells a system header
+		if ((line[0] == '#') && (line[1] == ' ') && isdigit((unsigned char)line[2]))
+		{
+			p= strrchr(line, '"');
+			systemhdr= (p != NULL) && (strstr(p, " 3") != NULL);
+			continue;
+		}
+		if (systemhdr)
+			continue;
+		for (p= line; *p != '\0'; p++)
+			if (!isspace((unsigned char)*p))
+				hash= (hash ^ (unsigned char)*p) * 16777619u;
+	}
+
+	return hash;
+}
+
 /* 
 Function to write, compile and execute a rtdb_sizeof_tmp.c file
    that has included the headerfile where the datatype is defined
    and write a rtdb_size.tmp with the size of the datatype.
 After that, the rtdb_size.tmp file is opened, the size of the
-   datatype is read and returned 
+   datatype is read and returned.
+If layout is not NULL, it gets a hash of the layout of the datatype:
+   its size, alignment, the byte order of the host and the declarations
+   of the project it comes from (the preprocessed rtdb_sizeof_tmp.cpp),
+   so comm peers built from different declarations can tell
 */
-int getSizeof(char* headerfl, char* datatype)
+int getSizeof(char* headerfl, char* datatype, unsigned int *layout)
 {
 	int sizeofdata;
+	unsigned int alignofdata, littleendian, hash;
 	char line[50], *command;
 	FILE *f, *ftmp /* , *hfl */;
 
@@ -73,10 +108,13 @@ int getSizeof(char* headerfl, char* datatype)
 	fprintf(f, "using namespace cambada;\n");
 	fprintf(f, "int main(void)\n{\n");
 	fprintf(f, "\tFILE* f;\n");
+	fprintf(f, "\tunsigned int one= 1;\n");
 	//Create the rtdb_size.tmp for writing
 	fprintf(f, "\tf= fopen(\"rtdb_size.tmp\", \"w\");\n");
 	//Write the size of the datatype in the rtdb_size.tmp file
 	fprintf(f, "\tfprintf(f, \"%%u\\n\", sizeof(%s%s));\n", STRUCTPREFIX, datatype);
+	//And in the second line its alignment and the byte order of the host (1 = little endian)
+	fprintf(f, "\tfprintf(f, \"%%u %%u\\n\", (unsigned int)__alignof__(%s%s), (unsigned int)*(unsigned char*)&one);\n", STRUCTPREFIX, datatype);
 	fprintf(f, "\tfclose(f);\n");
 	fprintf(f, "\n\treturn 0;\n}\n");
 	fprintf(f, "\n/* EOF: rtdb_sizeof_tmp.cpp */\n");
@@ -195,9 +233,36 @@ int getSizeof(char* headerfl, char* datatype)
 	//Define sizeofdata with the integer just read to line
 	sscanf(line, "%d", &sizeofdata);
 
+	//Read the alignment and the byte order from the second line
+	assert(fgets(line, 50, ftmp) != NULL);
+	assert(sscanf(line, "%u %u", &alignofdata, &littleendian) == 2);
+
 	//Close the rtdb_size.tmp file
 	fclose(ftmp);
 
+	//Preprocess the rtdb_sizeof_tmp.cpp file to rtdb_layout.tmp and hash it with the size, alignment and byte order
+	if (layout != NULL)
+	{
+		command= malloc((strlen(CC)+1+strlen(CFLAGS)+strlen(" -E rtdb_sizeof_tmp.cpp > rtdb_layout.tmp")+1)*sizeof(char));
+		sprintf(command, "%s %s -E rtdb_sizeof_tmp.cpp > rtdb_layout.tmp", CC, CFLAGS);
+		assert(system(command) != -1);
+		free(command);
+
+		assert((ftmp= fopen("rtdb_layout.tmp", "r")) != NULL);
+		hash= hashPreprocessed(ftmp, 2166136261u);
+		fclose(ftmp);
+
+		hash= (hash ^ sizeofdata) * 16777619u;
+		hash= (hash ^ alignofdata) * 16777619u;
+		hash= (hash ^ littleendian) * 16777619u;
+		*layout= (hash == 0) ? 1 : hash;
+
+		command= malloc((1+strlen(RM_COMMAND)+strlen(" ./rtdb_layout.tmp"))*sizeof(char));
+		sprintf(command, "%s ./rtdb_layout.tmp", RM_COMMAND);
+		assert(system(command) != -1);
+		free(command);
+	}
+
 	//Delete the rtdb_sizeof_tmp.c temporary file
 	command= malloc((1+strlen(RM_COMMAND)+strlen(" ./rtdb_sizeof_tmp.cpp"))*sizeof(char));
 	sprintf(command, "%s ./rtdb_sizeof_tmp.cpp", RM_COMMAND);
@@ -233,10 +298,10 @@ int getSizeof(char* headerfl, char* datatype)
 
 
 /*
-Function to read the Global list of agents and the Global list
-   of assignments and automatically generate the rtdb.ini file
+Function to read the Global list of agents, the Global list of assignments
+   and the Global list of channels and automatically generate the rtdb.ini file
 */
-int printIniFile (rtdb_AgentList agL, rtdb_AssignmentList asL)
+int printIniFile (rtdb_AgentList agL, rtdb_AssignmentList asL, rtdb_ChannelList chL)
 {
 	char* command;
     FILE *f;
@@ -278,12 +343,20 @@ int printIniFile (rtdb_AgentList agL, rtdb_AssignmentList asL)
 		return 2;
 	}
 
-	unsigned i, j, k, l;
+	unsigned i, j, k, l, layout;
+	int size;
 
 	fprintf(f, "##\n");
 	fprintf(f, "## %s IS AN AUTOGEN FILE, DO NOT EDIT. \n", basename(RTDB_INI) );
 	fprintf(f, "##\n\n\n");
 
+	//Print the comm channels, one line each: #CHANNEL number name group port period ttl
+	for (i= 0; i < chL.numCh; i++)
+		fprintf(f, "#CHANNEL %-2u %-16s 224.16.32.%-3u %-5u %-2u %u\n", chL.channels[i].num, chL.channels[i].id,
+				chL.channels[i].group, chL.channels[i].port, chL.channels[i].period, chL.channels[i].ttl);
+	if (chL.numCh > 0)
+		fprintf(f, "\n\n");
+
 	//Run through all the agents
 	for (i= 0; i < agL.numAg; i++)
 	{
@@ -301,18 +374,32 @@ int printIniFile (rtdb_AgentList agL, rtdb_AssignmentList asL)
 					//Print all items from the local items list of the current assignment schema
 					for (l= 0; l < asL.asList[j].schema->sharedItems.numIt; l++)
 					{
-						fprintf(f, "%-4u %-8d %-2u  s\n", asL.asList[j].schema->sharedItems.items[l].num, 
-                                getSizeof(asL.asList[j].schema->sharedItems.items[l].headerfile, 
-                                asL.asList[j].schema->sharedItems.items[l].datatype), 
+						size= getSizeof(asL.asList[j].schema->sharedItems.items[l].headerfile, 
+                                asL.asList[j].schema->sharedItems.items[l].datatype, &layout);
+						fprintf(f, "%-4u %-8d %-2u  s", asL.asList[j].schema->sharedItems.items[l].num, size,
                                 asL.asList[j].schema->sharedItems.items[l].period);
+						//The history and channel columns are optional, only written for items that use them
+						if ((asL.asList[j].schema->sharedItems.items[l].history > 0) || (asL.asList[j].schema->sharedItems.items[l].channel > 0))
+							fprintf(f, "  %u", asL.asList[j].schema->sharedItems.items[l].history);
+						if (asL.asList[j].schema->sharedItems.items[l].channel > 0)
+							fprintf(f, "  %u", asL.asList[j].schema->sharedItems.items[l].channel);
+						//The layout hash of the datatype, after an @
+						fprintf(f, "  @%08x\n", layout);
 					}
 					//Print all items from the shared items list of the current assignment schema
 					for (l= 0; l < asL.asList[j].schema->localItems.numIt; l++)
 					{
-						fprintf(f, "%-4u %-8d %-2u  l\n", asL.asList[j].schema->localItems.items[l].num, 
-                                getSizeof(asL.asList[j].schema->localItems.items[l].headerfile, 
-                                asL.asList[j].schema->localItems.items[l].datatype), 
+						size= getSizeof(asL.asList[j].schema->localItems.items[l].headerfile, 
+                                asL.asList[j].schema->localItems.items[l].datatype, &layout);
+						fprintf(f, "%-4u %-8d %-2u  l", asL.asList[j].schema->localItems.items[l].num, size,
                                 asL.asList[j].schema->localItems.items[l].period);
+						//The history and channel columns are optional, only written for items that use them
+						if ((asL.asList[j].schema->localItems.items[l].history > 0) || (asL.asList[j].schema->localItems.items[l].channel > 0))
+							fprintf(f, "  %u", asL.asList[j].schema->localItems.items[l].history);
+						if (asL.asList[j].schema->localItems.items[l].channel > 0)
+							fprintf(f, "  %u", asL.asList[j].schema->localItems.items[l].channel);
+						//The layout hash of the datatype, after an @
+						fprintf(f, "  @%08x\n", layout);
 					}	
 				}
 			} 
@@ -21,7 +21,7 @@
  */
 
 #ifndef _RTDB_INI_CREATOR_H_
-#define _RTDB_USER_CREATOR_H_
+#define _RTDB_INI_CREATOR_H_
 
 #include "rtdb_structs.h"
 #include "rtdb_configuration.h"
@@ -31,15 +31,17 @@ Function to write, compile and execute a rtdb_sizeof_tmp.c file
    that has included the headerfile where the datatype is defined
    and write a rtdb_size.tmp with the size of the datatype.
 After that, the rtdb_size.tmp file is opened, the size of the
-   datatype is read and returned 
+   datatype is read and returned.
+If the last argument is not NULL, it gets a hash of the layout of the
+   datatype (see rtdb_ini_creator.c)
 */
-int getSizeof(char*, char*);
+int getSizeof(char*, char*, unsigned int*);
 
 /*
 Function to read the Global list of agents and the Global list
    of assignments and automatically generate a rtdb.ini file
 */
-int printIniFile (rtdb_AgentList, rtdb_AssignmentList);
+int printIniFile (rtdb_AgentList, rtdb_AssignmentList, rtdb_ChannelList);
 
 #endif
 
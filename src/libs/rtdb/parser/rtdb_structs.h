@@ -37,6 +37,24 @@ typedef struct
 	unsigned numAg; 	// Total number of agents in list
 } rtdb_AgentList;
 
+/* Structure to store a comm channel (multicast group) */
+typedef struct
+{
+	unsigned num;		// Unique channel identification number (1-n, 0 is the default channel)
+	char* id;		// Channel name (alfanum)
+	unsigned group;		// Last byte of the multicast group 224.16.32.x (1-254)
+	unsigned port;		// UDP port
+	unsigned period;	// Transmission period of the channel, in comm cycles (Ttup)
+	unsigned ttl;		// Multicast TTL (0 = system default)
+} rtdb_Channel;
+
+/* Structure to store a list of channels */
+typedef struct
+{
+	rtdb_Channel* channels;	// Dynamic channel list
+	unsigned numCh;		// Total number of channels in list
+} rtdb_ChannelList;
+
 /* Structure to store an item */
 typedef struct
 {
@@ -45,6 +63,8 @@ typedef struct
 	char* datatype;		// C datatype identifier (alfanum)
 	char* headerfile;	// C headerfile name where the datatype is declared (alfanum)
 	unsigned period;	// Broadcasting period of DB item (1-4)
+	unsigned history;	// Number of past samples kept in the DB (0-n)
+	unsigned channel;	// Comm channel of DB item (0 = default)
 } rtdb_Item;
 
 /* Structure to store an items list */
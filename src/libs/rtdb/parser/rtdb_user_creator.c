@@ -26,6 +26,7 @@
 #include <assert.h>
 //#include <malloc.h>
 #include "rtdb_user_creator.h"
+#include "rtdb_ini_creator.h"
 
 /*
 Function to write the rtdb_user.h file using the Global agents list
@@ -108,4 +109,116 @@ int printUserFile(rtdb_ItemList it, rtdb_AgentList ag)
 	return 0;	
 }
 
+/*
+Function to check if an item is used by some assignment, that is,
+  if it has a record in the rtdb.ini file
+*/
+static int itemAssigned(rtdb_AssignmentList as, unsigned num)
+{
+	unsigned i, j;
+
+	for (i= 0; i < as.numAs; i++)
+	{
+		for (j= 0; j < as.asList[i].schema->sharedItems.numIt; j++)
+			if (as.asList[i].schema->sharedItems.items[j].num == num)
+				return 1;
+		for (j= 0; j < as.asList[i].schema->localItems.numIt; j++)
+			if (as.asList[i].schema->localItems.items[j].num == num)
+				return 1;
+	}
+
+	return 0;
+}
+
+/*
+Function to write the rtdb_typed.h file, with the datatype of every
+  item for the typed C++ accessors of rtdb_access.h, and the build time
+  check of the sizes written in rtdb.ini
+*/
+int printTypedFile(rtdb_ItemList it, rtdb_AssignmentList as)
+{
+	unsigned i, j;
+	FILE *f;
+	char* command;
+
+	//Open the file rtdb_typed.h for reading to check if it exists
+	f= fopen(RTDB_TYPED_H, "r");
+	if (f != NULL)
+	{
+		//If it exists close it and ask the user permission to overwrite it
+		fclose(f);
+		char op = '\0';
+		while ((op != 'y') && (op != 'n'))
+		{
+			printf("\nO ficheiro \e[33m%s\e[0m ja existe!\nDeseja substitui-lo? (y/n): ", RTDB_TYPED_H);
+			assert(scanf("%c", &op) == 1);
+			//Clean stdin
+			purge();
+		}
+		if (op == 'n')
+		{
+			return 1;
+		}
+	}
+
+	//Remove the rtdb_typed.h file in case it exists, if we have permission from the user
+	command= malloc ((2 + strlen(RM_COMMAND)+strlen(RTDB_TYPED_H)) * sizeof(char));
+	sprintf(command, "%s %s", RM_COMMAND, RTDB_TYPED_H);
+	assert(system(command) != -1);
+	free(command);
+
+	//If for some reason we can't create the file, abort
+	if ((f= fopen(RTDB_TYPED_H, "w")) == NULL)
+	{
+		return 2;
+	}
+
+	//Write generic information to the file
+	fprintf(f, "/* AUTOGEN FILE : rtdb_typed.h */\n\n");
+	fprintf(f, "#ifndef _CAMBADA_RTDB_TYPED_\n#define _CAMBADA_RTDB_TYPED_\n\n");
+	fprintf(f, "#include \"rtdb_access.h\"\n#include \"rtdb_user.h\"\n\n");
+
+	//Only the items with records in rtdb.ini are written, the others may not even have a datatype declared
+	//Include every headerfile only once, as getSizeof() does
+	for(i= 0; i < it.numIt; i++)
+	{
+		if (!itemAssigned(as, it.items[i].num))
+			continue;
+		for(j= 0; j < i; j++)
+			if (itemAssigned(as, it.items[j].num) && (strcmp(it.items[i].headerfile, it.items[j].headerfile) == 0))
+				break;
+		if (j == i)
+			fprintf(f, "#include \"%s\"\n", it.items[i].headerfile);
+	}
+	fprintf(f, "#include \"common.h\"\n\n");
+
+	//Write the datatype of every item
+	fprintf(f, "/* items section */\n\n");
+	fprintf(f, "namespace rtdb\n{\nusing namespace cambada;\n\n");
+	for(i= 0; i < it.numIt; i++)
+	{
+		if (itemAssigned(as, it.items[i].num))
+			fprintf(f, "template<> struct item<%s> { typedef %s%s type; };\n", it.items[i].id, STRUCTPREFIX, it.items[i].datatype);
+	}
+	fprintf(f, "\n}\n\n");
+
+	//Write the size check of every item, against the size written in rtdb.ini
+	fprintf(f, "/* sizes section */\n\n");
+	for(i= 0; i < it.numIt; i++)
+	{
+		if (itemAssigned(as, it.items[i].num))
+			fprintf(f, "RTDB_CHECK_SIZE(%s, %d);\n", it.items[i].id, getSizeof(it.items[i].headerfile, it.items[i].datatype, NULL));
+	}
+
+	//Write generic information to the file
+	fprintf(f, "\n#endif\n\n");
+	fprintf(f, "/* EOF : rtdb_typed.h */\n");
+
+	//Close the rtdb_typed.h file
+	fclose(f);
+
+	//Return 0, meaning all went smoothly
+	return 0;
+}
+
 /* EOF: rtdb_user_creator.c */
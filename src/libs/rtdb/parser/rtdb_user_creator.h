@@ -32,6 +32,13 @@ Function to write the rtdb_user.h file using the Global agents list
 */
 int printUserFile(rtdb_ItemList, rtdb_AgentList);
 
+/*
+Function to write the rtdb_typed.h file, with the datatypes of the
+  items for the typed C++ accessors, using the Global items list
+  and the Global assignments list
+*/
+int printTypedFile(rtdb_ItemList, rtdb_AssignmentList);
+
 #endif
 
 /* EOF: rtdb_user_creator.h */
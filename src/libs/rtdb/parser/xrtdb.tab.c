@@ -66,7 +66,7 @@
 /* Copy the first part of user declarations.  */
 
 /* Line 268 of yacc.c  */
-#line 21 "xrtdb.y"
+#line 30 "xrtdb.y"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -88,13 +88,14 @@ void yyerror(char *);
 unsigned nline= 1;
 
 //Aux global vars to create the global lists defined in rtdb_functions.h
+rtdb_Channel * pChannel;
 rtdb_Item * pItem;
 rtdb_Schema * pSchema;
 rtdb_Assignment * pAssign;
 
 
 /* Line 268 of yacc.c  */
-#line 98 "xrtdb.tab.c"
+#line 99 "xrtdb.tab.c"
 
 /* Enabling traces.  */
 #ifndef YYDEBUG
@@ -159,7 +160,7 @@ typedef int YYSTYPE;
 
 
 /* Line 343 of yacc.c  */
-#line 163 "xrtdb.tab.c"
+#line 164 "xrtdb.tab.c"
 
 #ifdef short
 # undef short
@@ -376,18 +377,18 @@ union yyalloc
 #endif /* !YYCOPY_NEEDED */
 
 /* YYFINAL -- State number of the termination state.  */
-#define YYFINAL  18
+#define YYFINAL  20
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   120
+#define YYLAST   148
 
 /* YYNTOKENS -- Number of terminals.  */
 #define YYNTOKENS  24
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  33
+#define YYNNTS  44
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  75
+#define YYNRULES  98
 /* YYNRULES -- Number of states.  */
-#define YYNSTATES  133
+#define YYNSTATES  174
 
 /* YYTRANSLATE(YYLEX) -- Bison symbol number corresponding to YYLEX.  */
 #define YYUNDEFTOK  2
@@ -432,57 +433,68 @@ static const yytype_uint8 yytranslate[] =
 #if YYDEBUG
 /* YYPRHS[YYN] -- Index of the first RHS symbol of rule number YYN in
    YYRHS.  */
-static const yytype_uint8 yyprhs[] =
+static const yytype_uint16 yyprhs[] =
 {
        0,     0,     3,     5,     6,    10,    11,    18,    19,    27,
-      28,    34,    35,    41,    45,    47,    49,    51,    55,    57,
-      58,    62,    65,    67,    68,    72,    73,    79,    80,    86,
+      28,    34,    35,    41,    42,    48,    52,    54,    56,    58,
+      62,    64,    65,    69,    72,    74,    75,    79,    80,    86,
       87,    93,    95,    97,    98,   102,   105,   107,   109,   110,
-     114,   117,   119,   120,   124,   130,   135,   141,   146,   148,
-     150,   152,   157,   159,   160,   162,   164,   169,   171,   172,
-     176,   177,   181,   183,   184,   188,   189,   196,   197,   203,
-     209,   214,   216,   218,   220,   224
+     114,   117,   119,   120,   124,   125,   131,   132,   138,   139,
+     145,   146,   152,   153,   159,   161,   163,   164,   168,   171,
+     173,   175,   176,   180,   183,   185,   186,   190,   196,   201,
+     207,   212,   214,   216,   218,   223,   225,   226,   228,   230,
+     235,   237,   238,   242,   243,   247,   249,   250,   254,   255,
+     262,   263,   269,   275,   280,   282,   284,   286,   290
 };
 
 /* YYRHS -- A `-1'-separated list of the rules' RHS.  */
 static const yytype_int8 yyrhs[] =
 {
       25,     0,    -1,    26,    -1,    -1,    22,    27,    26,    -1,
-      -1,     3,    17,    32,    22,    28,    26,    -1,    -1,     3,
-      17,    32,    18,    22,    29,    26,    -1,    -1,     4,    14,
-      30,    33,    26,    -1,    -1,     5,    14,    31,    42,    26,
-      -1,     6,    49,    26,    -1,    23,    -1,     1,    -1,    14,
-      -1,    32,    19,    14,    -1,     1,    -1,    -1,    22,    34,
-      33,    -1,    20,    35,    -1,     1,    -1,    -1,    22,    36,
-      35,    -1,    -1,     7,    17,    14,    37,    40,    -1,    -1,
-       8,    17,    14,    38,    40,    -1,    -1,     9,    17,    15,
+      -1,     3,    17,    33,    22,    28,    26,    -1,    -1,     3,
+      17,    33,    18,    22,    29,    26,    -1,    -1,    14,    14,
+      30,    34,    26,    -1,    -1,     4,    14,    31,    42,    26,
+      -1,    -1,     5,    14,    32,    53,    26,    -1,     6,    60,
+      26,    -1,    23,    -1,     1,    -1,    14,    -1,    33,    19,
+      14,    -1,     1,    -1,    -1,    22,    35,    34,    -1,    20,
+      36,    -1,     1,    -1,    -1,    22,    37,    36,    -1,    -1,
+       8,    17,    16,    38,    40,    -1,    -1,    14,    17,    16,
       39,    40,    -1,    21,    -1,     1,    -1,    -1,    22,    41,
-      35,    -1,    18,    35,    -1,    21,    -1,     1,    -1,    -1,
+      36,    -1,    18,    36,    -1,    21,    -1,     1,    -1,    -1,
       22,    43,    42,    -1,    20,    44,    -1,     1,    -1,    -1,
-      22,    45,    44,    -1,    10,    17,    46,    18,    44,    -1,
-      10,    17,    46,    44,    -1,    11,    17,    48,    18,    44,
-      -1,    11,    17,    48,    44,    -1,    21,    -1,     1,    -1,
-      14,    -1,    46,    19,    47,    14,    -1,     1,    -1,    -1,
-      22,    -1,    14,    -1,    48,    19,    47,    14,    -1,     1,
-      -1,    -1,    22,    50,    49,    -1,    -1,    20,    51,    52,
-      -1,     1,    -1,    -1,    22,    53,    52,    -1,    -1,    12,
-      17,    14,    54,    18,    52,    -1,    -1,    12,    17,    14,
-      55,    52,    -1,    13,    17,    56,    18,    52,    -1,    13,
-      17,    56,    52,    -1,    21,    -1,     1,    -1,    14,    -1,
-      56,    19,    14,    -1,     1,    -1
+      22,    45,    44,    -1,    -1,     7,    17,    14,    46,    51,
+      -1,    -1,     8,    17,    16,    47,    51,    -1,    -1,     9,
+      17,    15,    48,    51,    -1,    -1,    14,    17,    16,    49,
+      51,    -1,    -1,    14,    17,    14,    50,    51,    -1,    21,
+      -1,     1,    -1,    -1,    22,    52,    44,    -1,    18,    44,
+      -1,    21,    -1,     1,    -1,    -1,    22,    54,    53,    -1,
+      20,    55,    -1,     1,    -1,    -1,    22,    56,    55,    -1,
+      10,    17,    57,    18,    55,    -1,    10,    17,    57,    55,
+      -1,    11,    17,    59,    18,    55,    -1,    11,    17,    59,
+      55,    -1,    21,    -1,     1,    -1,    14,    -1,    57,    19,
+      58,    14,    -1,     1,    -1,    -1,    22,    -1,    14,    -1,
+      59,    19,    58,    14,    -1,     1,    -1,    -1,    22,    61,
+      60,    -1,    -1,    20,    62,    63,    -1,     1,    -1,    -1,
+      22,    64,    63,    -1,    -1,    12,    17,    14,    65,    18,
+      63,    -1,    -1,    12,    17,    14,    66,    63,    -1,    13,
+      17,    67,    18,    63,    -1,    13,    17,    67,    63,    -1,
+      21,    -1,     1,    -1,    14,    -1,    67,    19,    14,    -1,
+       1,    -1
 };
 
 /* YYRLINE[YYN] -- source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    48,    48,    50,    50,    51,    51,    52,    52,    53,
-      53,    54,    54,    55,    56,    57,    60,    61,    62,    65,
-      65,    66,    67,    70,    70,    71,    71,    72,    72,    73,
-      73,    74,    75,    78,    78,    79,    80,    81,    84,    84,
-      85,    86,    89,    89,    90,    91,    92,    93,    94,    95,
-      98,    99,   100,   103,   104,   107,   108,   109,   112,   112,
-     113,   113,   114,   117,   117,   118,   118,   119,   119,   120,
-     121,   122,   123,   126,   127,   128
+       0,    58,    58,    60,    60,    61,    61,    62,    62,    63,
+      63,    64,    64,    65,    65,    66,    67,    68,    71,    72,
+      73,    76,    76,    77,    78,    81,    81,    82,    82,    83,
+      83,    84,    85,    88,    88,    89,    90,    91,    94,    94,
+      95,    96,    99,    99,   100,   100,   101,   101,   102,   102,
+     103,   103,   104,   104,   105,   106,   109,   109,   110,   111,
+     112,   115,   115,   116,   117,   120,   120,   121,   122,   123,
+     124,   125,   126,   129,   130,   131,   134,   135,   138,   139,
+     140,   143,   143,   144,   144,   145,   148,   148,   149,   149,
+     150,   150,   151,   152,   153,   154,   157,   158,   159
 };
 #endif
 
@@ -496,10 +508,12 @@ static const char *const yytname[] =
   "sharedFIELD", "localFIELD", "schemaFIELD", "agentsFIELD", "identifier",
   "headerfl", "integer", "equal", "semicomma", "comma", "openbrace",
   "closebrace", "eol", "eof", "$accept", "S", "INITIAL", "$@1", "$@2",
-  "$@3", "$@4", "$@5", "AGENTS", "ITEMOPEN", "$@6", "ITEM", "$@7", "$@8",
-  "$@9", "$@10", "ITEMAFTERFIELD", "$@11", "SCHEMAOPEN", "$@12", "SCHEMA",
-  "$@13", "SHAREDITEMS", "opt_eol", "LOCALITEMS", "ASSIGNMENTOPEN", "$@14",
-  "$@15", "ASSIGNMENT", "$@16", "$@17", "$@18", "ASSIGNMENTAGENTS", 0
+  "$@3", "$@4", "$@5", "$@6", "AGENTS", "CHANNELOPEN", "$@7", "CHANNEL",
+  "$@8", "$@9", "$@10", "CHANNELAFTERFIELD", "$@11", "ITEMOPEN", "$@12",
+  "ITEM", "$@13", "$@14", "$@15", "$@16", "$@17", "$@18", "ITEMAFTERFIELD",
+  "$@19", "SCHEMAOPEN", "$@20", "SCHEMA", "$@21", "SHAREDITEMS", "opt_eol",
+  "LOCALITEMS", "ASSIGNMENTOPEN", "$@22", "$@23", "ASSIGNMENT", "$@24",
+  "$@25", "$@26", "ASSIGNMENTAGENTS", 0
 };
 #endif
 
@@ -518,26 +532,30 @@ static const yytype_uint16 yytoknum[] =
 static const yytype_uint8 yyr1[] =
 {
        0,    24,    25,    27,    26,    28,    26,    29,    26,    30,
-      26,    31,    26,    26,    26,    26,    32,    32,    32,    34,
-      33,    33,    33,    36,    35,    37,    35,    38,    35,    39,
-      35,    35,    35,    41,    40,    40,    40,    40,    43,    42,
-      42,    42,    45,    44,    44,    44,    44,    44,    44,    44,
-      46,    46,    46,    47,    47,    48,    48,    48,    50,    49,
-      51,    49,    49,    53,    52,    54,    52,    55,    52,    52,
-      52,    52,    52,    56,    56,    56
+      26,    31,    26,    32,    26,    26,    26,    26,    33,    33,
+      33,    35,    34,    34,    34,    37,    36,    38,    36,    39,
+      36,    36,    36,    41,    40,    40,    40,    40,    43,    42,
+      42,    42,    45,    44,    46,    44,    47,    44,    48,    44,
+      49,    44,    50,    44,    44,    44,    52,    51,    51,    51,
+      51,    54,    53,    53,    53,    56,    55,    55,    55,    55,
+      55,    55,    55,    57,    57,    57,    58,    58,    59,    59,
+      59,    61,    60,    62,    60,    60,    64,    63,    65,    63,
+      66,    63,    63,    63,    63,    63,    67,    67,    67
 };
 
 /* YYR2[YYN] -- Number of symbols composing right hand side of rule YYN.  */
 static const yytype_uint8 yyr2[] =
 {
        0,     2,     1,     0,     3,     0,     6,     0,     7,     0,
-       5,     0,     5,     3,     1,     1,     1,     3,     1,     0,
-       3,     2,     1,     0,     3,     0,     5,     0,     5,     0,
+       5,     0,     5,     0,     5,     3,     1,     1,     1,     3,
+       1,     0,     3,     2,     1,     0,     3,     0,     5,     0,
        5,     1,     1,     0,     3,     2,     1,     1,     0,     3,
-       2,     1,     0,     3,     5,     4,     5,     4,     1,     1,
-       1,     4,     1,     0,     1,     1,     4,     1,     0,     3,
-       0,     3,     1,     0,     3,     0,     6,     0,     5,     5,
-       4,     1,     1,     1,     3,     1
+       2,     1,     0,     3,     0,     5,     0,     5,     0,     5,
+       0,     5,     0,     5,     1,     1,     0,     3,     2,     1,
+       1,     0,     3,     2,     1,     0,     3,     5,     4,     5,
+       4,     1,     1,     1,     4,     1,     0,     1,     1,     4,
+       1,     0,     3,     0,     3,     1,     0,     3,     0,     6,
+       0,     5,     5,     4,     1,     1,     1,     3,     1
 };
 
 /* YYDEFACT[STATE-NAME] -- Default reduction number in state STATE-NUM.
@@ -545,123 +563,141 @@ static const yytype_uint8 yyr2[] =
    means the default is an error.  */
 static const yytype_uint8 yydefact[] =
 {
-       0,    15,     0,     0,     0,     0,     3,    14,     0,     2,
-       0,     9,    11,    62,    60,    58,     0,     0,     1,    18,
-      16,     0,     0,     0,     0,     0,    13,     4,     0,     0,
-       5,    22,     0,    19,     0,    41,     0,    38,     0,    72,
-       0,     0,    71,    63,    61,    59,     7,    17,     0,    32,
-       0,     0,     0,    31,    23,    21,     0,    10,    49,     0,
-       0,    48,    42,    40,     0,    12,     0,     0,     0,     0,
-       6,     0,     0,     0,     0,    20,     0,     0,     0,    39,
-      67,    75,    73,     0,    64,     8,    25,    27,    29,    24,
-      52,    50,     0,    57,    55,     0,    43,     0,     0,     0,
-       0,    70,     0,     0,     0,     0,    53,    45,     0,    53,
-      47,     0,    68,    69,    74,    37,     0,    36,    33,    26,
-      28,    30,    44,    54,     0,    46,     0,    66,    35,     0,
-      51,    56,    34
+       0,    17,     0,     0,     0,     0,     0,     3,    16,     0,
+       2,     0,    11,    13,    85,    83,    81,     0,     9,     0,
+       1,    20,    18,     0,     0,     0,     0,     0,    15,     0,
+       4,     0,     0,     5,    41,     0,    38,     0,    64,     0,
+      61,     0,    95,     0,     0,    94,    86,    84,    82,    24,
+       0,    21,     0,     7,    19,     0,    55,     0,     0,     0,
+       0,    54,    42,    40,     0,    12,    72,     0,     0,    71,
+      65,    63,     0,    14,     0,     0,     0,    32,     0,     0,
+      31,    25,    23,     0,    10,     0,     6,     0,     0,     0,
+       0,     0,    39,     0,     0,     0,    62,    90,    98,    96,
+       0,    87,     0,     0,     0,    22,     8,    44,    46,    48,
+      52,    50,    43,    75,    73,     0,    80,    78,     0,    66,
+       0,     0,     0,     0,    93,    27,    29,    26,     0,     0,
+       0,     0,     0,     0,    76,    68,     0,    76,    70,     0,
+      91,    92,    97,     0,     0,    60,     0,    59,    56,    45,
+      47,    49,    53,    51,    67,    77,     0,    69,     0,    89,
+      37,     0,    36,    33,    28,    30,    58,     0,    74,    79,
+      35,     0,    57,    34
 };
 
 /* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int16 yydefgoto[] =
 {
-      -1,     8,     9,    17,    48,    69,    22,    23,    21,    34,
-      56,    55,    74,   102,   103,   104,   119,   129,    38,    64,
-      63,    78,    92,   124,    95,    16,    25,    24,    44,    68,
-      97,    98,    83
+      -1,     9,    10,    19,    55,    85,    29,    24,    25,    23,
+      52,    83,    82,   104,   143,   144,   164,   171,    37,    64,
+      63,    91,   128,   129,   130,   132,   131,   149,   167,    41,
+      72,    71,    95,   115,   156,   118,    17,    27,    26,    47,
+      76,   120,   121,   100
 };
 
 /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
    STATE-NUM.  */
-#define YYPACT_NINF -75
+#define YYPACT_NINF -101
 static const yytype_int8 yypact[] =
 {
-       5,   -75,    15,     8,    24,    61,   -75,   -75,    39,   -75,
-       2,   -75,   -75,   -75,   -75,   -75,     5,     5,   -75,   -75,
-     -75,    -4,    79,    90,    66,    61,   -75,   -75,    22,    31,
-     -75,   -75,    50,   -75,     5,   -75,    74,   -75,     5,   -75,
-      51,    53,   -75,   -75,   -75,   -75,   -75,   -75,     5,   -75,
-      65,    75,    76,   -75,   -75,   -75,    79,   -75,   -75,    77,
-      80,   -75,   -75,   -75,    90,   -75,    84,     3,    66,     5,
-     -75,    86,    88,    89,    50,   -75,    11,    12,    74,   -75,
-      85,   -75,   -75,    28,   -75,   -75,   -75,   -75,   -75,   -75,
-     -75,   -75,    42,   -75,   -75,    55,   -75,    87,    66,    66,
-      92,   -75,    68,    68,    68,    74,    91,   -75,    74,    91,
-     -75,    66,   -75,   -75,   -75,   -75,    50,   -75,   -75,   -75,
-     -75,   -75,   -75,   -75,    93,   -75,    94,   -75,   -75,    50,
-     -75,   -75,   -75
+      10,  -101,   -12,    -8,    -2,    55,     3,  -101,  -101,    34,
+    -101,     6,  -101,  -101,  -101,  -101,  -101,    10,  -101,    10,
+    -101,  -101,  -101,   105,    88,    99,    82,    55,  -101,   100,
+    -101,    16,    27,  -101,  -101,    36,  -101,    10,  -101,     8,
+    -101,    10,  -101,    35,    50,  -101,  -101,  -101,  -101,  -101,
+      85,  -101,    10,  -101,  -101,    10,  -101,    61,    79,    81,
+      94,  -101,  -101,  -101,    88,  -101,  -101,    98,   108,  -101,
+    -101,  -101,    99,  -101,    37,     9,    82,  -101,   109,   115,
+    -101,  -101,  -101,   100,  -101,    10,  -101,    58,    86,    90,
+      52,    36,  -101,    21,    26,     8,  -101,   116,  -101,  -101,
+      41,  -101,   117,   119,    85,  -101,  -101,  -101,  -101,  -101,
+    -101,  -101,  -101,  -101,  -101,    63,  -101,  -101,    69,  -101,
+     118,    82,    82,   102,  -101,  -101,  -101,  -101,    91,    91,
+      91,    91,    91,     8,   120,  -101,     8,   120,  -101,    82,
+    -101,  -101,  -101,    96,    96,  -101,    36,  -101,  -101,  -101,
+    -101,  -101,  -101,  -101,  -101,  -101,   123,  -101,   124,  -101,
+    -101,    85,  -101,  -101,  -101,  -101,  -101,    36,  -101,  -101,
+    -101,    85,  -101,  -101
 };
 
 /* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-     -75,   -75,   -15,   -75,   -75,   -75,   -75,   -75,   -75,    58,
-     -75,   -74,   -75,   -75,   -75,   -75,   -73,   -75,    45,   -75,
-     -71,   -75,   -75,     6,   -75,    95,   -75,   -75,   -63,   -75,
-     -75,   -75,   -75
+    -101,  -101,   -16,  -101,  -101,  -101,  -101,  -101,  -101,  -101,
+      56,  -101,  -100,  -101,  -101,  -101,    -4,  -101,    77,  -101,
+     -91,  -101,  -101,  -101,  -101,  -101,  -101,    -1,  -101,    71,
+    -101,   -87,  -101,  -101,     7,  -101,   121,  -101,  -101,   -74,
+    -101,  -101,  -101,  -101
 };
 
 /* YYTABLE[YYPACT[STATE-NUM]].  What to do in state STATE-NUM.  If
    positive, shift that token.  If negative, reduce the rule which
    number is the opposite.  If YYTABLE_NINF, syntax error.  */
-#define YYTABLE_NINF -66
+#define YYTABLE_NINF -89
 static const yytype_int16 yytable[] =
 {
-      89,    26,    27,    19,    81,    84,     1,    96,     2,     3,
-       4,     5,    90,    93,    28,    29,    20,    82,    30,    57,
-     101,   107,    11,    65,   110,    91,    94,     6,     7,    39,
-     120,   121,    10,    70,   122,   112,   113,   125,    12,    18,
-      40,    41,   128,    58,    46,    47,    99,   100,   127,    42,
-      43,    49,    59,    60,    85,   132,    58,    50,    51,    52,
-     105,   106,    13,    61,    62,    59,    60,    39,    66,   115,
-      67,    53,    54,   108,   109,    58,    61,    62,    40,    41,
-      31,    14,    71,    15,    59,    60,   116,    42,    43,   117,
-     118,    35,    72,    73,    76,    61,    62,    77,    80,    32,
-      86,    33,    87,   -65,    88,   111,   114,   130,   131,    79,
-      36,     0,    37,   123,    75,   126,     0,     0,     0,     0,
-      45
+     112,    28,   101,    30,   127,    11,    12,    21,   119,    66,
+      98,     1,    13,     2,     3,     4,     5,    18,    67,    68,
+      22,    65,   113,    99,     6,    73,   124,   116,   135,    69,
+      70,   138,     7,     8,    20,   114,    84,    56,    53,    86,
+     117,    54,    42,    57,    58,    59,   154,   140,   141,   157,
+      60,    97,    74,    43,    44,   166,    14,    61,    62,   122,
+     123,   170,    45,    46,    66,   159,   110,    75,   111,   106,
+      66,   173,   107,    67,    68,    15,   172,    16,    87,    67,
+      68,   133,   134,    42,    69,    70,    77,   136,   137,    34,
+      69,    70,   145,    78,    43,    44,    88,   160,    89,    79,
+      38,    49,   108,    45,    46,   109,    80,    81,    35,   146,
+      36,    90,   147,   148,   161,    93,   142,   162,   163,    39,
+      50,    40,    51,    31,    32,    94,   102,    33,   150,   151,
+     152,   153,   103,   125,   -88,   126,   139,   168,   169,   105,
+     165,    92,   155,    96,   158,     0,     0,     0,    48
 };
 
 #define yypact_value_is_default(yystate) \
-  ((yystate) == (-75))
+  ((yystate) == (-101))
 
 #define yytable_value_is_error(yytable_value) \
   YYID (0)
 
 static const yytype_int16 yycheck[] =
 {
-      74,    16,    17,     1,     1,    68,     1,    78,     3,     4,
-       5,     6,     1,     1,    18,    19,    14,    14,    22,    34,
-      83,    92,    14,    38,    95,    14,    14,    22,    23,     1,
-     103,   104,    17,    48,   105,    98,    99,   108,    14,     0,
-      12,    13,   116,     1,    22,    14,    18,    19,   111,    21,
-      22,     1,    10,    11,    69,   129,     1,     7,     8,     9,
-      18,    19,     1,    21,    22,    10,    11,     1,    17,     1,
-      17,    21,    22,    18,    19,     1,    21,    22,    12,    13,
-       1,    20,    17,    22,    10,    11,    18,    21,    22,    21,
-      22,     1,    17,    17,    17,    21,    22,    17,    14,    20,
-      14,    22,    14,    18,    15,    18,    14,    14,    14,    64,
-      20,    -1,    22,    22,    56,   109,    -1,    -1,    -1,    -1,
-      25
+      91,    17,    76,    19,   104,    17,    14,     1,    95,     1,
+       1,     1,    14,     3,     4,     5,     6,    14,    10,    11,
+      14,    37,     1,    14,    14,    41,   100,     1,   115,    21,
+      22,   118,    22,    23,     0,    14,    52,     1,    22,    55,
+      14,    14,     1,     7,     8,     9,   133,   121,   122,   136,
+      14,    14,    17,    12,    13,   146,     1,    21,    22,    18,
+      19,   161,    21,    22,     1,   139,    14,    17,    16,    85,
+       1,   171,    14,    10,    11,    20,   167,    22,    17,    10,
+      11,    18,    19,     1,    21,    22,     1,    18,    19,     1,
+      21,    22,     1,     8,    12,    13,    17,     1,    17,    14,
+       1,     1,    16,    21,    22,    15,    21,    22,    20,    18,
+      22,    17,    21,    22,    18,    17,    14,    21,    22,    20,
+      20,    22,    22,    18,    19,    17,    17,    22,   129,   130,
+     131,   132,    17,    16,    18,    16,    18,    14,    14,    83,
+     144,    64,    22,    72,   137,    -1,    -1,    -1,    27
 };
 
 /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
    symbol of state STATE-NUM.  */
 static const yytype_uint8 yystos[] =
 {
-       0,     1,     3,     4,     5,     6,    22,    23,    25,    26,
-      17,    14,    14,     1,    20,    22,    49,    27,     0,     1,
-      14,    32,    30,    31,    51,    50,    26,    26,    18,    19,
-      22,     1,    20,    22,    33,     1,    20,    22,    42,     1,
-      12,    13,    21,    22,    52,    49,    22,    14,    28,     1,
-       7,     8,     9,    21,    22,    35,    34,    26,     1,    10,
-      11,    21,    22,    44,    43,    26,    17,    17,    53,    29,
-      26,    17,    17,    17,    36,    33,    17,    17,    45,    42,
-      14,     1,    14,    56,    52,    26,    14,    14,    15,    35,
-       1,    14,    46,     1,    14,    48,    44,    54,    55,    18,
-      19,    52,    37,    38,    39,    18,    19,    44,    18,    19,
-      44,    18,    52,    52,    14,     1,    18,    21,    22,    40,
-      40,    40,    44,    22,    47,    44,    47,    52,    35,    41,
-      14,    14,    35
+       0,     1,     3,     4,     5,     6,    14,    22,    23,    25,
+      26,    17,    14,    14,     1,    20,    22,    60,    14,    27,
+       0,     1,    14,    33,    31,    32,    62,    61,    26,    30,
+      26,    18,    19,    22,     1,    20,    22,    42,     1,    20,
+      22,    53,     1,    12,    13,    21,    22,    63,    60,     1,
+      20,    22,    34,    22,    14,    28,     1,     7,     8,     9,
+      14,    21,    22,    44,    43,    26,     1,    10,    11,    21,
+      22,    55,    54,    26,    17,    17,    64,     1,     8,    14,
+      21,    22,    36,    35,    26,    29,    26,    17,    17,    17,
+      17,    45,    42,    17,    17,    56,    53,    14,     1,    14,
+      67,    63,    17,    17,    37,    34,    26,    14,    16,    15,
+      14,    16,    44,     1,    14,    57,     1,    14,    59,    55,
+      65,    66,    18,    19,    63,    16,    16,    36,    46,    47,
+      48,    50,    49,    18,    19,    55,    18,    19,    55,    18,
+      63,    63,    14,    38,    39,     1,    18,    21,    22,    51,
+      51,    51,    51,    51,    55,    22,    58,    55,    58,    63,
+       1,    18,    21,    22,    40,    40,    44,    52,    14,    14,
+      36,    41,    44,    36
 };
 
 #define yyerrok		(yyerrstatus = 0)
@@ -1501,315 +1537,406 @@ yyreduce:
         case 3:
 
 /* Line 1806 of yacc.c  */
-#line 50 "xrtdb.y"
+#line 60 "xrtdb.y"
     { nline++; }
     break;
 
   case 5:
 
 /* Line 1806 of yacc.c  */
-#line 51 "xrtdb.y"
+#line 61 "xrtdb.y"
     { nline++; }
     break;
 
   case 7:
 
 /* Line 1806 of yacc.c  */
-#line 52 "xrtdb.y"
+#line 62 "xrtdb.y"
     { nline++; }
     break;
 
   case 9:
 
 /* Line 1806 of yacc.c  */
-#line 53 "xrtdb.y"
-    { pItem= itemCreate((yyvsp[(2) - (2)])); }
+#line 63 "xrtdb.y"
+    { pChannel= channelCreate((yyvsp[(1) - (2)]), (yyvsp[(2) - (2)])); }
     break;
 
   case 11:
 
 /* Line 1806 of yacc.c  */
-#line 54 "xrtdb.y"
+#line 64 "xrtdb.y"
+    { pItem= itemCreate((yyvsp[(2) - (2)])); }
+    break;
+
+  case 13:
+
+/* Line 1806 of yacc.c  */
+#line 65 "xrtdb.y"
     { pSchema= schemaCreate((yyvsp[(2) - (2)])); }
     break;
 
-  case 14:
+  case 16:
 
 /* Line 1806 of yacc.c  */
-#line 56 "xrtdb.y"
+#line 67 "xrtdb.y"
     { return 0; }
     break;
 
-  case 15:
+  case 17:
 
 /* Line 1806 of yacc.c  */
-#line 57 "xrtdb.y"
+#line 68 "xrtdb.y"
     { raiseError(nline, _ERR_INITIAL_); }
     break;
 
-  case 16:
+  case 18:
 
 /* Line 1806 of yacc.c  */
-#line 60 "xrtdb.y"
+#line 71 "xrtdb.y"
     { agentCreate((yyvsp[(1) - (1)])); }
     break;
 
-  case 17:
+  case 19:
 
 /* Line 1806 of yacc.c  */
-#line 61 "xrtdb.y"
+#line 72 "xrtdb.y"
     { agentCreate((yyvsp[(3) - (3)])); }
     break;
 
-  case 18:
+  case 20:
 
 /* Line 1806 of yacc.c  */
-#line 62 "xrtdb.y"
+#line 73 "xrtdb.y"
     { raiseError(nline, _ERR_AGENTS_); }
     break;
 
-  case 19:
+  case 21:
 
 /* Line 1806 of yacc.c  */
-#line 65 "xrtdb.y"
+#line 76 "xrtdb.y"
     { nline++; }
     break;
 
-  case 22:
+  case 24:
 
 /* Line 1806 of yacc.c  */
-#line 67 "xrtdb.y"
+#line 78 "xrtdb.y"
+    { raiseError(nline, _ERR_CHANNELOPEN_); }
+    break;
+
+  case 25:
+
+/* Line 1806 of yacc.c  */
+#line 81 "xrtdb.y"
+    { nline++; }
+    break;
+
+  case 27:
+
+/* Line 1806 of yacc.c  */
+#line 82 "xrtdb.y"
+    { channelAddField(pChannel, "period", (yyvsp[(3) - (3)])); }
+    break;
+
+  case 29:
+
+/* Line 1806 of yacc.c  */
+#line 83 "xrtdb.y"
+    { channelAddField(pChannel, (yyvsp[(1) - (3)]), (yyvsp[(3) - (3)])); }
+    break;
+
+  case 31:
+
+/* Line 1806 of yacc.c  */
+#line 84 "xrtdb.y"
+    { channelVerify(pChannel); }
+    break;
+
+  case 32:
+
+/* Line 1806 of yacc.c  */
+#line 85 "xrtdb.y"
+    { raiseError(nline, _ERR_CHANNELFIELD_); }
+    break;
+
+  case 33:
+
+/* Line 1806 of yacc.c  */
+#line 88 "xrtdb.y"
+    { nline++; }
+    break;
+
+  case 36:
+
+/* Line 1806 of yacc.c  */
+#line 90 "xrtdb.y"
+    { channelVerify(pChannel); }
+    break;
+
+  case 37:
+
+/* Line 1806 of yacc.c  */
+#line 91 "xrtdb.y"
+    { raiseError(nline, _ERR_CHANNELAFTERFIELD_); }
+    break;
+
+  case 38:
+
+/* Line 1806 of yacc.c  */
+#line 94 "xrtdb.y"
+    { nline++; }
+    break;
+
+  case 41:
+
+/* Line 1806 of yacc.c  */
+#line 96 "xrtdb.y"
     { raiseError(nline, _ERR_ITEMOPEN_); }
     break;
 
-  case 23:
+  case 42:
 
 /* Line 1806 of yacc.c  */
-#line 70 "xrtdb.y"
+#line 99 "xrtdb.y"
     { nline++; }
     break;
 
-  case 25:
+  case 44:
 
 /* Line 1806 of yacc.c  */
-#line 71 "xrtdb.y"
+#line 100 "xrtdb.y"
     { itemAddDatatype(pItem, (yyvsp[(3) - (3)])); }
     break;
 
-  case 27:
+  case 46:
 
 /* Line 1806 of yacc.c  */
-#line 72 "xrtdb.y"
+#line 101 "xrtdb.y"
     { itemAddPeriod(pItem, (yyvsp[(3) - (3)])); }
     break;
 
-  case 29:
+  case 48:
 
 /* Line 1806 of yacc.c  */
-#line 73 "xrtdb.y"
+#line 102 "xrtdb.y"
     { itemAddHeaderfile(pItem, (yyvsp[(3) - (3)])); }
     break;
 
-  case 31:
+  case 50:
+
+/* Line 1806 of yacc.c  */
+#line 103 "xrtdb.y"
+    { itemAddField(pItem, (yyvsp[(1) - (3)]), (yyvsp[(3) - (3)])); }
+    break;
+
+  case 52:
+
+/* Line 1806 of yacc.c  */
+#line 104 "xrtdb.y"
+    { itemAddName(pItem, (yyvsp[(1) - (3)]), (yyvsp[(3) - (3)])); }
+    break;
+
+  case 54:
 
 /* Line 1806 of yacc.c  */
-#line 74 "xrtdb.y"
+#line 105 "xrtdb.y"
     { itemVerify(pItem); }
     break;
 
-  case 32:
+  case 55:
 
 /* Line 1806 of yacc.c  */
-#line 75 "xrtdb.y"
+#line 106 "xrtdb.y"
     { raiseError(nline, _ERR_ITEMFIELD_); }
     break;
 
-  case 33:
+  case 56:
 
 /* Line 1806 of yacc.c  */
-#line 78 "xrtdb.y"
+#line 109 "xrtdb.y"
     { nline++; }
     break;
 
-  case 36:
+  case 59:
 
 /* Line 1806 of yacc.c  */
-#line 80 "xrtdb.y"
+#line 111 "xrtdb.y"
     { itemVerify(pItem); }
     break;
 
-  case 37:
+  case 60:
 
 /* Line 1806 of yacc.c  */
-#line 81 "xrtdb.y"
+#line 112 "xrtdb.y"
     { raiseError(nline, _ERR_ITEMAFTERFIELD_); }
     break;
 
-  case 38:
+  case 61:
 
 /* Line 1806 of yacc.c  */
-#line 84 "xrtdb.y"
+#line 115 "xrtdb.y"
     { nline++; }
     break;
 
-  case 41:
+  case 64:
 
 /* Line 1806 of yacc.c  */
-#line 86 "xrtdb.y"
+#line 117 "xrtdb.y"
     { raiseError(nline, _ERR_SCHEMAOPEN_); }
     break;
 
-  case 42:
+  case 65:
 
 /* Line 1806 of yacc.c  */
-#line 89 "xrtdb.y"
+#line 120 "xrtdb.y"
     { nline++; }
     break;
 
-  case 48:
+  case 71:
 
 /* Line 1806 of yacc.c  */
-#line 94 "xrtdb.y"
+#line 125 "xrtdb.y"
     { schemaVerify(pSchema); }
     break;
 
-  case 49:
+  case 72:
 
 /* Line 1806 of yacc.c  */
-#line 95 "xrtdb.y"
+#line 126 "xrtdb.y"
     { raiseError(nline, _ERR_SCHEMAFIELD_); }
     break;
 
-  case 50:
+  case 73:
 
 /* Line 1806 of yacc.c  */
-#line 98 "xrtdb.y"
+#line 129 "xrtdb.y"
     { schemaAddSharedItem(pSchema, (yyvsp[(1) - (1)])); }
     break;
 
-  case 51:
+  case 74:
 
 /* Line 1806 of yacc.c  */
-#line 99 "xrtdb.y"
+#line 130 "xrtdb.y"
     { schemaAddSharedItem(pSchema, (yyvsp[(4) - (4)])); }
     break;
 
-  case 52:
+  case 75:
 
 /* Line 1806 of yacc.c  */
-#line 100 "xrtdb.y"
+#line 131 "xrtdb.y"
     { raiseError(nline, _ERR_ITEMSLIST_); }
     break;
 
-  case 54:
+  case 77:
 
 /* Line 1806 of yacc.c  */
-#line 104 "xrtdb.y"
+#line 135 "xrtdb.y"
     { nline++; }
     break;
 
-  case 55:
+  case 78:
 
 /* Line 1806 of yacc.c  */
-#line 107 "xrtdb.y"
+#line 138 "xrtdb.y"
     { schemaAddLocalItem(pSchema, (yyvsp[(1) - (1)])); }
     break;
 
-  case 56:
+  case 79:
 
 /* Line 1806 of yacc.c  */
-#line 108 "xrtdb.y"
+#line 139 "xrtdb.y"
     { schemaAddLocalItem(pSchema, (yyvsp[(4) - (4)])); }
     break;
 
-  case 57:
+  case 80:
 
 /* Line 1806 of yacc.c  */
-#line 109 "xrtdb.y"
+#line 140 "xrtdb.y"
     { raiseError(nline, _ERR_ITEMSLIST_); }
     break;
 
-  case 58:
+  case 81:
 
 /* Line 1806 of yacc.c  */
-#line 112 "xrtdb.y"
+#line 143 "xrtdb.y"
     { nline++; }
     break;
 
-  case 60:
+  case 83:
 
 /* Line 1806 of yacc.c  */
-#line 113 "xrtdb.y"
+#line 144 "xrtdb.y"
     { pAssign= assignmentCreate(); }
     break;
 
-  case 62:
+  case 85:
 
 /* Line 1806 of yacc.c  */
-#line 114 "xrtdb.y"
+#line 145 "xrtdb.y"
     { raiseError(nline, _ERR_ASSIGNMENTOPEN_); }
     break;
 
-  case 63:
+  case 86:
 
 /* Line 1806 of yacc.c  */
-#line 117 "xrtdb.y"
+#line 148 "xrtdb.y"
     { nline++; }
     break;
 
-  case 65:
+  case 88:
 
 /* Line 1806 of yacc.c  */
-#line 118 "xrtdb.y"
+#line 149 "xrtdb.y"
     { assignmentAddSchema(pAssign, (yyvsp[(3) - (3)])); }
     break;
 
-  case 67:
+  case 90:
 
 /* Line 1806 of yacc.c  */
-#line 119 "xrtdb.y"
+#line 150 "xrtdb.y"
     { assignmentAddSchema(pAssign, (yyvsp[(3) - (3)])); }
     break;
 
-  case 71:
+  case 94:
 
 /* Line 1806 of yacc.c  */
-#line 122 "xrtdb.y"
+#line 153 "xrtdb.y"
     { assignmentVerify(pAssign); }
     break;
 
-  case 72:
+  case 95:
 
 /* Line 1806 of yacc.c  */
-#line 123 "xrtdb.y"
+#line 154 "xrtdb.y"
     { raiseError(nline, _ERR_ASSIGNMENT_); }
     break;
 
-  case 73:
+  case 96:
 
 /* Line 1806 of yacc.c  */
-#line 126 "xrtdb.y"
+#line 157 "xrtdb.y"
     { assignmentAddAgent(pAssign, (yyvsp[(1) - (1)])); }
     break;
 
-  case 74:
+  case 97:
 
 /* Line 1806 of yacc.c  */
-#line 127 "xrtdb.y"
+#line 158 "xrtdb.y"
     { assignmentAddAgent(pAssign, (yyvsp[(3) - (3)])); }
     break;
 
-  case 75:
+  case 98:
 
 /* Line 1806 of yacc.c  */
-#line 128 "xrtdb.y"
+#line 159 "xrtdb.y"
     { raiseError(nline, _ERR_AGENTSLIST_); }
     break;
 
 
 
 /* Line 1806 of yacc.c  */
-#line 1809 "xrtdb.tab.c"
+#line 1940 "xrtdb.tab.c"
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -2040,7 +2167,7 @@ yyreturn:
 
 
 /* Line 2067 of yacc.c  */
-#line 131 "xrtdb.y"
+#line 162 "xrtdb.y"
 
 
 
@@ -2077,6 +2204,9 @@ int main(int argc, char *argv[])
         agList.numAg= 0;
         agList.agents= malloc(sizeof(rtdb_Agent));
 
+        chList.numCh= 0;
+        chList.channels= malloc(sizeof(rtdb_Channel));
+
         itList.numIt= 0;
         itList.items= malloc(sizeof(rtdb_Item));
 
@@ -2159,8 +2289,8 @@ int main(int argc, char *argv[])
 
         }
 
-        //Vars to store return values of printUserFile() and printIniFile()
-        int userFileStatus, iniFileStatus; 
+        //Vars to store return values of printUserFile(), printTypedFile() and printIniFile()
+        int userFileStatus, typedFileStatus, iniFileStatus; 
 
         printf("\nA criar o ficheiro \e[32mrtdb_user.h\e[0m\n");
 
@@ -2182,9 +2312,30 @@ int main(int argc, char *argv[])
                         printf("\n\e[33mERRO\e[0m a criar o ficheiro \e[32mrtdb_user.h\e[0m. Não foi possível abrir o ficheiro para escrita.\n");
                         break;
                         }
-                default:
-                	printf("\n\e[33mERRO\e[0m inesperado a criar o ficheiro \e[32mrtdb_user.h\e[0m!\n");
-                	break;
+                default: printf("\n\e[33mERRO\e[0m inesperado a criar o ficheiro \e[32mrtdb_user.h\e[0m!\n");
+        }
+
+        printf("\nA criar o ficheiro \e[32mrtdb_typed.h\e[0m\n");
+
+        //Call printTypedFile() to generate the rtdb_typed.h file
+        typedFileStatus= printTypedFile(itList, assignList);
+
+        //Check return value of printTypedFile() and output according message
+        switch (typedFileStatus)
+        {
+                case 0: {
+                        printf("\nFicheiro \e[32mrtdb_typed.h\e[0m criado com sucesso!\n");
+                        break;
+                        }
+                case 1: {
+                        printf("\nCriação do ficheiro \e[32mrtdb_typed.h\e[0m cancelada pelo utilizador.\n");
+                        break;
+                        }
+                case 2: {
+                        printf("\n\e[33mERRO\e[0m a criar o ficheiro \e[32mrtdb_typed.h\e[0m. Não foi possível abrir o ficheiro para escrita.\n");
+                        break;
+                        }
+                default: printf("\n\e[33mERRO\e[0m inesperado a criar o ficheiro \e[32mrtdb_typed.h\e[0m!\n");
         }
 
         //Check if there are assignments defined
@@ -2196,7 +2347,7 @@ int main(int argc, char *argv[])
         printf("\nA criar o ficheiro \e[32mrtdb.ini\e[0m\n");
 
         //Call printIniFile() to generate the rtdb.ini file
-        iniFileStatus= printIniFile(agList, assignList);
+        iniFileStatus= printIniFile(agList, assignList, chList);
 
         //Check return value of printIniFile() and output according message
         switch (iniFileStatus)
@@ -2213,9 +2364,7 @@ int main(int argc, char *argv[])
                         printf("\n\e[33mERRO\e[0m a criar o ficheiro \e[32mrtdb.ini\e[0m. Não foi possível abrir o ficheiro para escrita.\n");
                         break;
                         }
-                default:
-                	printf("\n\e[33mERRO\e[0m inesperado a criar o ficheiro \e[32mrtdb.ini\e[0m!\n");
-                	break;
+                default: printf("\n\e[33mERRO\e[0m inesperado a criar o ficheiro \e[32mrtdb.ini\e[0m!\n");
         }
 
         //Free the dynamically allocated vars
@@ -48,6 +48,7 @@ void yyerror(char *);
 unsigned nline= 1;
 
 //Aux global vars to create the global lists defined in rtdb_functions.h
+rtdb_Channel * pChannel;
 rtdb_Item * pItem;
 rtdb_Schema * pSchema;
 rtdb_Assignment * pAssign;
@@ -59,6 +60,7 @@ S :   INITIAL;
 INITIAL:    eol { nline++; } INITIAL
           | agentsDECL equal AGENTS eol { nline++; } INITIAL
           | agentsDECL equal AGENTS semicomma eol { nline++; } INITIAL
+          | identifier identifier { pChannel= channelCreate($1, $2); } CHANNELOPEN INITIAL
           | itemDECL identifier { pItem= itemCreate($2); } ITEMOPEN INITIAL
           | schemaDECL identifier { pSchema= schemaCreate($2); } SCHEMAOPEN INITIAL
           | assignmentDECL ASSIGNMENTOPEN INITIAL
@@ -71,6 +73,24 @@ AGENTS:     identifier { agentCreate($1); }
           | error { raiseError(nline, _ERR_AGENTS_); }
           ;
 
+CHANNELOPEN:   eol { nline++; } CHANNELOPEN
+             | openbrace CHANNEL
+             | error { raiseError(nline, _ERR_CHANNELOPEN_); }
+             ;
+
+CHANNEL:    eol { nline++; } CHANNEL
+          | periodFIELD equal integer { channelAddField(pChannel, "period", $3); } CHANNELAFTERFIELD
+          | identifier equal integer { channelAddField(pChannel, $1, $3); } CHANNELAFTERFIELD
+          | closebrace { channelVerify(pChannel); }
+          | error { raiseError(nline, _ERR_CHANNELFIELD_); }
+          ;
+
+CHANNELAFTERFIELD:   eol { nline++; } CHANNEL
+                   | semicomma CHANNEL
+                   | closebrace { channelVerify(pChannel); }
+                   | error { raiseError(nline, _ERR_CHANNELAFTERFIELD_); }
+                   ;
+
 ITEMOPEN:   eol { nline++; } ITEMOPEN
           | openbrace ITEM
           | error { raiseError(nline, _ERR_ITEMOPEN_); }
@@ -78,8 +98,10 @@ ITEMOPEN:   eol { nline++; } ITEMOPEN
 
 ITEM:       eol { nline++; } ITEM
           | datatypeFIELD equal identifier { itemAddDatatype(pItem, $3); } ITEMAFTERFIELD
-          | periodFIELD equal identifier { itemAddPeriod(pItem, $3); } ITEMAFTERFIELD
+          | periodFIELD equal integer { itemAddPeriod(pItem, $3); } ITEMAFTERFIELD
           | headerfileFIELD equal headerfl { itemAddHeaderfile(pItem, $3); } ITEMAFTERFIELD
+          | identifier equal integer { itemAddField(pItem, $1, $3); } ITEMAFTERFIELD
+          | identifier equal identifier { itemAddName(pItem, $1, $3); } ITEMAFTERFIELD
           | closebrace { itemVerify(pItem); }
           | error { raiseError(nline, _ERR_ITEMFIELD_); }
           ;
@@ -173,6 +195,9 @@ int main(int argc, char *argv[])
         agList.numAg= 0;
         agList.agents= malloc(sizeof(rtdb_Agent));
 
+        chList.numCh= 0;
+        chList.channels= malloc(sizeof(rtdb_Channel));
+
         itList.numIt= 0;
         itList.items= malloc(sizeof(rtdb_Item));
 
@@ -255,8 +280,8 @@ int main(int argc, char *argv[])
 
         }
 
-        //Vars to store return values of printUserFile() and printIniFile()
-        int userFileStatus, iniFileStatus; 
+        //Vars to store return values of printUserFile(), printTypedFile() and printIniFile()
+        int userFileStatus, typedFileStatus, iniFileStatus; 
 
         printf("\nA criar o ficheiro \e[32mrtdb_user.h\e[0m\n");
 
@@ -281,6 +306,29 @@ int main(int argc, char *argv[])
                 default: printf("\n\e[33mERRO\e[0m inesperado a criar o ficheiro \e[32mrtdb_user.h\e[0m!\n");
         }
 
+        printf("\nA criar o ficheiro \e[32mrtdb_typed.h\e[0m\n");
+
+        //Call printTypedFile() to generate the rtdb_typed.h file
+        typedFileStatus= printTypedFile(itList, assignList);
+
+        //Check return value of printTypedFile() and output according message
+        switch (typedFileStatus)
+        {
+                case 0: {
+                        printf("\nFicheiro \e[32mrtdb_typed.h\e[0m criado com sucesso!\n");
+                        break;
+                        }
+                case 1: {
+                        printf("\nCriação do ficheiro \e[32mrtdb_typed.h\e[0m cancelada pelo utilizador.\n");
+                        break;
+                        }
+                case 2: {
+                        printf("\n\e[33mERRO\e[0m a criar o ficheiro \e[32mrtdb_typed.h\e[0m. Não foi possível abrir o ficheiro para escrita.\n");
+                        break;
+                        }
+                default: printf("\n\e[33mERRO\e[0m inesperado a criar o ficheiro \e[32mrtdb_typed.h\e[0m!\n");
+        }
+
         //Check if there are assignments defined
         if (assignList.numAs == 0)
         {
@@ -290,7 +338,7 @@ int main(int argc, char *argv[])
         printf("\nA criar o ficheiro \e[32mrtdb.ini\e[0m\n");
 
         //Call printIniFile() to generate the rtdb.ini file
-        iniFileStatus= printIniFile(agList, assignList);
+        iniFileStatus= printIniFile(agList, assignList, chList);
 
         //Check return value of printIniFile() and output according message
         switch (iniFileStatus)
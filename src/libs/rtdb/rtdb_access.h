@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA RTDB
+ *
+ * CAMBADA RTDB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA RTDB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RTDB_ACCESS_H
+#define __RTDB_ACCESS_H
+
+#ifndef __cplusplus
+#error "rtdb_access.h is C++ only, use rtdb_api.h from C"
+#endif
+
+#include "rtdb_api.h"
+
+//	Typed access to the RTDB, for C++ agents
+//		rtdb::get<ROBOT_WS>(agent, robot) instead of DB_get(agent, ROBOT_WS, &robot):
+//		the item id is a template constant and the type of the data is
+//		checked by the compiler. The datatype of each item is set by the
+//		rtdb_typed.h header generated by xrtdb, which also checks at build
+//		time that the sizes in rtdb.ini are still those of the datatypes.
+
+namespace rtdb
+{
+
+//	*************************
+//	item: datatype of an item, specialised for every item in rtdb_typed.h
+//
+template<int ID> struct item;
+
+//	*************************
+//	get: Le da base de dados
+//
+//	Entrada:
+//		int _from_agent = numero do agente
+//		T &_value = onde sao copiados os dados
+//	Saida:
+//		int life = tempo de vida da 'variavel' em ms
+//			-1 = erro
+//
+template<int ID> inline int get (int _from_agent, typename item<ID>::type &_value)
+{
+	return DB_get(_from_agent, ID, (void*)&_value);
+}
+
+//	*************************
+//	put: Escreve na base de dados do proprio agente
+//
+//	Saida:
+//		int size = size of record data
+//		-1 = erro
+//
+template<int ID> inline int put (const typename item<ID>::type &_value)
+{
+	return DB_put(ID, (void*)&_value);
+}
+
+//	*************************
+//	put_len: Escreve os primeiros _len bytes de um registo do proprio agente (see DB_put_len)
+//
+//	Saida:
+//		int len = bytes written
+//		-1 = erro
+//
+template<int ID> inline int put_len (const typename item<ID>::type &_value, int _len)
+{
+	return DB_put_len(ID, (void*)&_value, _len);
+}
+
+//	*************************
+//	get_at: value of an item at a past instant (see DB_get_at)
+//
+template<int ID> inline int get_at (int _from_agent, struct timeval *_time, typename item<ID>::type &_value)
+{
+	return DB_get_at(_from_agent, ID, _time, (void*)&_value);
+}
+
+//	*************************
+//	get_ref: in-place access to a record, without copying it (see DB_get_ref)
+//		note: check the data with DB_ref_valid after use
+//
+template<int ID> inline const typename item<ID>::type *get_ref (int _from_agent, int *_life, RTDBref *_ref)
+{
+	return static_cast<const typename item<ID>::type *>(DB_get_ref(_from_agent, ID, _life, _ref));
+}
+
+//	*************************
+//	put_begin: in-place writing of a record of the running agent (see DB_put_begin)
+//		note: publish it with DB_put_commit
+//
+template<int ID> inline typename item<ID>::type *put_begin (RTDBref *_ref)
+{
+	return static_cast<typename item<ID>::type *>(DB_put_begin(ID, _ref));
+}
+
+}
+
+//	*************************
+//	RTDB_CHECK_SIZE: build time check of the size of an item
+//		_size is the size written by xrtdb in rtdb.ini
+//
+#if __cplusplus >= 201103L
+#define RTDB_CHECK_SIZE(_id, _size) \
+	static_assert(sizeof(rtdb::item<_id>::type) == (_size), "size of " #_id " changed, run xrtdb again")
+#else
+#define RTDB_CHECK_SIZE(_id, _size) \
+	typedef char rtdb_size_of_##_id##_changed_run_xrtdb_again[(sizeof(rtdb::item<_id>::type) == (_size)) ? 1 : -1]
+#endif
+
+#endif
@@ -22,16 +22,30 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <sys/time.h>
 #include <sys/types.h>
-#include <sys/ipc.h>
-#include <sys/shm.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <time.h>
 #include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
 
 
 #include "rtdbdefs.h"
+#include "rtdb_api.h"
+#include "rtdb_comm.h"
+#include "rtdb_sim.h"
+#include "rtdb_record.h"
 
 
 //#define DEBUG
@@ -49,47 +63,108 @@
 #define PDEBUG(txt, par...)
 #endif
 
+// number of attempts of a reader before giving up on a record that keeps changing
+#define MAX_READ_RETRIES 8
+
+// memory ordering for the record sequence counters (seqlock)
+#define SEQ_LOAD(p)		__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SEQ_STORE(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define RMB()			__atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define WMB()			__atomic_thread_fence(__ATOMIC_RELEASE)
+#define MB()			__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+// record headers and banks get their own cache lines, so a writer never
+// invalidates the line of a record (or bank) somebody else is reading
+#define CACHE_LINE		64
+
+// segments are rounded up to this size when RTDB_HUGEPAGES is set
+#define HUGE_PAGE_SIZE	(2 * 1024 * 1024)
+
 
 typedef struct
 {
 	int id;							// id da 'variavel'
-	int size;						// sizeof da 'variavel'
+	int agent;						// agente a que pertence
+	int size;						// sizeof da 'variavel' (maximum length)
 	int period;						// refresh period for broadcast
-	int offset;						// offset para o campo de dados da 'variavel'
+	int offset;						// offset para o primeiro banco da 'variavel'
+	int local;						// 1 = local (never broadcast)
+	int channel;					// comm channel (0 = default)
+	unsigned int layout;			// hash of the layout of the data type (rtdb.ini, 0 = unknown)
 	int read_bank;					// variavel mais actual
-	struct timeval timestamp[2];	// relogio da maquina local
-} TRec;
+	int n_banks;					// banks in the ring (2 + history)
+	int stride;						// distance between banks (header + data)
+	unsigned int seq;				// sequence counter: odd while a write is in progress (futex word)
+	unsigned int waiters;			// processes blocked in DB_wait
+	int base;						// offset of this header from the start of the segment
+} __attribute__((aligned(CACHE_LINE))) TRec;
 
 
 typedef struct
 {
-	int self_agent;						// numero do agente onde esta a correr
-	int n_agents;						// numero total de agentes registados
-	int n_shared_recs[MAX_AGENTS];		// numero de 'variaveis' shared
-	int n_local_recs;					// numero de 'variaveis' local
-	int shared_mem_size[MAX_AGENTS];	// tamanho das areas shared
-	int local_mem_size;					// tamanho da area local
-	int rec_lut[MAX_AGENTS][MAX_RECS];	// lookuptable
-} RTDBdef;
+	struct timeval timestamp;		// relogio da maquina local
+	int length;						// bytes in use
+} TBank;
+
+// banks are cache line aligned, each one starts with its TBank header
+#define MEM_ALIGN(size)			(((size) + CACHE_LINE - 1) & ~(CACHE_LINE - 1))
+#define BANK_STRIDE(size)		((int)MEM_ALIGN(sizeof(TBank) + (size)))
+#define BANK(p_rec, b)			((TBank*)((char*)(p_rec) + (p_rec)->offset + (b) * (p_rec)->stride))
+#define BANK_DATA(p_rec, b)		((void*)(BANK(p_rec, b) + 1))
+
+
+// the segment of each RTDB instance is laid out as
+//	[ RTDBdef | directory | TRec ... | banks ... ]
+// the directory has one row per agent and one column per item id, with the
+// offset of the record header from the start of the segment (-1 = no record)
 
+#define RTDB_MAGIC	0x52544442	// set when the segment is initialized ("RTDB")
 
 typedef struct
 {
-	int n_shared_recs;
-	RTDBconf_var shared[MAX_RECS];
-	int n_local_recs;
-	RTDBconf_var local[MAX_RECS];
-} RTDBconf_agents;
+	unsigned int magic;			// RTDB_MAGIC once the segment is initialized
+	int self_agent;				// numero do agente onde esta a correr
+	int team;					// equipa do agente
+	int n_agents;				// numero total de agentes registados
+	int n_items;				// maior identificador de 'variavel' + 1
+	int n_recs;					// numero de 'variaveis' no segmento (shared + local)
+	int size;					// tamanho do segmento
+} RTDBdef;
+
+#define DIR(p_def)		((int*)((p_def) + 1))
+#define DIR_SIZE(n_agents, n_items)	MEM_ALIGN(sizeof(RTDBdef) + (n_agents) * (n_items) * sizeof(int))
+
 
+typedef struct
+{
+	int agent;					// agente a que pertence
+	int local;					// 1 = local, 0 = shared
+	RTDBconf_var var;
+} RTDBconf_rec;
 
-int def_shmid[MAX_AGENTS*2];					// identificador da area de definicoes
-RTDBdef *p_def[MAX_AGENTS*2];					// ponteiro para a area de definicoes
 
-int shared_shmid[MAX_AGENTS*2][MAX_AGENTS*2];	// array de identificadores das areas shared
-void *p_shared_mem[MAX_AGENTS*2][MAX_AGENTS*2];	// array de ponteiros para as areas shared
+// prefault thread of a flight recorder mapping
+typedef struct
+{
+	RTDBrec_header *p_hdr;		// the mapping
+	pthread_t thread;
+	int stop;					// set by DB_free
+} RTDBprefault;
 
-int local_shmid[MAX_AGENTS*2];				// identificador da area local
-void *p_local_mem[MAX_AGENTS*2];				// ponteiro para a area local
+typedef struct
+{
+	int fd;						// descritor do segmento (holds the shared lock)
+	int size;					// tamanho mapeado
+	RTDBdef *p_def;				// ponteiro para o segmento
+	RTDBrec_header *p_record;	// flight recorder file (NULL = not recording)
+	RTDBprefault *prefault;		// its prefault thread (NULL = none)
+} RTDBinst;
+
+static RTDBinst *rtdb_inst = NULL;	// instances attached by this process
+static int n_rtdb_inst = 0;
+static int rtdb_team_size = 0;		// agents per team, instance = team * rtdb_team_size + agent
+static int n_recording = 0;			// instances with the flight recorder on
+static int urgent_fd = -1;			// socket to ask comm for urgent transmissions
 
 int __agent = -1;
 
@@ -125,18 +200,28 @@ void DB_set_config_file(const char* cf){
 //	read_configuration: CONFIG_FILE parser
 //
 //	output:
+//		RTDBconf_rec **conf = records of all agents (to be freed by the caller)
+//		int *n_recs = number of records
+//		int *n_items = highest record id + 1
 //		number of agents
 //		-1 = error
 //
-int read_configuration(RTDBconf_agents *conf)
+int read_configuration(RTDBconf_rec **conf, int *n_recs, int *n_items)
 {
 	FILE *f_def;
 	int rc;
 	char s[100];
-	int n_agents = -1;
-	int agent;
-	int id, size, period;
-	char type;
+	int n_agents = 0;
+	int max_recs = 0;
+	int agent = -1;
+	int id, size, period, history, channel, cols;
+	unsigned int layout;
+	char type, *p_layout;
+	RTDBconf_rec *p_conf;
+
+	*conf = NULL;
+	*n_recs = 0;
+	*n_items = 0;
 
 	if ((f_def = fopen(rtdbConfigFile, "r")) == NULL)
 	{
@@ -156,40 +241,51 @@ int read_configuration(RTDBconf_agents *conf)
 		{
 			if (s[0] != '#')
 			{
-				sscanf(s, "%d\t%d\t%d\t%c\n", &id, &size, &period, &type);
-				if (type == 's')
-				{
-					conf[agent].shared[conf[agent].n_shared_recs].id = id;
-					conf[agent].shared[conf[agent].n_shared_recs].size = size;
-					conf[agent].shared[conf[agent].n_shared_recs].period = period;
-					conf[agent].n_shared_recs ++;
-				}
-				else
+				// the history and channel columns are optional
+				cols = sscanf(s, "%d\t%d\t%d\t%c\t%d\t%d\n", &id, &size, &period, &type, &history, &channel);
+				if (cols < 5)
+					history = 0;
+				if (cols < 6)
+					channel = 0;
+				// and so is the layout hash of the data type, after an @
+				layout = 0;
+				if ((p_layout = strchr(s, '@')) != NULL)
+					sscanf(p_layout + 1, "%x", &layout);
+				if ((agent < 0) || (id < 0) || (size < 0) || (history < 0) || (channel < 0))
 				{
-					conf[agent].local[conf[agent].n_local_recs].id = id;
-					conf[agent].local[conf[agent].n_local_recs].size = size;
-					conf[agent].local[conf[agent].n_local_recs].period = period;
-					conf[agent].n_local_recs ++;
+					PERR("Invalid record %d of agent %d", id, agent);
+					break;
 				}
-				if ((conf[agent].n_shared_recs + conf[agent].n_local_recs) > MAX_RECS)
+				if (*n_recs == max_recs)
 				{
-					PERR("Increase MAX_RECS");
-					return -1;
+					max_recs = (max_recs == 0) ? 64 : max_recs * 2;
+					if ((p_conf = (RTDBconf_rec*)realloc(*conf, max_recs * sizeof(RTDBconf_rec))) == NULL)
+					{
+						PERRNO("realloc");
+						break;
+					}
+					*conf = p_conf;
 				}
+				p_conf = *conf + *n_recs;
+				p_conf->agent = agent;
+				p_conf->local = (type != 's');
+				p_conf->var.id = id;
+				p_conf->var.size = size;
+				p_conf->var.period = period;
+				p_conf->var.history = history;
+				p_conf->var.channel = channel;
+				p_conf->var.layout = layout;
+				(*n_recs) ++;
+				if (id >= *n_items)
+					*n_items = id + 1;
 			}
 			else
 			{
 				if (s[1] != '#')
 				{
 					sscanf(s+1, "%d\n", &agent);
-					if (agent >= MAX_AGENTS)
-					{
-						PERR("Increase MAX_AGENTS");
-						return -1;
-					}
-					n_agents ++;
-					conf[n_agents].n_shared_recs = 0;
-					conf[n_agents].n_local_recs = 0;
+					if (agent >= n_agents)
+						n_agents = agent + 1;
 				}
 			}
 		}
@@ -197,68 +293,257 @@ int read_configuration(RTDBconf_agents *conf)
 	} while (rc != -1);
 
 	fclose(f_def);
-	n_agents ++;
+
+	if (rc != -1)
+	{
+		free(*conf);
+		*conf = NULL;
+		return -1;
+	}
 
 #ifdef DEBUG
 
-	int i, j;
+	int i;
+
+	for (i = 0; i < *n_recs; i++)
+		PDEBUG("Agent: %d, %s: id: %d, size: %d, period: %d, history: %d, channel: %d, layout: %08x", (*conf)[i].agent, (*conf)[i].local ? "local" : "shared", (*conf)[i].var.id, (*conf)[i].var.size, (*conf)[i].var.period, (*conf)[i].var.history, (*conf)[i].var.channel, (*conf)[i].var.layout);
+#endif
+
+	return (n_agents);
+}
+
+
+
+//	*************************
+//	get_instance: segment of an RTDB instance attached by this process
+//
+//	input:
+//		int _agent = agent memory
+//	output:
+//		pointer to the segment
+//		NULL = not attached
+//
+static inline RTDBdef *get_instance (int _agent)
+{
+	if ((_agent < 0) || (_agent >= n_rtdb_inst))
+		return NULL;
+	return rtdb_inst[_agent].p_def;
+}
+
+
+
+//	*************************
+//	DB_lock: lock on the first byte of a segment
+//		every process using the segment holds a read lock, so the kernel
+//		tells when the last one is gone (even if it crashed)
+//
+//	input:
+//		int _fd = descritor do segmento
+//		short _type = F_RDLCK, F_WRLCK or F_UNLCK
+//		int _wait = 1 to block until the lock is granted
+//	output:
+//		0 = OK
+//		-1 = error (or lock busy)
+//
+static int DB_lock (int _fd, short _type, int _wait)
+{
+	struct flock fl;
+
+	memset(&fl, 0, sizeof(fl));
+	fl.l_type = _type;
+	fl.l_whence = SEEK_SET;
+	fl.l_start = 0;
+	fl.l_len = 1;
+
+	return fcntl(_fd, _wait ? F_SETLKW : F_SETLK, &fl);
+}
+
+
+
+//	*************************
+//	DB_map: maps a segment
+//
+//	input:
+//		int _fd = descritor do segmento
+//		int _size = tamanho do segmento
+//	output:
+//		pointer to the segment
+//		NULL = error
+//
+static RTDBdef *DB_map (int _fd, int _size)
+{
+	void *p_mem;
 
-	for (i = 0; i < n_agents; i++)
+	p_mem = mmap(NULL, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+	if (p_mem == MAP_FAILED)
 	{
-		PDEBUG("Agent : %d", i);
-		for (j = 0; j < conf[i].n_shared_recs; j++)
-			PDEBUG("  Shared: id: %d, size: %d, period: %d", conf[i].shared[j].id, conf[i].shared[j].size, conf[i].shared[j].period);
+		PERRNO("mmap");
+		return NULL;
 	}
+
+#ifdef MADV_HUGEPAGE
+	// only honoured if /sys/kernel/mm/transparent_hugepage/shmem_enabled allows it
+	if (getenv("RTDB_HUGEPAGES") != NULL)
+		if (madvise(p_mem, _size, MADV_HUGEPAGE) == -1)
+			PERRNO("madvise");
 #endif
 
-	return (n_agents);
+	return (RTDBdef*)p_mem;
+}
+
+
+
+//	*************************
+//	record_prefault: prefault thread of a flight recorder mapping
+//		maps, in this process, the pages RECORD_PREFAULT_STEPS index steps
+//		ahead of the tail; woken by the writers that cross a step, so the
+//		page faults are taken here and not by them
+//
+//	input:
+//		void *_arg = RTDBprefault
+//
+static void *record_prefault (void *_arg)
+{
+	RTDBprefault *p_pf = (RTDBprefault*)_arg;
+	RTDBrec_header *p_hdr = p_pf->p_hdr;
+	unsigned long long page = getpagesize();
+	unsigned long long end = p_hdr->size - p_hdr->data;
+	unsigned long long ahead = 0, tail, from, to;
+	unsigned int step;
+	char *p;
+
+	for (;;)
+	{
+		step = SEQ_LOAD(&p_hdr->step);
+		if (__atomic_load_n(&p_pf->stop, __ATOMIC_ACQUIRE))
+			break;
+
+		// from the page after the tail one (being written) on, what is not mapped yet
+		tail = SEQ_LOAD(&p_hdr->tail);
+		from = (tail + page - 1) & ~(page - 1);
+		if (from < ahead)
+			from = ahead;
+		to = (tail / RECORD_INDEX_STEP + 1 + RECORD_PREFAULT_STEPS) * RECORD_INDEX_STEP;
+		if (to > end)
+			to = end;
+
+		if (from < to)
+		{
+			p = (char*)p_hdr + p_hdr->data + from;
+#ifdef MADV_POPULATE_WRITE
+			if (madvise(p, to - from, MADV_POPULATE_WRITE) == -1)
+#endif
+				// touched with an atomic add of 0, writers may get there meanwhile
+				for (; p < (char*)p_hdr + p_hdr->data + to; p += page)
+					__atomic_fetch_add((unsigned int*)p, 0, __ATOMIC_RELAXED);
+			ahead = to;
+		}
+
+		syscall(SYS_futex, &p_hdr->step, FUTEX_WAIT, step, NULL, NULL, 0);
+	}
+
+	return NULL;
+}
+
+
+
+//	*************************
+//	record_prefault_start: starts the prefault thread of a flight recorder
+//		mapping, SCHED_OTHER whatever the policy of this process
+//
+//	input:
+//		RTDBrec_header *_p_hdr = the mapping
+//	output:
+//		the thread
+//		NULL = error (the writers take the page faults)
+//
+static RTDBprefault *record_prefault_start (RTDBrec_header *_p_hdr)
+{
+	RTDBprefault *p_pf;
+	pthread_attr_t attr;
+	struct sched_param param;
+
+	if ((p_pf = (RTDBprefault*)calloc(1, sizeof(RTDBprefault))) == NULL)
+	{
+		PERRNO("calloc");
+		return NULL;
+	}
+	p_pf->p_hdr = _p_hdr;
+
+	memset(&param, 0, sizeof(param));
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+	pthread_attr_setschedparam(&attr, &param);
+	if ((errno = pthread_create(&p_pf->thread, &attr, record_prefault, p_pf)) != 0)
+	{
+		PERRNO("pthread_create");
+		free(p_pf);
+		p_pf = NULL;
+	}
+	pthread_attr_destroy(&attr);
+
+	return p_pf;
+}
+
+
+
+//	*************************
+//	record_prefault_stop: stops the prefault thread of a flight recorder mapping
+//
+//	input:
+//		RTDBprefault *_p_pf = the thread (NULL = none)
+//
+static void record_prefault_stop (RTDBprefault *_p_pf)
+{
+	if (_p_pf == NULL)
+		return;
+
+	// the step changes, so it does not block again if it was about to
+	__atomic_store_n(&_p_pf->stop, 1, __ATOMIC_RELEASE);
+	__atomic_fetch_add(&_p_pf->p_hdr->step, 1, __ATOMIC_RELEASE);
+	syscall(SYS_futex, &_p_pf->p_hdr->step, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+	pthread_join(_p_pf->thread, NULL);
+	free(_p_pf);
 }
 
 
 
 //	*************************
 //	_DB_free: free RTDB
+//		the segment is removed by the last process of the agent
 //
 //	input:
 //		int _agent = agent memory
 //
 void _DB_free (int _agent)
 {
-	int i;
-	struct shmid_ds shmem_status;
+	char name[64];
+	RTDBdef *p_def;
+
+	if ((p_def = get_instance(_agent)) == NULL)
+		return;
 
-	printf ("RTDB free in agent %d\n", _agent);
+	printf ("RTDB free in agent %d of team %d\n", p_def->self_agent, p_def->team);
 
-	// shared memory
-	for (i = 0; i < p_def[_agent]->n_agents; i++)
+	snprintf(name, sizeof(name), "%s.%d.%d", SHMEM_NAME, p_def->team, p_def->self_agent);
+
+	munmap(p_def, rtdb_inst[_agent].size);
+	rtdb_inst[_agent].p_def = NULL;
+
+	if (rtdb_inst[_agent].p_record != NULL)
 	{
-		shmdt(p_shared_mem[_agent][i]);
-		
-		// if it is the last
-		if (shmctl(shared_shmid[_agent][i], IPC_STAT, &shmem_status) == -1)
-			PERRNO("shmctl");
-		//printf ("-- shared %d ---- %d ---\n", i, (int)shmem_status.shm_nattch);
-		if (shmem_status.shm_nattch == 0)
-			shmctl(shared_shmid[_agent][i], IPC_RMID, NULL);
+		record_prefault_stop(rtdb_inst[_agent].prefault);
+		rtdb_inst[_agent].prefault = NULL;
+		munmap(rtdb_inst[_agent].p_record, rtdb_inst[_agent].p_record->size);
+		rtdb_inst[_agent].p_record = NULL;
+		n_recording --;
 	}
 
-	// local memory
-	shmdt(p_local_mem[_agent]);
-	// if it is the last
-	if (shmctl(local_shmid[_agent], IPC_STAT, &shmem_status) == -1)
-		PERRNO("shmctl");
-	//printf ("-- local ---- %d ---\n", (int)shmem_status.shm_nattch);
-	if (shmem_status.shm_nattch == 0)
-		shmctl(local_shmid[_agent], IPC_RMID, NULL);
-
-	// def memory
-	shmdt(p_def[_agent]);
-	// se e o ultimo
-	if (shmctl(def_shmid[_agent], IPC_STAT, &shmem_status) == -1)
-		PERRNO("shmctl");
-	//printf ("-- def ---- %d ---\n", (int)shmem_status.shm_nattch);
-	if (shmem_status.shm_nattch == 0)
-		shmctl(def_shmid[_agent], IPC_RMID, NULL);
+	// if it is the last (the read lock is kept if it is not)
+	if (DB_lock(rtdb_inst[_agent].fd, F_WRLCK, 0) == 0)
+		shm_unlink(name);
+	close(rtdb_inst[_agent].fd);
 }
 
 
@@ -267,195 +552,489 @@ void DB_free (void)
 {
 	if (__agent != -1)
 		_DB_free (__agent);
+	__agent = -1;
 }
 
 
 
-void DB_free_all (int _second_rtdb)
+void DB_free_all (int _team)
 {
 	int i;
-  int offset;
-  
-  if ( _second_rtdb == 1)
-    offset = MAX_AGENTS;
-  else
-    offset = 0;
-  
-	for (i=0; i<MAX_AGENTS; i++)
-		_DB_free ( i + offset );
+	RTDBdef *p_def;
+
+	for (i = 0; i < n_rtdb_inst; i++)
+		if (((p_def = get_instance(i)) != NULL) && (p_def->team == _team))
+			_DB_free (i);
 }
 
 
 
 //	*************************
-//	DB_initialization: RTDB init
+//	DB_format: (re)initialization of the segment of an RTDB instance
+//		only the self agent local records are kept, shared records of all agents
 //
 //	input:
-//		int _agent = agent memory
+//		int _fd = descritor do segmento
+//		int _team = equipa do agente
+//		int _agent = numero do agente
 //	output:
-//		0 = OK
-//		-1 = error
+//		pointer to the segment
+//		NULL = error
 //
-int DB_initialization (int _agent, int _second_rtdb)
+static RTDBdef *DB_format (int _fd, int _team, int _agent)
 {
-	if(_second_rtdb == 1337) {
-		PDEBUG("dummy debug");
+	RTDBconf_rec *conf;
+	int n_recs, n_items, n_agents;
+	int i, b, n;
+	int size, offset;
+	RTDBdef *p_def;
+	TRec *p_rec;
+
+	if ((n_agents = read_configuration(&conf, &n_recs, &n_items)) < 1)
+	{
+		PERR("read_configuration");
+		free(conf);
+		return NULL;
 	}
 
-	int i, j;
-	int key;
-	int offset;
-	TRec *p_rec;
-	struct shmid_ds shmem_status;
-	RTDBconf_agents rtdb_conf[MAX_AGENTS];
+	if (_agent >= n_agents)
+	{
+		PERR("Agent %d not in %s", _agent, rtdbConfigFile);
+		free(conf);
+		return NULL;
+	}
 
-	// malloc
-  key = SHMEM_KEY + (_agent * MAX_AGENTS * 4);
-  
-	def_shmid[_agent] = shmget(key, sizeof(RTDBdef), 0644 | IPC_CREAT);
-	if (def_shmid[_agent] == -1)
+	// sizeof memory to alloc
+	n = 0;
+	size = 0;
+	for (i = 0; i < n_recs; i++)
 	{
-		PERRNO("shmget1");
-		return -1;
+		if (conf[i].local && (conf[i].agent != _agent))
+			continue;
+		size += (conf[i].var.history + 2) * BANK_STRIDE(conf[i].var.size);
+		n ++;
 	}
-	key++;
-	p_def[_agent] = (RTDBdef*)shmat(def_shmid[_agent], (void *)0, 0);
-	if ((char *)p_def[_agent] == (char *)(-1))
+	size += DIR_SIZE(n_agents, n_items) + MEM_ALIGN(n * sizeof(TRec));
+	if (getenv("RTDB_HUGEPAGES") != NULL)
+		size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+	// whatever was left by previous users is dropped
+	if ((ftruncate(_fd, 0) == -1) || (ftruncate(_fd, size) == -1))
 	{
-		PERRNO("shmat");
-		_DB_free(_agent);
-		return -1;
+		PERRNO("ftruncate");
+		free(conf);
+		return NULL;
 	}
 
-	// if it is the first
-	if (shmctl(def_shmid[_agent], IPC_STAT, &shmem_status) == -1)
+	if ((p_def = DB_map(_fd, size)) == NULL)
 	{
-		PERRNO("shmctl");
-		_DB_free(_agent);
-		return -1;
+		free(conf);
+		return NULL;
 	}
-	if (shmem_status.shm_nattch == 1)
+
+	p_def->self_agent = _agent;
+	p_def->team = _team;
+	p_def->n_agents = n_agents;
+	p_def->n_items = n_items;
+	p_def->n_recs = n;
+	p_def->size = size;
+
+	for (i = 0; i < n_agents * n_items; i++)
+		DIR(p_def)[i] = -1;
+
+	p_rec = (TRec*)((char*)p_def + DIR_SIZE(n_agents, n_items));
+	offset = MEM_ALIGN(n * sizeof(TRec));
+	for (i = 0; i < n_recs; i++)
 	{
-		// load defines
-		if ((p_def[_agent]->n_agents = read_configuration(rtdb_conf)) < 1)
+		if (conf[i].local && (conf[i].agent != _agent))
+			continue;
+
+		if (DIR(p_def)[conf[i].agent * n_items + conf[i].var.id] != -1)
 		{
-			PERR("read_configuration");
-			_DB_free(_agent);
-			return -1;
+			PERR("Record %d of agent %d declared twice", conf[i].var.id, conf[i].agent);
+			continue;
 		}
 
-		p_def[_agent]->self_agent = _agent;
-	
-		for (i = 0; i < p_def[_agent]->n_agents; i++)
+		p_rec->id = conf[i].var.id;
+		p_rec->agent = conf[i].agent;
+		p_rec->size = conf[i].var.size;
+		p_rec->offset = offset;
+		p_rec->period = conf[i].var.period;
+		p_rec->local = conf[i].local;
+		p_rec->channel = conf[i].var.channel;
+		p_rec->layout = conf[i].var.layout;
+		p_rec->read_bank = 0;
+		p_rec->n_banks = conf[i].var.history + 2;
+		p_rec->stride = BANK_STRIDE(p_rec->size);
+		p_rec->seq = 0;
+		p_rec->waiters = 0;
+		p_rec->base = (char*)p_rec - (char*)p_def;
+		for (b = 0; b < p_rec->n_banks; b++)
+			BANK(p_rec, b)->length = p_rec->size;
+		DIR(p_def)[conf[i].agent * n_items + p_rec->id] = p_rec->base;
+		offset = offset + (p_rec->n_banks * p_rec->stride) - sizeof(TRec);
+
+		PDEBUG("agent: %d, %s: %d, size: %d, offset:%d, period: %d, banks: %d", conf[i].agent, p_rec->local ? "local" : "shared", p_rec->id, p_rec->size, p_rec->offset, p_rec->period, p_rec->n_banks);
+		p_rec ++;
+	}
+
+	free(conf);
+
+	SEQ_STORE(&p_def->magic, RTDB_MAGIC);
+
+	return p_def;
+}
+
+
+
+//	*************************
+//	record_open: maps the flight recorder file of an agent
+//		only if RTDB_RECORD is set; the first process creates the file with
+//		RTDB_RECORD_SIZE MB (sparse), an existing file of this boot is
+//		appended to, one of another boot is renamed with its start time
+//
+//	input:
+//		int _team = equipa do agente
+//		int _agent = numero do agente
+//	output:
+//		pointer to the file header
+//		NULL = not recording (or error)
+//
+static RTDBrec_header *record_open (int _team, int _agent)
+{
+	char name[PATH_MAX], old[PATH_MAX];
+	char *dir, *environment;
+	char boot_id[sizeof(((RTDBrec_header*)0)->boot_id)];
+	unsigned long long size = RECORD_SIZE_MB;
+	unsigned long long now;
+	struct stat st, st_name;
+	struct timespec mono, real;
+	RTDBrec_header *p_hdr, hdr;
+	FILE *f;
+	int fd;
+
+	if ((dir = getenv("RTDB_RECORD")) == NULL)
+		return NULL;
+	snprintf(name, sizeof(name), "%s/rtdb.%d.%d.rec", dir, _team, _agent);
+
+	if (((environment = getenv("RTDB_RECORD_SIZE")) != NULL) && (atoi(environment) > 0))
+		size = atoi(environment);
+	size *= 1024 * 1024;
+
+	// this boot (without it, a monotonic clock behind the file start tells a reboot)
+	memset(boot_id, 0, sizeof(boot_id));
+	if ((f = fopen(RECORD_BOOT_ID, "r")) != NULL)
+	{
+		if (fgets(boot_id, sizeof(boot_id), f) == NULL)
+			boot_id[0] = '\0';
+		boot_id[strcspn(boot_id, "\n")] = '\0';
+		fclose(f);
+	}
+
+	for (;;)
+	{
+		if ((fd = open(name, O_RDWR | O_CREAT, 0644)) == -1)
+		{
+			PERRNO("open");
+			return NULL;
+		}
+
+		// only held while the header is checked (or written)
+		if ((DB_lock(fd, F_WRLCK, 1) == -1) || (fstat(fd, &st) == -1))
+		{
+			PERRNO("fcntl");
+			close(fd);
+			return NULL;
+		}
+
+		// renamed by another process while waiting for the lock: the new one
+		if ((stat(name, &st_name) == -1) || (st_name.st_dev != st.st_dev) || (st_name.st_ino != st.st_ino))
 		{
+			close(fd);
+			continue;
+		}
 
-			if (i == p_def[_agent]->self_agent)
+		// a recording of another boot (or version), its times do not follow: put aside
+		clock_gettime(CLOCK_MONOTONIC, &mono);
+		now = mono.tv_sec * 1000000000ULL + mono.tv_nsec;
+		if (((size_t)st.st_size >= sizeof(hdr)) && (pread(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr)) &&
+			(hdr.magic == RECORD_MAGIC) && ((hdr.version != RECORD_VERSION) ||
+			(strncmp(hdr.boot_id, boot_id, sizeof(boot_id)) != 0) || (hdr.mono0 > now)))
+		{
+			snprintf(old, sizeof(old), "%s/rtdb.%d.%d.%llu.rec", dir, _team, _agent, hdr.real0 / 1000000000ULL);
+			if (rename(name, old) == -1)
 			{
-				p_def[_agent]->n_local_recs = rtdb_conf[i].n_local_recs;
-				for (j = 0; j < p_def[_agent]->n_local_recs; j++)
-					p_def[_agent]->local_mem_size += rtdb_conf[i].local[j].size;
-				p_def[_agent]->local_mem_size = p_def[_agent]->local_mem_size * 2 + sizeof (TRec) * p_def[_agent]->n_local_recs;
+				PERRNO("rename");
+				close(fd);
+				return NULL;
 			}
-			p_def[_agent]->n_shared_recs[i] = rtdb_conf[i].n_shared_recs;
-			for (j = 0; j < p_def[_agent]->n_shared_recs[i]; j++)
-				p_def[_agent]->shared_mem_size[i] += rtdb_conf[i].shared[j].size;
-
-			// sizeof memory to alloc
-			p_def[_agent]->shared_mem_size[i] = p_def[_agent]->shared_mem_size[i] * 2 + sizeof (TRec) * p_def[_agent]->n_shared_recs[i];
+			printf("RTDB recording of a previous boot moved to %s\n", old);
+			close(fd);
+			continue;
 		}
+
+		break;
+	}
+
+	if ((st.st_size == 0) && (ftruncate(fd, size) == -1))
+	{
+		PERRNO("ftruncate");
+		close(fd);
+		return NULL;
+	}
+	if (st.st_size != 0)
+		size = st.st_size;
+
+	p_hdr = (RTDBrec_header*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (p_hdr == MAP_FAILED)
+	{
+		PERRNO("mmap");
+		close(fd);
+		return NULL;
+	}
+
+	if (st.st_size == 0)
+	{
+		p_hdr->version = RECORD_VERSION;
+		p_hdr->team = _team;
+		p_hdr->agent = _agent;
+		p_hdr->size = size;
+		p_hdr->n_index = size / RECORD_INDEX_STEP;
+		p_hdr->data = (sizeof(RTDBrec_header) + p_hdr->n_index * sizeof(RTDBrec_index) + getpagesize() - 1) & ~(getpagesize() - 1);
+		p_hdr->tail = 0;
+		p_hdr->dropped = 0;
+		clock_gettime(CLOCK_MONOTONIC, &mono);
+		clock_gettime(CLOCK_REALTIME, &real);
+		p_hdr->mono0 = mono.tv_sec * 1000000000ULL + mono.tv_nsec;
+		p_hdr->real0 = real.tv_sec * 1000000000ULL + real.tv_nsec;
+		p_hdr->step = 0;
+		memcpy(p_hdr->boot_id, boot_id, sizeof(boot_id));
+		SEQ_STORE(&p_hdr->magic, RECORD_MAGIC);
+	}
+
+	DB_lock(fd, F_UNLCK, 0);
+	close(fd);
+
+	if ((p_hdr->magic != RECORD_MAGIC) || (p_hdr->version != RECORD_VERSION)
+		|| (p_hdr->team != _team) || (p_hdr->agent != _agent) || (p_hdr->size != size))
+	{
+		PERR("%s is not a recording of agent %d", name, _agent);
+		munmap(p_hdr, size);
+		return NULL;
+	}
+
+	printf("RTDB recording agent %d of team %d in %s\n", _agent, _team, name);
+
+	return p_hdr;
+}
+
+
+
+//	*************************
+//	record_write: appends a write to the flight recorder
+//		called by the writer right after publishing the bank, which only
+//		this writer can reuse, so the data is copied from the segment.
+//		Costs one clock read, one atomic add and the copy of the data
+//		(and a futex wake of the prefault threads once every index step).
+//
+//	input:
+//		TRec *p_rec = record header
+//		RTDBref *_ref = reference of the write just published
+//		int _len = bytes published
+//
+static void record_write (TRec *p_rec, RTDBref *_ref, int _len)
+{
+	RTDBdef *p_def = (RTDBdef*)((char*)p_rec - p_rec->base);
+	RTDBrec_header *p_hdr;
+	RTDBrec_entry *p_entry;
+	RTDBrec_index *p_index;
+	struct timespec ts;
+	unsigned long long time, length, off, k;
+	int instance = p_def->team * rtdb_team_size + p_def->self_agent;
+	int crossed;
+
+	// the instance whose segment holds the record, straight from its header
+	if ((instance < 0) || (instance >= n_rtdb_inst) || (rtdb_inst[instance].p_def != p_def)
+		|| ((p_hdr = rtdb_inst[instance].p_record) == NULL))
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	time = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	length = RECORD_ALIGN(sizeof(RTDBrec_entry) + _len);
+
+	off = __atomic_fetch_add(&p_hdr->tail, length, __ATOMIC_RELAXED);
+	if (off + length > p_hdr->size - p_hdr->data)
+	{
+		// full: the recording ends here, nothing is ever overwritten
+		__atomic_fetch_add(&p_hdr->dropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	p_entry = RECORD_ENTRY(p_hdr, off);
+	p_entry->length = length;
+	p_entry->agent = p_rec->agent;
+	p_entry->id = p_rec->id;
+	p_entry->seq = _ref->seq + 2;
+	p_entry->life = _ref->life;
+	p_entry->len = _len;
+	p_entry->time = time;
+	memcpy(p_entry + 1, BANK_DATA(p_rec, _ref->bank), _len);
+
+	// index slots of the steps that fall inside this entry
+	p_index = RECORD_INDEX(p_hdr);
+	crossed = 0;
+	for (k = (off + RECORD_INDEX_STEP - 1) / RECORD_INDEX_STEP; (k * RECORD_INDEX_STEP < off + length) && (k < (unsigned long long)p_hdr->n_index); k++)
+	{
+		p_index[k].offset = off;
+		SEQ_STORE(&p_index[k].time, time);
+		crossed = 1;
+	}
+
+	SEQ_STORE(&p_entry->ready, RECORD_READY);
+
+	// a step crossed, the prefault threads map the next ones
+	if (crossed)
+	{
+		__atomic_fetch_add(&p_hdr->step, 1, __ATOMIC_RELEASE);
+		syscall(SYS_futex, &p_hdr->step, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+	}
+}
+
+
+
+//	*************************
+//	DB_initialization: RTDB init
+//		every process of an agent holds a read lock on its segment; the one
+//		that finds no other holder (the first one, or the first after a crash)
+//		rebuilds it from the configuration file, the other ones wait for it
+//		and just map it
+//
+//	input:
+//		int _team = equipa do agente
+//		int _agent = numero do agente
+//	output:
+//		agent memory (instance number, to be used in rtdb_sim.h calls)
+//		-1 = error
+//
+int DB_initialization (int _team, int _agent)
+{
+	char name[64];
+	int fd;
+	int i, instance;
+	int first;
+	int size = 0;
+	struct stat st;
+	RTDBdef *p_def;
+	RTDBinst *p_inst;
+
+	if ((_team < 0) || (_agent < 0))
+	{
+		PERR("Invalid agent %d of team %d", _agent, _team);
+		return -1;
+	}
+
+	if ((rtdb_team_size != 0) && (get_instance(_team * rtdb_team_size + _agent) != NULL))
+	{
+		PDEBUG("Memory already attached");
+		return _team * rtdb_team_size + _agent;
 	}
 
-	// alloc of shared memory
-	for (i = 0; i < p_def[_agent]->n_agents; i++)
+	snprintf(name, sizeof(name), "%s.%d.%d", SHMEM_NAME, _team, _agent);
+
+	for (;;)
 	{
-		shared_shmid[_agent][i] = shmget(key, p_def[_agent]->shared_mem_size[i], 0644 | IPC_CREAT);
-		if (shared_shmid[_agent][i] == -1)
+		if ((fd = shm_open(name, O_RDWR | O_CREAT, 0644)) == -1)
 		{
-			PERRNO("shmget2");
-			_DB_free(_agent);
+			PERRNO("shm_open");
 			return -1;
 		}
-		key ++;
-		p_shared_mem[_agent][i] = shmat(shared_shmid[_agent][i], (void *)0, 0);
-		if (p_shared_mem[_agent][i] == (char *)(-1))
+
+		// the write lock is only granted if nobody else is using it,
+		// otherwise wait until whoever is formatting it is done
+		first = 1;
+		if (DB_lock(fd, F_WRLCK, 0) == -1)
+		{
+			first = 0;
+			if (DB_lock(fd, F_RDLCK, 1) == -1)
+			{
+				PERRNO("fcntl");
+				close(fd);
+				return -1;
+			}
+		}
+
+		if (fstat(fd, &st) == -1)
 		{
-			PERRNO("shmat");
-			_DB_free(_agent);
+			PERRNO("fstat");
+			close(fd);
 			return -1;
 		}
+
+		// the last user may have removed it in the meantime
+		if (st.st_nlink > 0)
+			break;
+		close(fd);
 	}
-	
-	// alloc of local memory
-	if (p_def[_agent]->local_mem_size == 0)
-		local_shmid[_agent] = shmget(key, 1, 0644 | IPC_CREAT);
-	else
-		local_shmid[_agent] = shmget(key, p_def[_agent]->local_mem_size, 0644 | IPC_CREAT);
-	if (local_shmid[_agent] == -1)
+
+	if (first)
 	{
-		PERRNO("shmget3");
-		_DB_free(_agent);
-		return -1;
+		if ((p_def = DB_format(fd, _team, _agent)) != NULL)
+			size = p_def->size;
+		DB_lock(fd, F_RDLCK, 0);
 	}
-	p_local_mem[_agent] = shmat(local_shmid[_agent], (void *)0, 0);
-	if (p_local_mem[_agent] == (char *)(-1))
+	else
+		p_def = DB_map(fd, size = st.st_size);
+
+	if (p_def == NULL)
 	{
-		PERRNO("shmat");
-		_DB_free(_agent);
+		PERR("Unable to attach %s", name);
+		close(fd);
 		return -1;
 	}
 
-	// if it is the first, memory initialization
-	if (shmctl(local_shmid[_agent], IPC_STAT, &shmem_status) == -1)
+	if ((p_def->magic != RTDB_MAGIC) || (p_def->self_agent != _agent) || (p_def->team != _team))
 	{
-		PERRNO("shmctl");
-		_DB_free(_agent);
+		PERR("%s is not an RTDB of agent %d", name, _agent);
+		munmap(p_def, size);
+		close(fd);
 		return -1;
 	}
-	if (shmem_status.shm_nattch > 1)
-	{
-		PDEBUG("Memory already configurated");
-		return 0;
-	}
 
-	for (i = 0; i < MAX_AGENTS; i++)
-		for (j = 0; j < MAX_RECS; j++)
-			p_def[_agent]->rec_lut[i][j] = -1;
+	if (rtdb_team_size == 0)
+		rtdb_team_size = p_def->n_agents;
+	instance = _team * rtdb_team_size + _agent;
 
-	for (i = 0; i < p_def[_agent]->n_agents; i++)
+	if (instance >= n_rtdb_inst)
 	{
-		offset = p_def[_agent]->n_shared_recs[i] * sizeof(TRec);
-		for (j = 0; j < p_def[_agent]->n_shared_recs[i]; j++)
+		if ((p_inst = (RTDBinst*)realloc(rtdb_inst, (instance + 1) * sizeof(RTDBinst))) == NULL)
+		{
+			PERRNO("realloc");
+			munmap(p_def, size);
+			close(fd);
+			return -1;
+		}
+		for (i = n_rtdb_inst; i <= instance; i++)
 		{
-			p_rec = (TRec*)((char*)(p_shared_mem[_agent][i]) + j * sizeof(TRec));
-			p_rec->id = rtdb_conf[i].shared[j].id;
-			p_rec->size = rtdb_conf[i].shared[j].size;
-			p_rec->offset = offset;
-			p_rec->period = rtdb_conf[i].shared[j].period;
-			p_rec->read_bank = 0;
-			p_def[_agent]->rec_lut[i][p_rec->id] = j;
-			offset = offset + (p_rec->size * 2) - sizeof(TRec);
-
-			PDEBUG("agent: %d, shared: %d, size: %d, offset:%d, period: %d, lut: %d", i, p_rec->id, p_rec->size, p_rec->offset, p_rec->period, j);
+			p_inst[i].p_def = NULL;
+			p_inst[i].p_record = NULL;
+			p_inst[i].prefault = NULL;
 		}
+		rtdb_inst = p_inst;
+		n_rtdb_inst = instance + 1;
 	}
-	
-	offset = p_def[_agent]->n_local_recs * sizeof(TRec);
-	for (j = 0; j < p_def[_agent]->n_local_recs; j++)
+
+	rtdb_inst[instance].fd = fd;
+	rtdb_inst[instance].size = size;
+	rtdb_inst[instance].p_def = p_def;
+	if ((rtdb_inst[instance].p_record = record_open(_team, _agent)) != NULL)
 	{
-		p_rec = (TRec*)((char*)(p_local_mem[_agent]) + j * sizeof(TRec));
-		p_rec->id = rtdb_conf[p_def[_agent]->self_agent].local[j].id;
-		p_rec->size = rtdb_conf[p_def[_agent]->self_agent].local[j].size;
-		p_rec->offset = offset;
-		p_rec->period = rtdb_conf[p_def[_agent]->self_agent].local[j].period;
-		p_rec->read_bank = 0;
-		p_def[_agent]->rec_lut[p_def[_agent]->self_agent][p_rec->id] = MAX_RECS + j;
-		offset = offset + (p_rec->size * 2) - sizeof(TRec);
-		
-		PDEBUG("local: %d, size: %d, offset:%d, period: %d, lut: %d", p_rec->id, p_rec->size, p_rec->offset, p_rec->period, MAX_RECS + j);
-		PDEBUG("lut = %d",p_def[_agent]->rec_lut[p_def[_agent]->self_agent][p_rec->id]);
+		rtdb_inst[instance].prefault = record_prefault_start(rtdb_inst[instance].p_record);
+		n_recording ++;
 	}
 
-	return 0;
+	PDEBUG("agent: %d, team: %d, instance: %d, size: %d", _agent, _team, instance, p_def->size);
+
+	return instance;
 }
 
 
@@ -470,7 +1049,8 @@ int DB_init (void)
 {
 	char *environment;
 	int agent;
-  int second_rtdb = 0;
+	int team = 0;
+	int instance;
 
 	// retrieve agent number
 	if((environment = getenv("AGENT")) == NULL)
@@ -479,269 +1059,1394 @@ int DB_init (void)
 		return -1;
 	}
 	agent = atoi(environment);
-
-	__agent = agent; 
 	PDEBUG("agent = %d", agent);
- 
-	if((environment = getenv("SECOND_RTDB")) == NULL)
-	{
-		second_rtdb = 0;
-  }
-  else
-  {
-  	second_rtdb = atoi(environment);
-    agent = MAX_AGENTS + agent;
-  }
 
+	// retrieve team number (SECOND_RTDB is still accepted for team 1)
+	if((environment = getenv("RTDB_TEAM")) != NULL)
+		team = atoi(environment);
+	else if(getenv("SECOND_RTDB") != NULL)
+		team = 1;
 
-	return (DB_initialization (agent, second_rtdb));
+	if ((instance = DB_initialization (team, agent)) == -1)
+		return -1;
+
+	__agent = instance;
+
+	return 0;
 }
 
 
 //	*************************
-//	DB_init_sim: RTDB init for all agent (use only in simulator)
+//	DB_init_all: RTDB init for all agent of a team (use only in simulator)
 //
 //	output:
 //		0 = OK
 //		-1 = error
 //
-int DB_init_all (int _second_rtdb)
+int DB_init_all (int _team)
 {
+	RTDBconf_rec *conf;
+	int n_recs, n_items, n_agents;
 	int i;
-  int agent;
 
-	for (i=0; i<MAX_AGENTS; i++){  
-    
-    if (_second_rtdb == 0 )
-      agent = i;
-    else
-      agent = MAX_AGENTS + i;
+	if ((n_agents = read_configuration(&conf, &n_recs, &n_items)) < 1)
+	{
+		PERR("read_configuration");
+		return -1;
+	}
+	free(conf);
 
-		if(DB_initialization(agent, _second_rtdb) == -1)
+	for (i=0; i<n_agents; i++)
+		if (DB_initialization(_team, i) == -1)
 			return (-1);
-  }
 
 	return (0);
 }
 
 
-
 //	*************************
-//	DB_put_in: write in RTDB
-//		note: it can write in any area (use with caution!)
+//	DB_instance: agent memory of an agent (use only in simulator)
 //
-//	imput:
-//		int _agent
-//		int _to_agent = agent number
-//		int _id = identificador da 'variavel'
-//		void *_value = ponteiro com os dados
-//		int life = tempo de vida da 'variavel' em ms
-//	Saida:
-//		int size = size of record data
-//		-1 = erro
+//	output:
+//		agent memory
+//		-1 = error
 //
-int DB_put_in (int _agent, int _to_agent, int _id, void *_value, int life)
+int DB_instance (int _team, int _agent)
 {
-	int lut;
-	TRec *p_rec;
-	void *p_data;
-	int write_bank;
-	struct timeval time;
+	int instance;
 
-	if ((lut = p_def[_agent]->rec_lut[_to_agent][_id]) == -1)
-	{
-		PERR("Unknown record %d for agent %d", _id, _to_agent);
+	if (rtdb_team_size == 0)
 		return -1;
-	}
 
-	if (lut < MAX_RECS)
-		p_rec = (TRec*)((char*)(p_shared_mem[_agent][_to_agent]) + lut * sizeof(TRec));
-	else
-		p_rec = (TRec*)((char*)(p_local_mem[_agent]) + (lut - MAX_RECS) * sizeof(TRec));
+	instance = _team * rtdb_team_size + _agent;
+	if (get_instance(instance) == NULL)
+		return -1;
 
-	write_bank = (p_rec->read_bank + 1) % 2;
+	return instance;
+}
 
-	p_data = (void*)((char*)(p_rec) + p_rec->offset + write_bank * p_rec->size);
-	memcpy(p_data, _value, p_rec->size);
 
-	gettimeofday(&time, NULL);
-	p_rec->timestamp[write_bank].tv_sec = time.tv_sec - life / 1000;
-	p_rec->timestamp[write_bank].tv_usec = time.tv_usec - (life % 1000) * 1000;
 
-	p_rec->read_bank = write_bank;
+//	*************************
+//	bank_intact: seqlock validation of a read
+//		a bank published _age writes before the current one is only reused by
+//		the write n_banks - _age after the current one (one less if a write
+//		was already running when the reader started)
+//
+//	input:
+//		TRec *p_rec = record header
+//		unsigned int _seq1 = record sequence before reading
+//		unsigned int _seq2 = record sequence after reading
+//		int _age = oldest bank read (0 = current bank)
+//	output:
+//		1 = the bank was not touched in between
+//		0 = the data must be read again
+//
+static inline int bank_intact (TRec *p_rec, unsigned int _seq1, unsigned int _seq2, int _age)
+{
+	int slack = 2 * (p_rec->n_banks - _age) - 2 - (int)(_seq1 & 1);
 
-	PDEBUG("agent: %d, id: %d, lut: %d, size: %d, write_bank: %d, previous life: %umsec", _to_agent, p_rec->id, lut, p_rec->size, p_rec->read_bank, life);
-	
-	return p_rec->size;
+	return (slack >= 0) && ((_seq2 - _seq1) <= (unsigned int)slack);
 }
 
 
 
-
 //	*************************
-//	DB_comm_put: Escreve na base de dados
-//		atencao: permite escrever em qualquer area!
+//	get_record: lookup of a record header
 //
-//	Entrada:
-//		int _to_agent = numero do agente
+//	input:
+//		int _agent = agent memory
+//		int _of_agent = agent number (or SELF)
 //		int _id = identificador da 'variavel'
-//		void *_value = ponteiro com os dados
-//		int _life = tempo de vida da 'variavel' em ms
-//	Saida:
-//		int size = size of record data
-//		-1 = erro
+//	output:
+//		pointer to the record header
+//		NULL = error
 //
-int DB_comm_put (int _to_agent, int _id, int _size, void *_value, int _life)
+static TRec *get_record (int _agent, int _of_agent, int _id)
 {
-	if(_size == 1337){
-		PDEBUG("Dummy debug");
+	RTDBdef *p_def;
+	int offset;
+
+	if ((p_def = get_instance(_agent)) == NULL)
+	{
+		PERR("RTDB not initialized");
+		return NULL;
 	}
 
-	if ((_to_agent == SELF) || (_to_agent == __agent))
+	if (_of_agent == SELF)
+		_of_agent = p_def->self_agent;
+
+	if ((_of_agent < 0) || (_of_agent >= p_def->n_agents) || (_id < 0) || (_id >= p_def->n_items)
+		|| ((offset = DIR(p_def)[_of_agent * p_def->n_items + _id]) == -1))
 	{
-		PERR("Impossible to write in the running agent!");
+		PERR("Unknown record %d for agent %d", _id, _of_agent);
+		return NULL;
+	}
+
+	return (TRec*)((char*)p_def + offset);
+}
+
+
+
+//	*************************
+//	read_record: seqlock protected copy of the current bank of a record
+//		only the bytes in use are copied, the rest of _value is left untouched
+//
+//	input:
+//		TRec *p_rec = record header
+//		void *_value = ponteiro para onde sao copiados os dados
+//		int *_len = bytes copied (may be NULL)
+//		struct timeval *_now = reference time for the life (NULL = current time)
+//	output:
+//		int life = tempo de vida da 'variavel' em ms
+//			-1 = error
+//
+static int read_record (TRec *p_rec, void *_value, int *_len, struct timeval *_now)
+{
+	TBank *p_bank;
+	int bank;
+	int len;
+	int retries;
+	unsigned int seq1, seq2;
+	struct timeval stamp;
+	struct timeval time;
+	int life;
+
+	for (retries = 0; retries < MAX_READ_RETRIES; retries++)
+	{
+		seq1 = SEQ_LOAD(&p_rec->seq);
+		bank = SEQ_LOAD(&p_rec->read_bank);
+		p_bank = BANK(p_rec, bank);
+
+		len = p_bank->length;
+		if ((len < 0) || (len > p_rec->size))
+			len = p_rec->size;
+		memcpy(_value, p_bank + 1, len);
+		stamp = p_bank->timestamp;
+
+		RMB();
+		seq2 = p_rec->seq;
+
+		if (bank_intact(p_rec, seq1, seq2, 0))
+			break;
+	}
+
+	if (retries == MAX_READ_RETRIES)
+	{
+		PDEBUG("id: %d, record kept changing while reading", p_rec->id);
 		return -1;
 	}
 
-	if (p_def[__agent]->rec_lut[_to_agent][_id] >= MAX_RECS)
+	if (_len != NULL)
+		*_len = len;
+
+	if (_now == NULL)
 	{
-		PERR("Impossible to write local records!");
+		gettimeofday(&time, NULL);
+		_now = &time;
+	}
+	life = (int)(((_now->tv_sec - stamp.tv_sec) * 1E3) + ((_now->tv_usec - stamp.tv_usec) / 1E3));
+	// written after a batch took its reference time
+	if (life < 0)
+		life = 0;
+
+	PDEBUG("id: %d, read_bank: %d, length: %d, seq: %u, life: %umsec", p_rec->id, bank, len, seq1, life);
+
+	return (life);
+}
+
+
+
+//	*************************
+//	read_history: seqlock protected copy of the past samples of a record
+//		samples are copied newest first, _values must hold _max records
+//
+//	input:
+//		TRec *p_rec = record header
+//		struct timeval *_from = oldest timestamp accepted (NULL = no limit)
+//		struct timeval *_to = newest timestamp accepted (NULL = no limit)
+//		void *_values = ponteiro para onde sao copiados os dados
+//		struct timeval *_stamps = timestamps of the samples copied (may be NULL)
+//		int _max = maximum number of samples to copy
+//	output:
+//		number of samples copied
+//		-1 = error
+//
+static int read_history (TRec *p_rec, struct timeval *_from, struct timeval *_to, void *_values, struct timeval *_stamps, int _max)
+{
+	TBank *p_bank;
+	int bank;
+	int age, n_avail, n;
+	int len;
+	int retries;
+	unsigned int seq1, seq2;
+	struct timeval stamp;
+
+	for (retries = 0; retries < MAX_READ_RETRIES; retries++)
+	{
+		seq1 = SEQ_LOAD(&p_rec->seq);
+		bank = SEQ_LOAD(&p_rec->read_bank);
+
+		// the oldest bank is the next one to be written
+		n_avail = p_rec->n_banks - 1;
+		if ((seq1 >> 1) < (unsigned int)n_avail)
+			n_avail = seq1 >> 1;
+
+		n = 0;
+		for (age = 0; (age < n_avail) && (n < _max); age++)
+		{
+			p_bank = BANK(p_rec, (bank - age + p_rec->n_banks) % p_rec->n_banks);
+			stamp = p_bank->timestamp;
+
+			if ((_to != NULL) && timercmp(&stamp, _to, >))
+				continue;
+			if ((_from != NULL) && timercmp(&stamp, _from, <))
+				continue;
+
+			len = p_bank->length;
+			if ((len < 0) || (len > p_rec->size))
+				len = p_rec->size;
+			memcpy((char *)_values + n * p_rec->size, p_bank + 1, len);
+			if (_stamps != NULL)
+				_stamps[n] = stamp;
+			n ++;
+		}
+
+		RMB();
+		seq2 = p_rec->seq;
+
+		if (bank_intact(p_rec, seq1, seq2, (age > 0) ? age - 1 : 0))
+			break;
+	}
+
+	if (retries == MAX_READ_RETRIES)
+	{
+		PDEBUG("id: %d, record kept changing while reading", p_rec->id);
 		return -1;
 	}
 
-	return DB_put_in(__agent, _to_agent, _id, _value, _life);
+	PDEBUG("id: %d, read_bank: %d, seq: %u, samples: %d", p_rec->id, bank, seq1, n);
+
+	return (n);
 }
 
 
 
 //	*************************
-//	DB_put: Escreve na base de dados do proprio agente
+//	DB_put_in: write in RTDB
+//		note: it can write in any area (use with caution!)
 //
-//	Entrada:
+//	imput:
+//		int _agent
+//		int _to_agent = agent number
 //		int _id = identificador da 'variavel'
 //		void *_value = ponteiro com os dados
+//		int life = tempo de vida da 'variavel' em ms
 //	Saida:
 //		int size = size of record data
-//		-1 = error
+//		-1 = erro
 //
-int DB_put (int _id, void *_value)
+int DB_put_in (int _agent, int _to_agent, int _id, void *_value, int life)
 {
-	if (__agent == -1)
-		return (-1);
-	return DB_put_in(__agent, __agent, _id, _value, 0);
+	RTDBref ref;
+	void *p_data;
+
+	if ((p_data = DB_put_begin_in(_agent, _to_agent, _id, life, &ref)) == NULL)
+		return -1;
+
+	memcpy(p_data, _value, ((TRec*)ref.p_rec)->size);
+
+	return DB_put_commit(&ref);
 }
 
 
 
 //	*************************
-//	DB_get_from: Le da base de dados
+//	DB_put_in_len: write the first _len bytes of a record in RTDB
+//		note: it can write in any area (use with caution!)
 //
-//	Entrada:
+//	imput:
 //		int _agent
-//		int _from_agent = numero do agente
+//		int _to_agent = agent number
 //		int _id = identificador da 'variavel'
-//		void *_value = ponteiro para onde sao copiados os dados
-//	Saida:
+//		void *_value = ponteiro com os dados
+//		int _len = number of bytes in use, up to the record size
 //		int life = tempo de vida da 'variavel' em ms
-//			-1 se erro
+//	Saida:
+//		int len = bytes written
+//		-1 = erro
 //
-int DB_get_from (int _agent, int _from_agent, int _id, void *_value)
+int DB_put_in_len (int _agent, int _to_agent, int _id, void *_value, int _len, int life)
 {
-	int lut;
+	RTDBref ref;
 	TRec *p_rec;
 	void *p_data;
-	struct timeval time;
-	int life;
 
-	if (_from_agent == SELF)
-		_from_agent = p_def[_agent]->self_agent;
+	if ((p_rec = get_record(_agent, _to_agent, _id)) == NULL)
+		return -1;
 
-	if((lut = p_def[_agent]->rec_lut[_from_agent][_id]) == -1)
+	// checked before the bank is reserved, readers see no new version
+	if ((_len < 0) || (_len > p_rec->size))
 	{
-		PERR("Unknown record %d for agent %d", _id, _from_agent);
+		PERR("Invalid length %d for record %d (size %d)", _len, _id, p_rec->size);
 		return -1;
 	}
 
-	if (lut < MAX_RECS)
-		p_rec = (TRec*)((char*)(p_shared_mem[_agent][_from_agent]) + lut * sizeof(TRec));
-	else
-		p_rec = (TRec*)((char*)(p_local_mem[_agent]) + (lut - MAX_RECS) * sizeof(TRec));
-	
-	p_data = (void *)((char *)(p_rec) + p_rec->offset);
+	if ((p_data = DB_put_begin_in(_agent, _to_agent, _id, life, &ref)) == NULL)
+		return -1;
 
-	memcpy(_value, (char *)p_data + (p_rec->read_bank * p_rec->size), p_rec->size);
+	memcpy(p_data, _value, _len);
 
-	gettimeofday(&time, NULL);
-	life = (int)(((time.tv_sec - (p_rec->timestamp[p_rec->read_bank]).tv_sec) * 1E3) + ((time.tv_usec - (p_rec->timestamp[p_rec->read_bank]).tv_usec) / 1E3));
+	return DB_put_commit_len(&ref, _len);
+}
 
-	PDEBUG("agent: %d, from_agent: %d, id: %d, read_bank: %d, life: %umsec", _agent, _from_agent, p_rec->id, p_rec->read_bank, life);
 
-	return (life);
+
+//	*************************
+//	DB_put_begin_in: reserve the next bank of a record for in-place writing
+//		note: it can write in any area (use with caution!)
+//		note: the bank holds old data, the whole record must be filled up
+//
+//	input:
+//		int _agent
+//		int _to_agent = agent number
+//		int _id = identificador da 'variavel'
+//		int life = tempo de vida da 'variavel' em ms
+//		RTDBref *_ref = reference to be given to DB_put_commit
+//	output:
+//		pointer to the bank where the data must be written
+//		NULL = error
+//
+void *DB_put_begin_in (int _agent, int _to_agent, int _id, int life, RTDBref *_ref)
+{
+	TRec *p_rec;
+
+	if ((p_rec = get_record(_agent, _to_agent, _id)) == NULL)
+		return NULL;
+
+	// only one writer per record: readers are never blocked, they retry instead
+	_ref->p_rec = p_rec;
+	_ref->seq = p_rec->seq;
+	_ref->bank = (p_rec->read_bank + 1) % p_rec->n_banks;
+	_ref->life = life;
+
+	SEQ_STORE(&p_rec->seq, _ref->seq + 1);
+	WMB();
+
+	return BANK_DATA(p_rec, _ref->bank);
 }
 
 
 
 //	*************************
-//	DB_get_from: Le da base de dados
+//	DB_put_begin: reserve the next bank of a record of the running agent
 //
-//	Entrada:
-//		int _from_agent = numero do agente
+//	input:
 //		int _id = identificador da 'variavel'
-//		void *_value = ponteiro para onde sao copiados os dados
-//	Saida:
-//		tempo de vida da 'variavel' em ms
-//			-1 = error
+//		RTDBref *_ref = reference to be given to DB_put_commit
+//	output:
+//		pointer to the bank where the data must be written
+//		NULL = error
 //
-int DB_get (int _from_agent, int _id, void *_value)
+void *DB_put_begin (int _id, RTDBref *_ref)
 {
 	if (__agent == -1)
-		return (-1);
-	return (DB_get_from (__agent, _from_agent, _id, _value));
+		return NULL;
+	return DB_put_begin_in(__agent, SELF, _id, 0, _ref);
 }
 
 
 
 //	*************************
-//	Whoami: identifica o agente onde esta a correr
+//	commit_bank: publish the first _len bytes of a reserved bank
 //
-//	Saida:
-//		int agent_number = numero do agente
+//	input:
+//		RTDBref *_ref = reference returned by DB_put_begin
+//		int _len = number of bytes in use, up to the record size
+//		struct timeval *_now = time of the write
+//	output:
+//		int len = bytes published
 //		-1 = error
 //
-int Whoami(void)
+static int commit_bank (RTDBref *_ref, int _len, struct timeval *_now)
+{
+	TRec *p_rec = (TRec*)_ref->p_rec;
+	TBank *p_bank;
+
+	if (p_rec == NULL)
+		return -1;
+
+	if ((_len < 0) || (_len > p_rec->size))
+		_len = p_rec->size;
+
+	p_bank = BANK(p_rec, _ref->bank);
+	p_bank->timestamp.tv_sec = _now->tv_sec - _ref->life / 1000;
+	p_bank->timestamp.tv_usec = _now->tv_usec - (_ref->life % 1000) * 1000;
+	if (p_bank->timestamp.tv_usec < 0)
+	{
+		p_bank->timestamp.tv_sec --;
+		p_bank->timestamp.tv_usec += 1000000;
+	}
+	p_bank->length = _len;
+
+	SEQ_STORE(&p_rec->read_bank, _ref->bank);
+	SEQ_STORE(&p_rec->seq, _ref->seq + 2);
+
+	// no syscall unless someone is blocked in DB_wait
+	MB();
+	if (p_rec->waiters != 0)
+		syscall(SYS_futex, &p_rec->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+
+	if (n_recording != 0)
+		record_write(p_rec, _ref, _len);
+
+	PDEBUG("id: %d, length: %d, write_bank: %d, seq: %u, previous life: %umsec", p_rec->id, _len, _ref->bank, _ref->seq + 2, _ref->life);
+
+	_ref->p_rec = NULL;
+
+	return _len;
+}
+
+
+
+//	*************************
+//	DB_put_commit_len: publish the first _len bytes of a bank reserved with DB_put_begin
+//
+//	input:
+//		RTDBref *_ref = reference returned by DB_put_begin
+//		int _len = number of bytes in use, up to the record size
+//	output:
+//		int len = bytes published
+//		-1 = error
+//
+int DB_put_commit_len (RTDBref *_ref, int _len)
 {
-	return (__agent);
+	struct timeval time;
+
+	gettimeofday(&time, NULL);
+	return commit_bank(_ref, _len, &time);
 }
 
 
 
 //	*************************
-//	DB_comm_ini: 
+//	DB_put_commit: publish a bank reserved with DB_put_begin
+//
+//	input:
+//		RTDBref *_ref = reference returned by DB_put_begin
+//	output:
+//		int size = size of record data
+//		-1 = error
+//
+int DB_put_commit (RTDBref *_ref)
+{
+	return DB_put_commit_len(_ref, -1);
+}
+
+
+
+
+//	*************************
+//	DB_comm_put: Escreve na base de dados
+//		atencao: permite escrever em qualquer area!
 //
 //	Entrada:
-//		int _id = array com identificadores da 'variavel'
-//		int _size = array com temanhos da 'variavel'
-//		int _period = array com periodos da 'variavel'
+//		int _to_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		void *_value = ponteiro com os dados
+//		int _life = tempo de vida da 'variavel' em ms
 //	Saida:
-//		int n_shared_recs = numero de 'variaveis' shared
+//		int size = size of record data
 //		-1 = erro
 //
-int DB_comm_ini(RTDBconf_var *rec)
+int DB_comm_put (int _to_agent, int _id, int _size, void *_value, int _life)
 {
-	int n_shared_recs;
-	int i;
 	TRec *p_rec;
 
-	if (__agent == -1)
-		return (-1);
-	n_shared_recs = p_def[__agent]->n_shared_recs[__agent];
-	for (i = 0; i < n_shared_recs; i++)
+	if ((_to_agent == SELF) || (_to_agent == Whoami()))
 	{
-		p_rec = (TRec*)((char*)(p_shared_mem[__agent][__agent]) + i * sizeof(TRec));
-		rec[i].id = p_rec->id;
-		rec[i].size = p_rec->size;
-		rec[i].period = p_rec->period;
+		PERR("Impossible to write in the running agent!");
+		return -1;
 	}
 
-	return n_shared_recs;
+	if ((p_rec = get_record(__agent, _to_agent, _id)) == NULL)
+		return -1;
+
+	if (p_rec->local)
+	{
+		PERR("Impossible to write local records!");
+		return -1;
+	}
+
+	return DB_put_in_len(__agent, _to_agent, _id, _value, _size, _life);
+}
+
+
+
+//	*************************
+//	DB_comm_get: Le um registo shared do proprio agente, para envio
+//
+//	Entrada:
+//		int _id = identificador da 'variavel'
+//		void *_value = ponteiro para onde sao copiados os dados
+//		int *_len = number of bytes in use in the record
+//	Saida:
+//		int life = tempo de vida da 'variavel' em ms
+//			-1 = erro
+//
+int DB_comm_get (int _id, void *_value, int *_len)
+{
+	TRec *p_rec;
+
+	if (__agent == -1)
+		return (-1);
+
+	if ((p_rec = get_record(__agent, SELF, _id)) == NULL)
+		return -1;
+
+	return read_record(p_rec, _value, _len, NULL);
+}
+
+
+
+//	*************************
+//	DB_put: Escreve na base de dados do proprio agente
+//
+//	Entrada:
+//		int _id = identificador da 'variavel'
+//		void *_value = ponteiro com os dados
+//	Saida:
+//		int size = size of record data
+//		-1 = error
+//
+int DB_put (int _id, void *_value)
+{
+	if (__agent == -1)
+		return (-1);
+	return DB_put_in(__agent, SELF, _id, _value, 0);
+}
+
+
+
+//	*************************
+//	DB_put_len: Escreve os primeiros _len bytes de um registo do proprio agente
+//		only the used part is copied, and broadcast if the record is shared
+//
+//	Entrada:
+//		int _id = identificador da 'variavel'
+//		void *_value = ponteiro com os dados
+//		int _len = number of bytes in use, up to the record size
+//	Saida:
+//		int len = bytes written
+//		-1 = error
+//
+int DB_put_len (int _id, void *_value, int _len)
+{
+	if (__agent == -1)
+		return (-1);
+	return DB_put_in_len(__agent, SELF, _id, _value, _len, 0);
+}
+
+
+
+//	*************************
+//	urgent_address: socket where the comm of an agent takes urgent requests
+//
+//	input:
+//		RTDBdef *p_def = agent segment
+//		struct sockaddr_un *_addr = address
+//	output:
+//		address length
+//
+static socklen_t urgent_address (RTDBdef *p_def, struct sockaddr_un *_addr)
+{
+	int len;
+
+	memset(_addr, 0, sizeof(struct sockaddr_un));
+	_addr->sun_family = AF_UNIX;
+	// abstract name, nothing left in the file system
+	len = snprintf(_addr->sun_path + 1, sizeof(_addr->sun_path) - 1, "%s.%d.%d", URGENT_NAME, p_def->team, p_def->self_agent);
+	return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + len);
+}
+
+
+
+//	*************************
+//	DB_put_urgent: Escreve na base de dados do proprio agente e pede ao comm
+//		para o enviar ja, sem esperar pelo seu periodo
+//
+//	Entrada:
+//		int _id = identificador da 'variavel' (shared)
+//		void *_value = ponteiro com os dados
+//	Saida:
+//		0 = OK
+//		-1 = erro (the record was not written)
+//
+int DB_put_urgent (int _id, void *_value)
+{
+	RTDBdef *p_def;
+	struct sockaddr_un addr;
+	socklen_t len;
+
+	if (DB_put(_id, _value) == -1)
+		return (-1);
+
+	if ((p_def = get_instance(__agent)) == NULL)
+		return (-1);
+
+	if ((urgent_fd == -1) && ((urgent_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1))
+	{
+		PERRNO("socket");
+		return 0;
+	}
+
+	// if comm is not running or is too busy, the record still goes in its period
+	len = urgent_address(p_def, &addr);
+	if (sendto(urgent_fd, &_id, sizeof(_id), 0, (struct sockaddr*)&addr, len) == -1)
+	{
+		PDEBUG("urgent %d not sent to comm: %s", _id, strerror(errno));
+	}
+
+	return 0;
+}
+
+
+
+//	*************************
+//	DB_get_from: Le da base de dados
+//
+//	Entrada:
+//		int _agent
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		void *_value = ponteiro para onde sao copiados os dados
+//	Saida:
+//		int life = tempo de vida da 'variavel' em ms
+//			-1 se erro
+//
+int DB_get_from (int _agent, int _from_agent, int _id, void *_value)
+{
+	TRec *p_rec;
+
+	if ((p_rec = get_record(_agent, _from_agent, _id)) == NULL)
+		return -1;
+
+	return read_record(p_rec, _value, NULL, NULL);
+}
+
+
+
+//	*************************
+//	DB_get_from: Le da base de dados
+//
+//	Entrada:
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		void *_value = ponteiro para onde sao copiados os dados
+//	Saida:
+//		tempo de vida da 'variavel' em ms
+//			-1 = error
+//
+int DB_get (int _from_agent, int _id, void *_value)
+{
+	if (__agent == -1)
+		return (-1);
+	return (DB_get_from (__agent, _from_agent, _id, _value));
+}
+
+
+
+//	*************************
+//	DB_get_many_from: Le da base de dados varios registos de uma so vez
+//		all the lives are measured against one timestamp taken at the start
+//
+//	Entrada:
+//		int _agent
+//		RTDBitem *_items = (agent, id, value) of each record to read,
+//			len and life are filled in (life -1 if the record could not be read)
+//		int _n = number of items
+//	Saida:
+//		number of records read
+//		-1 = erro
+//
+int DB_get_many_from (int _agent, RTDBitem *_items, int _n)
+{
+	TRec *p_rec;
+	struct timeval time;
+	int i, n_read;
+
+	if (get_instance(_agent) == NULL)
+	{
+		for (i = 0; i < _n; i++)
+			_items[i].life = -1;
+		return -1;
+	}
+
+	gettimeofday(&time, NULL);
+
+	n_read = 0;
+	for (i = 0; i < _n; i++)
+	{
+		_items[i].len = 0;
+		if ((p_rec = get_record(_agent, _items[i].agent, _items[i].id)) == NULL)
+			_items[i].life = -1;
+		else
+			_items[i].life = read_record(p_rec, _items[i].value, &_items[i].len, &time);
+
+		if (_items[i].life != -1)
+			n_read ++;
+	}
+
+	return n_read;
+}
+
+
+
+//	*************************
+//	DB_get_many: Le da base de dados varios registos de uma so vez
+//
+//	Entrada:
+//		RTDBitem *_items = (agent, id, value) of each record to read
+//		int _n = number of items
+//	Saida:
+//		number of records read
+//		-1 = erro
+//
+int DB_get_many (RTDBitem *_items, int _n)
+{
+	if (__agent == -1)
+		return (-1);
+	return (DB_get_many_from (__agent, _items, _n));
+}
+
+
+
+//	*************************
+//	put_items: write several records with one timestamp
+//		every record is published on its own, readers may see some of them
+//		updated before the others
+//
+//	input:
+//		int _agent
+//		RTDBitem *_items = records to write
+//		int _n = number of items
+//		int _self = 1 writes the records of the running agent, with life 0
+//	output:
+//		number of records written
+//		-1 = error
+//
+static int put_items (int _agent, RTDBitem *_items, int _n, int _self)
+{
+	RTDBref ref;
+	void *p_data;
+	struct timeval time;
+	int i, len, n_written;
+
+	if (get_instance(_agent) == NULL)
+		return -1;
+
+	gettimeofday(&time, NULL);
+
+	n_written = 0;
+	for (i = 0; i < _n; i++)
+	{
+		if (_self)
+			p_data = DB_put_begin_in(_agent, SELF, _items[i].id, 0, &ref);
+		else
+			p_data = DB_put_begin_in(_agent, _items[i].agent, _items[i].id, _items[i].life, &ref);
+		if (p_data == NULL)
+			continue;
+
+		len = _items[i].len;
+		if ((len < 0) || (len > ((TRec*)ref.p_rec)->size))
+			len = ((TRec*)ref.p_rec)->size;
+		memcpy(p_data, _items[i].value, len);
+
+		if (commit_bank(&ref, len, &time) != -1)
+			n_written ++;
+	}
+
+	return n_written;
+}
+
+
+
+//	*************************
+//	DB_put_many_in: write several records in RTDB
+//		note: it can write in any area (use with caution!)
+//
+//	input:
+//		int _agent
+//		RTDBitem *_items = (agent, id, value, len, life) of each record,
+//			len -1 writes the whole record
+//		int _n = number of items
+//	output:
+//		number of records written
+//		-1 = error
+//
+int DB_put_many_in (int _agent, RTDBitem *_items, int _n)
+{
+	return put_items(_agent, _items, _n, 0);
+}
+
+
+
+//	*************************
+//	DB_put_many: Escreve varios registos na base de dados do proprio agente
+//		the agent and life of the items are ignored
+//
+//	Entrada:
+//		RTDBitem *_items = (id, value, len) of each record, len -1 writes the whole record
+//		int _n = number of items
+//	Saida:
+//		number of records written
+//		-1 = erro
+//
+int DB_put_many (RTDBitem *_items, int _n)
+{
+	if (__agent == -1)
+		return (-1);
+	return put_items(__agent, _items, _n, 1);
+}
+
+
+
+//	*************************
+//	DB_get_at_from: Le da base de dados o valor de uma 'variavel' num instante passado
+//		gives the newest sample written at or before _time, only the samples
+//		kept by the history of the record (rtdb.conf) are available
+//
+//	Entrada:
+//		int _agent
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		struct timeval *_time = instante pretendido (relogio da maquina local)
+//		void *_value = ponteiro para onde sao copiados os dados
+//	Saida:
+//		int age = idade da amostra no instante _time, em ms
+//			-1 = no sample old enough or error
+//
+int DB_get_at_from (int _agent, int _from_agent, int _id, struct timeval *_time, void *_value)
+{
+	TRec *p_rec;
+	struct timeval stamp;
+
+	if ((p_rec = get_record(_agent, _from_agent, _id)) == NULL)
+		return -1;
+
+	if (read_history(p_rec, NULL, _time, _value, &stamp, 1) != 1)
+		return -1;
+
+	return (int)(((_time->tv_sec - stamp.tv_sec) * 1E3) + ((_time->tv_usec - stamp.tv_usec) / 1E3));
+}
+
+
+
+//	*************************
+//	DB_get_at: Le da base de dados o valor de uma 'variavel' num instante passado
+//
+//	Entrada:
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		struct timeval *_time = instante pretendido (relogio da maquina local)
+//		void *_value = ponteiro para onde sao copiados os dados
+//	Saida:
+//		int age = idade da amostra no instante _time, em ms
+//			-1 = no sample old enough or error
+//
+int DB_get_at (int _from_agent, int _id, struct timeval *_time, void *_value)
+{
+	if (__agent == -1)
+		return (-1);
+	return (DB_get_at_from (__agent, _from_agent, _id, _time, _value));
+}
+
+
+
+//	*************************
+//	DB_get_range_from: Le da base de dados as amostras de uma 'variavel' num intervalo
+//		samples are copied newest first, one record size apart
+//
+//	Entrada:
+//		int _agent
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		struct timeval *_from = inicio do intervalo (NULL = sem limite)
+//		struct timeval *_to = fim do intervalo (NULL = sem limite)
+//		void *_values = ponteiro para onde sao copiados os dados (_max registos)
+//		struct timeval *_stamps = timestamps das amostras copiadas (pode ser NULL)
+//		int _max = numero maximo de amostras
+//	Saida:
+//		numero de amostras copiadas
+//			-1 = erro
+//
+int DB_get_range_from (int _agent, int _from_agent, int _id, struct timeval *_from, struct timeval *_to, void *_values, struct timeval *_stamps, int _max)
+{
+	TRec *p_rec;
+
+	if ((p_rec = get_record(_agent, _from_agent, _id)) == NULL)
+		return -1;
+
+	return read_history(p_rec, _from, _to, _values, _stamps, _max);
+}
+
+
+
+//	*************************
+//	DB_get_range: Le da base de dados as amostras de uma 'variavel' num intervalo
+//
+//	Entrada:
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		struct timeval *_from = inicio do intervalo (NULL = sem limite)
+//		struct timeval *_to = fim do intervalo (NULL = sem limite)
+//		void *_values = ponteiro para onde sao copiados os dados (_max registos)
+//		struct timeval *_stamps = timestamps das amostras copiadas (pode ser NULL)
+//		int _max = numero maximo de amostras
+//	Saida:
+//		numero de amostras copiadas
+//			-1 = erro
+//
+int DB_get_range (int _from_agent, int _id, struct timeval *_from, struct timeval *_to, void *_values, struct timeval *_stamps, int _max)
+{
+	if (__agent == -1)
+		return (-1);
+	return (DB_get_range_from (__agent, _from_agent, _id, _from, _to, _values, _stamps, _max));
+}
+
+
+
+//	*************************
+//	DB_get_ref_from: in-place access to the current bank of a record
+//		note: the data may be overwritten at any time, check it with DB_ref_valid after use;
+//		the length and the life are taken under the seqlock, so they are always consistent
+//
+//	input:
+//		int _agent
+//		int _from_agent = agent number
+//		int _id = identificador da 'variavel'
+//		int *_life = tempo de vida da 'variavel' em ms
+//		RTDBref *_ref = reference to be given to DB_ref_valid
+//	output:
+//		pointer to the record data in the shared segment
+//		NULL = error
+//
+const void *DB_get_ref_from (int _agent, int _from_agent, int _id, int *_life, RTDBref *_ref)
+{
+	TRec *p_rec;
+	TBank *p_bank;
+	struct timeval stamp;
+	struct timeval time;
+	int retries;
+
+	if ((p_rec = get_record(_agent, _from_agent, _id)) == NULL)
+		return NULL;
+
+	// only the bank header is read here, the data is checked by the caller
+	for (retries = 0; retries < MAX_READ_RETRIES; retries++)
+	{
+		_ref->seq = SEQ_LOAD(&p_rec->seq);
+		_ref->bank = SEQ_LOAD(&p_rec->read_bank);
+		p_bank = BANK(p_rec, _ref->bank);
+		_ref->length = p_bank->length;
+		stamp = p_bank->timestamp;
+
+		RMB();
+		if (bank_intact(p_rec, _ref->seq, p_rec->seq, 0))
+			break;
+	}
+
+	if (retries == MAX_READ_RETRIES)
+	{
+		PDEBUG("id: %d, record kept changing while reading", p_rec->id);
+		_ref->p_rec = NULL;
+		return NULL;
+	}
+
+	_ref->p_rec = p_rec;
+	if ((_ref->length < 0) || (_ref->length > p_rec->size))
+		_ref->length = p_rec->size;
+
+	if (_life != NULL)
+	{
+		gettimeofday(&time, NULL);
+		*_life = (int)(((time.tv_sec - stamp.tv_sec) * 1E3) + ((time.tv_usec - stamp.tv_usec) / 1E3));
+		// written after the time was taken
+		if (*_life < 0)
+			*_life = 0;
+	}
+
+	return (void *)(p_bank + 1);
+}
+
+
+
+//	*************************
+//	DB_get_ref: in-place access to a record
+//
+//	input:
+//		int _from_agent = agent number
+//		int _id = identificador da 'variavel'
+//		int *_life = tempo de vida da 'variavel' em ms
+//		RTDBref *_ref = reference to be given to DB_ref_valid
+//	output:
+//		pointer to the record data in the shared segment
+//		NULL = error
+//
+const void *DB_get_ref (int _from_agent, int _id, int *_life, RTDBref *_ref)
+{
+	if (__agent == -1)
+		return NULL;
+	return DB_get_ref_from(__agent, _from_agent, _id, _life, _ref);
+}
+
+
+
+//	*************************
+//	DB_ref_valid: check if the data given by DB_get_ref is still intact
+//
+//	input:
+//		RTDBref *_ref = reference returned by DB_get_ref
+//	output:
+//		1 = data was not overwritten since DB_get_ref
+//		0 = data may be corrupted, it must be read again
+//
+int DB_ref_valid (RTDBref *_ref)
+{
+	TRec *p_rec = (TRec*)_ref->p_rec;
+
+	if (p_rec == NULL)
+		return 0;
+
+	RMB();
+	return bank_intact(p_rec, _ref->seq, p_rec->seq, 0);
+}
+
+
+
+//	*************************
+//	DB_get_seq_from: current version of a record
+//
+//	input:
+//		int _agent
+//		int _from_agent = agent number
+//		int _id = identificador da 'variavel'
+//	output:
+//		number of writes committed in the record (0 if never written or error)
+//
+unsigned int DB_get_seq_from (int _agent, int _from_agent, int _id)
+{
+	TRec *p_rec;
+
+	if ((p_rec = get_record(_agent, _from_agent, _id)) == NULL)
+		return 0;
+
+	return SEQ_LOAD(&p_rec->seq) >> 1;
+}
+
+
+
+//	*************************
+//	DB_get_seq: current version of a record
+//
+//	input:
+//		int _from_agent = agent number
+//		int _id = identificador da 'variavel'
+//	output:
+//		number of writes committed in the record (0 if never written or error)
+//
+unsigned int DB_get_seq (int _from_agent, int _id)
+{
+	if (__agent == -1)
+		return 0;
+	return DB_get_seq_from(__agent, _from_agent, _id);
+}
+
+
+
+//	*************************
+//	DB_wait_from: block until a newer version of a record is committed
+//
+//	input:
+//		int _agent
+//		int _from_agent = agent number
+//		int _id = identificador da 'variavel'
+//		unsigned int _last_seq = last version seen (see DB_get_seq)
+//		int _timeout = maximum waiting time in ms (-1 = no timeout)
+//	output:
+//		1 = a newer version is available
+//		0 = timeout
+//		-1 = error
+//
+int DB_wait_from (int _agent, int _from_agent, int _id, unsigned int _last_seq, int _timeout)
+{
+	TRec *p_rec;
+	unsigned int seq;
+	int ret = 0;
+	struct timespec now, end, rel;
+
+	if ((p_rec = get_record(_agent, _from_agent, _id)) == NULL)
+		return -1;
+
+	if (_timeout >= 0)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		end.tv_sec += _timeout / 1000;
+		end.tv_nsec += (_timeout % 1000) * 1000000L;
+		if (end.tv_nsec >= 1000000000L)
+		{
+			end.tv_sec ++;
+			end.tv_nsec -= 1000000000L;
+		}
+	}
+
+	__atomic_add_fetch(&p_rec->waiters, 1, __ATOMIC_SEQ_CST);
+
+	while (1)
+	{
+		seq = SEQ_LOAD(&p_rec->seq);
+		if ((int)((seq >> 1) - _last_seq) > 0)
+		{
+			ret = 1;
+			break;
+		}
+
+		if (_timeout >= 0)
+		{
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			rel.tv_sec = end.tv_sec - now.tv_sec;
+			rel.tv_nsec = end.tv_nsec - now.tv_nsec;
+			if (rel.tv_nsec < 0)
+			{
+				rel.tv_sec --;
+				rel.tv_nsec += 1000000000L;
+			}
+			if (rel.tv_sec < 0)
+				break;
+		}
+
+		// sleeps only if the record was not written meanwhile
+		if ((syscall(SYS_futex, &p_rec->seq, FUTEX_WAIT, seq, (_timeout >= 0) ? &rel : NULL, NULL, 0) == -1) &&
+				(errno != EAGAIN) && (errno != EINTR) && (errno != ETIMEDOUT))
+		{
+			PERRNO("futex");
+			ret = -1;
+			break;
+		}
+	}
+
+	__atomic_sub_fetch(&p_rec->waiters, 1, __ATOMIC_SEQ_CST);
+
+	PDEBUG("agent: %d, from_agent: %d, id: %d, last_seq: %u, seq: %u, ret: %d", _agent, _from_agent, _id, _last_seq, seq >> 1, ret);
+
+	return ret;
+}
+
+
+
+//	*************************
+//	DB_wait: block until a newer version of a record is committed
+//
+//	input:
+//		int _from_agent = agent number
+//		int _id = identificador da 'variavel'
+//		unsigned int _last_seq = last version seen (see DB_get_seq)
+//		int _timeout = maximum waiting time in ms (-1 = no timeout)
+//	output:
+//		1 = a newer version is available
+//		0 = timeout
+//		-1 = error
+//
+int DB_wait (int _from_agent, int _id, unsigned int _last_seq, int _timeout)
+{
+	if (__agent == -1)
+		return -1;
+	return DB_wait_from(__agent, _from_agent, _id, _last_seq, _timeout);
+}
+
+
+
+//	*************************
+//	Whoami: identifica o agente onde esta a correr
+//
+//	Saida:
+//		int agent_number = numero do agente
+//		-1 = error
+//
+int Whoami(void)
+{
+	RTDBdef *p_def;
+
+	if ((p_def = get_instance(__agent)) == NULL)
+		return (-1);
+	return (p_def->self_agent);
+}
+
+
+
+//	*************************
+//	DB_comm_ini: 
+//
+//	Entrada:
+//		RTDBconf_var *rec = array com as 'variaveis' shared do agente
+//			(NULL to get only their number)
+//	Saida:
+//		int n_shared_recs = numero de 'variaveis' shared
+//		-1 = erro
+//
+int DB_comm_ini(RTDBconf_var *rec)
+{
+	RTDBdef *p_def;
+	int n_shared_recs;
+	int i, offset;
+	TRec *p_rec;
+
+	if ((p_def = get_instance(__agent)) == NULL)
+		return (-1);
+
+	n_shared_recs = 0;
+	for (i = 0; i < p_def->n_items; i++)
+	{
+		if ((offset = DIR(p_def)[p_def->self_agent * p_def->n_items + i]) == -1)
+			continue;
+		p_rec = (TRec*)((char*)p_def + offset);
+		if (p_rec->local)
+			continue;
+		if (rec != NULL)
+		{
+			rec[n_shared_recs].id = p_rec->id;
+			rec[n_shared_recs].size = p_rec->size;
+			rec[n_shared_recs].period = p_rec->period;
+			rec[n_shared_recs].history = p_rec->n_banks - 2;
+			rec[n_shared_recs].channel = p_rec->channel;
+			rec[n_shared_recs].layout = p_rec->layout;
+		}
+		n_shared_recs ++;
+	}
+
+	return n_shared_recs;
+}
+
+
+
+//	*************************
+//	DB_comm_schema: hash of the shared records of every agent
+//		(FNV-1a over agent, id, size, channel and layout), peers with a
+//		different hash can not decode each other frames
+//		the payloads go on the wire as the host structs, so the layout
+//		hash from xrtdb (data type declarations, alignment and byte order)
+//		tells peers built from different declarations apart
+//
+//	Saida:
+//		unsigned int hash
+//		0 = erro
+//
+unsigned int DB_comm_schema(void)
+{
+	RTDBdef *p_def;
+	unsigned int hash = 2166136261u;
+	int i, k, offset;
+	int v[5];
+	TRec *p_rec;
+
+	if ((p_def = get_instance(__agent)) == NULL)
+		return 0;
+
+	for (i = 0; i < p_def->n_agents * p_def->n_items; i++)
+	{
+		if ((offset = DIR(p_def)[i]) == -1)
+			continue;
+		p_rec = (TRec*)((char*)p_def + offset);
+		if (p_rec->local)
+			continue;
+		v[0] = p_rec->agent;
+		v[1] = p_rec->id;
+		v[2] = p_rec->size;
+		v[3] = p_rec->channel;
+		v[4] = (int)p_rec->layout;
+		for (k = 0; k < (int)sizeof(v); k++)
+			hash = (hash ^ ((v[k / sizeof(int)] >> (8 * (k % sizeof(int)))) & 0xff)) * 16777619u;
+	}
+
+	return (hash == 0) ? 1 : hash;
+}
+
+
+
+//	*************************
+//	DB_comm_channels: comm channels declared in rtdb.ini (#CHANNEL lines)
+//
+//	Entrada:
+//		RTDBchannel *channels = array for the channels (NULL to get only their number)
+//		int max = size of the array
+//	Saida:
+//		int n_channels = numero de canais, besides the default one
+//		-1 = erro
+//
+int DB_comm_channels(RTDBchannel *channels, int max)
+{
+	FILE *f_def;
+	char s[100];
+	RTDBchannel ch;
+	int n = 0;
+
+	if ((f_def = fopen(rtdbConfigFile, "r")) == NULL)
+	{
+		PERRNO("fopen");
+		return (-1);
+	}
+
+	while (fgets(s, sizeof(s), f_def) != NULL)
+	{
+		if (strncmp(s, "#CHANNEL", 8) != 0)
+			continue;
+		if ((sscanf(s + 8, "%d %31s %15s %d %d %d", &ch.number, ch.name, ch.group, &ch.port, &ch.period, &ch.ttl) != 6) ||
+			(ch.number < 1) || (ch.port < 1) || (ch.period < 1))
+		{
+			PERR("Invalid channel in %s: %s", rtdbConfigFile, s);
+			fclose(f_def);
+			return (-1);
+		}
+		if ((channels != NULL) && (n < max))
+			channels[n] = ch;
+		n ++;
+	}
+
+	fclose(f_def);
+
+	return n;
+}
+
+
+
+//	*************************
+//	DB_comm_urgent: socket where DB_put_urgent requests arrive
+//
+//	Saida:
+//		socket descriptor (non blocking, each datagram has an int id)
+//		-1 = erro
+//
+int DB_comm_urgent(void)
+{
+	RTDBdef *p_def;
+	struct sockaddr_un addr;
+	int fd;
+
+	if ((p_def = get_instance(__agent)) == NULL)
+		return (-1);
+
+	if ((fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1)
+	{
+		PERRNO("socket");
+		return (-1);
+	}
+
+	if (bind(fd, (struct sockaddr*)&addr, urgent_address(p_def, &addr)) == -1)
+	{
+		PERRNO("bind");
+		close(fd);
+		return (-1);
+	}
+
+	return fd;
 }
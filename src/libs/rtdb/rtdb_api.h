@@ -27,10 +27,18 @@
 extern "C" {
 #endif
 
+#include <sys/time.h>
 #include "rtdbdefs.h"
 
 //	*************************
 //	DB_init: Aloca acesso a base de dados
+//		agent number from the AGENT environment variable, team from
+//		RTDB_TEAM (0 by default, SECOND_RTDB still means team 1)
+//		the segment is /dev/shm/rtdb.<team>.<agent>, RTDB_HUGEPAGES asks
+//		for transparent huge pages
+//		RTDB_RECORD=<dir> appends every write to <dir>/rtdb.<team>.<agent>.rec,
+//		read it with rtdb_rec (a tmpfs directory keeps disk I/O away from
+//		the writers); RTDB_RECORD_SIZE sets its size in MB
 //
 //	Saida:
 //		0 = OK
@@ -58,6 +66,22 @@ void DB_free (void);
 int DB_put (int _id, void *_value);
 
 
+//	*************************
+//	DB_put_len: Escreve os primeiros _len bytes de um registo do proprio agente
+//		for records whose tail is only partially used (e.g. point lists);
+//		only the used part is copied, and broadcast if the record is shared
+//
+//	Entrada:
+//		int _id = identificador da 'variavel'
+//		void *_value = ponteiro com os dados
+//		int _len = number of bytes in use, up to the record size
+//	Saida:
+//		int len = bytes written
+//		-1 = erro
+//
+int DB_put_len (int _id, void *_value, int _len);
+
+
 //	*************************
 //	DB_get: Le da base de dados
 //
@@ -67,11 +91,124 @@ int DB_put (int _id, void *_value);
 //		void *_value = ponteiro para onde sao copiados os dados
 //	Saida:
 //		int life = tempo de vida da 'variavel' em ms
-//			-1 se erro
+//			-1 se erro (or if the record kept being rewritten while reading)
 //
 int DB_get (int _from_agent, int _id, void *_value);
 
 
+//	*************************
+//	DB_get_many: Le da base de dados varios registos de uma so vez
+//		one lookup per record and one timestamp for the whole batch
+//
+//	Entrada:
+//		RTDBitem *_items = (agent, id, value) of each record to read,
+//			len and life are filled in (life -1 if the record could not be read)
+//		int _n = number of items
+//	Saida:
+//		number of records read
+//		-1 = erro
+//
+int DB_get_many (RTDBitem *_items, int _n);
+
+
+//	*************************
+//	DB_put_many: Escreve varios registos na base de dados do proprio agente
+//		all the records get the same timestamp, each one is published on its own
+//
+//	Entrada:
+//		RTDBitem *_items = (id, value, len) of each record, len -1 writes the
+//			whole record; agent and life are ignored
+//		int _n = number of items
+//	Saida:
+//		number of records written
+//		-1 = erro
+//
+int DB_put_many (RTDBitem *_items, int _n);
+
+
+//	*************************
+//	DB_put_urgent: Escreve na base de dados do proprio agente e pede ao comm
+//		para o enviar ja, numa trama propria fora do periodo do registo
+//		(para eventos, como o anuncio de um passe); comm limits how many
+//		of these frames it sends, the others wait for the next one
+//
+//	Entrada:
+//		int _id = identificador da 'variavel' (shared)
+//		void *_value = ponteiro com os dados
+//	Saida:
+//		0 = OK
+//		-1 = erro
+//
+int DB_put_urgent (int _id, void *_value);
+
+
+//	*************************
+//	DB_get_seq: versao actual de uma 'variavel'
+//		the version is incremented by every write committed in the record
+//
+//	Entrada:
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//	Saida:
+//		number of writes committed in the record (0 if never written or error)
+//
+unsigned int DB_get_seq (int _from_agent, int _id);
+
+
+//	*************************
+//	DB_get_at: Le da base de dados o valor de uma 'variavel' num instante passado
+//		gives the newest sample written at or before _time; how far back it
+//		can go is set by the history of the item in rtdb.conf
+//
+//	Entrada:
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		struct timeval *_time = instante pretendido (relogio da maquina local)
+//		void *_value = ponteiro para onde sao copiados os dados
+//	Saida:
+//		int age = idade da amostra no instante _time, em ms
+//			-1 = no sample old enough or error
+//
+int DB_get_at (int _from_agent, int _id, struct timeval *_time, void *_value);
+
+
+//	*************************
+//	DB_get_range: Le da base de dados as amostras de uma 'variavel' num intervalo
+//		samples are copied newest first, one record size apart
+//
+//	Entrada:
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		struct timeval *_from = inicio do intervalo (NULL = sem limite)
+//		struct timeval *_to = fim do intervalo (NULL = sem limite)
+//		void *_values = ponteiro para onde sao copiados os dados (_max registos)
+//		struct timeval *_stamps = timestamps das amostras copiadas (pode ser NULL)
+//		int _max = numero maximo de amostras
+//	Saida:
+//		numero de amostras copiadas
+//			-1 = erro
+//
+int DB_get_range (int _from_agent, int _id, struct timeval *_from, struct timeval *_to, void *_values, struct timeval *_stamps, int _max);
+
+
+//	*************************
+//	DB_wait: espera por uma nova versao de uma 'variavel'
+//		blocks on a futex in the shared segment; writers only issue a
+//		syscall when there are processes waiting
+//
+//	Entrada:
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		unsigned int _last_seq = last version seen (see DB_get_seq)
+//		int _timeout = maximum waiting time in ms (-1 = no timeout)
+//	Saida:
+//		1 = a newer version is available
+//		0 = timeout
+//		-1 = erro
+//
+int DB_wait (int _from_agent, int _id, unsigned int _last_seq, int _timeout);
+
+
 //	*************************
 //	Whoami: identifica o agente onde esta a correr
 //
@@ -96,6 +233,74 @@ int Whoami(void);
 //
 int DB_put_in (int _agent, int _to_agent, int _id, void *_value, int life);
 
+//	*************************
+//	DB_put_in_len: as DB_put_in, writing only the first _len bytes of the record
+//
+int DB_put_in_len (int _agent, int _to_agent, int _id, void *_value, int _len, int life);
+
+
+//	*************************
+//	DB_get_ref: in-place access to a record, without copying it
+//		note: the data may be overwritten at any time, check it with DB_ref_valid after use
+//		note: only the first _ref->length bytes were written by the producer
+//
+//	Entrada:
+//		int _from_agent = numero do agente
+//		int _id = identificador da 'variavel'
+//		int *_life = tempo de vida da 'variavel' em ms (may be NULL)
+//		RTDBref *_ref = reference to be given to DB_ref_valid
+//	Saida:
+//		pointer to the record data in the shared segment
+//		NULL = erro
+//
+const void *DB_get_ref (int _from_agent, int _id, int *_life, RTDBref *_ref);
+
+
+//	*************************
+//	DB_ref_valid: check if the data given by DB_get_ref is still intact
+//
+//	Entrada:
+//		RTDBref *_ref = reference returned by DB_get_ref
+//	Saida:
+//		1 = data was not overwritten since DB_get_ref
+//		0 = data must be read again
+//
+int DB_ref_valid (RTDBref *_ref);
+
+
+//	*************************
+//	DB_put_begin: reserve the next bank of a record of the running agent,
+//		for in-place writing. Readers keep seeing the previous data until
+//		DB_put_commit is called.
+//		note: the bank holds old data, the whole record must be filled up
+//
+//	Entrada:
+//		int _id = identificador da 'variavel'
+//		RTDBref *_ref = reference to be given to DB_put_commit
+//	Saida:
+//		pointer to the bank where the data must be written
+//		NULL = erro
+//
+void *DB_put_begin (int _id, RTDBref *_ref);
+
+
+//	*************************
+//	DB_put_commit: publish a bank reserved with DB_put_begin
+//
+//	Entrada:
+//		RTDBref *_ref = reference returned by DB_put_begin
+//	Saida:
+//		int size = size of record data
+//		-1 = erro
+//
+int DB_put_commit (RTDBref *_ref);
+
+
+//	*************************
+//	DB_put_commit_len: as DB_put_commit, publishing only the first _len bytes
+//
+int DB_put_commit_len (RTDBref *_ref, int _len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,28 +36,76 @@ extern "C" {
 //	Entrada:
 //		int _agent = numero do agente
 //		int _id = identificador da 'variavel'
+//		int _size = bytes received, up to the record size
 //		void *_value = ponteiro com os dados
 //		int life = tempo de vida da 'variavel' em ms
 //	Saida:
-//		0 = OK
+//		int size = bytes written
 //		-1 = erro
 //
 int DB_comm_put (int _agent, int _id, int _size, void *_value, int life);
 
 
+//	*************************
+//	DB_comm_get: Le um registo shared do proprio agente, para envio
+//
+//	Entrada:
+//		int _id = identificador da 'variavel'
+//		void *_value = ponteiro para onde sao copiados os dados (record size)
+//		int *_len = number of bytes in use in the record
+//	Saida:
+//		int life = tempo de vida da 'variavel' em ms
+//		-1 = erro
+//
+int DB_comm_get (int _id, void *_value, int *_len);
+
+
 //	*************************
 //	DB_comm_ini: 
 //
 //	Entrada:
-//		int _id = array com identificadores da 'variavel'
-//		int _size = array com temanhos da 'variavel'
-//		int _period = array com periodos da 'variavel'
+//		RTDBconf_var *rec = array com as 'variaveis' shared do agente
+//			(NULL to get only their number)
 //	Saida:
 //		int n_shared_recs = numero de 'variaveis' shared
 //		-1 = erro
 //
 int DB_comm_ini(RTDBconf_var *rec);
 
+
+//	*************************
+//	DB_comm_schema: hash of the shared records of every agent
+//
+//	Saida:
+//		unsigned int hash (the same in every agent with the same rtdb.ini,
+//		layout hashes of the data types included)
+//		0 = erro
+//
+unsigned int DB_comm_schema(void);
+
+
+//	*************************
+//	DB_comm_channels: canais do comm declarados no rtdb.ini
+//
+//	Entrada:
+//		RTDBchannel *channels = array para os canais (NULL to get only their number)
+//		int max = size of the array
+//	Saida:
+//		int n_channels = numero de canais, alem do canal 0 (default)
+//		-1 = erro
+//
+int DB_comm_channels(RTDBchannel *channels, int max);
+
+
+//	*************************
+//	DB_comm_urgent: socket onde chegam os pedidos de DB_put_urgent
+//
+//	Saida:
+//		socket descriptor (non blocking, one int id per datagram)
+//		-1 = erro
+//
+int DB_comm_urgent(void);
+
 #ifdef __cplusplus
 }
 #endif
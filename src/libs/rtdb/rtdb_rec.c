@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA RTDB
+ *
+ * CAMBADA RTDB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA RTDB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//	rtdb_rec: reader of the RTDB flight recorder files (see rtdb_record.h)
+//
+//	rtdb_rec [-f] [-t seconds] [-a agent] [-i id] [-x] file
+//		-f	follow: keep waiting for new entries (while the agent runs)
+//		-t	start at this time, in seconds from the start of the recording
+//		-a	only the records of this agent
+//		-i	only this item id
+//		-x	hex dump of the data
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "rtdb_record.h"
+
+#define PERRNO(txt) \
+	fprintf(stderr, "ERROR: (%s / %s): " txt ": %s\n", __FILE__, __FUNCTION__, strerror(errno))
+
+#define PERR(txt, par...) \
+	fprintf(stderr, "ERROR: (%s / %s): " txt "\n", __FILE__, __FUNCTION__, ## par)
+
+// follow mode polling period (us)
+#define FOLLOW_PERIOD	10000
+
+
+
+//	*************************
+//	seek: first entry to read for a given time
+//		the index gives the last step written before _time, the entries
+//		from there on are read until the first one not older than _time.
+//		Slots are not ordered by time (see rtdb_record.h), so they are
+//		scanned in file order: empty ones are skipped and the scan stops at
+//		the first one newer than _time
+//
+//	input:
+//		RTDBrec_header *p_hdr = file header
+//		unsigned long long _time = CLOCK_MONOTONIC (ns)
+//	output:
+//		offset of the entry
+//
+static unsigned long long seek (RTDBrec_header *p_hdr, unsigned long long _time)
+{
+	RTDBrec_index *p_index = RECORD_INDEX(p_hdr);
+	RTDBrec_entry *p_entry;
+	unsigned long long off = 0;
+	unsigned long long end = p_hdr->tail;
+	int k;
+
+	for (k = 0; k < p_hdr->n_index; k++)
+	{
+		if (p_index[k].time == 0)
+			continue;
+		if (p_index[k].time > _time)
+			break;
+		off = p_index[k].offset;
+	}
+
+	if (end > p_hdr->size - p_hdr->data)
+		end = p_hdr->size - p_hdr->data;
+
+	while (off < end)
+	{
+		p_entry = RECORD_ENTRY(p_hdr, off);
+		if ((p_entry->length == 0) || (p_entry->time >= _time))
+			break;
+		off += p_entry->length;
+	}
+
+	return off;
+}
+
+
+
+static void print_entry (RTDBrec_header *p_hdr, RTDBrec_entry *p_entry, int _hex)
+{
+	unsigned long long real = p_hdr->real0 + (p_entry->time - p_hdr->mono0);
+	unsigned char *p_data = (unsigned char*)(p_entry + 1);
+	int i;
+
+	printf("%12.6f  %llu.%06llu  agent %d  id %d  seq %u  len %d  life %d\n",
+		(p_entry->time - p_hdr->mono0) / 1E9, real / 1000000000ULL, (real % 1000000000ULL) / 1000ULL,
+		p_entry->agent, p_entry->id, p_entry->seq, p_entry->len, p_entry->life);
+
+	if (_hex)
+	{
+		for (i = 0; i < p_entry->len; i++)
+			printf((i % 32 == 31) || (i == p_entry->len - 1) ? "%02x\n" : "%02x ", p_data[i]);
+	}
+}
+
+
+
+int main (int argc, char *argv[])
+{
+	int follow = 0, hex = 0;
+	int agent = -1, id = -1;
+	double start = -1;
+	unsigned long long off, end;
+	int opt, fd;
+	struct stat st;
+	RTDBrec_header *p_hdr;
+	RTDBrec_entry *p_entry;
+
+	while ((opt = getopt(argc, argv, "ft:a:i:x")) != -1)
+	{
+		switch (opt)
+		{
+			case 'f': follow = 1; break;
+			case 't': start = atof(optarg); break;
+			case 'a': agent = atoi(optarg); break;
+			case 'i': id = atoi(optarg); break;
+			case 'x': hex = 1; break;
+			default:
+				fprintf(stderr, "usage: %s [-f] [-t seconds] [-a agent] [-i id] [-x] file\n", argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc - 1)
+	{
+		fprintf(stderr, "usage: %s [-f] [-t seconds] [-a agent] [-i id] [-x] file\n", argv[0]);
+		return 1;
+	}
+
+	if ((fd = open(argv[optind], O_RDONLY)) == -1)
+	{
+		PERRNO("open");
+		return 1;
+	}
+	if (fstat(fd, &st) == -1)
+	{
+		PERRNO("fstat");
+		return 1;
+	}
+	if ((size_t)st.st_size < sizeof(RTDBrec_header))
+	{
+		PERR("%s is not an RTDB recording", argv[optind]);
+		return 1;
+	}
+
+	// read only, the agent may still be writing it
+	p_hdr = (RTDBrec_header*)mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (p_hdr == MAP_FAILED)
+	{
+		PERRNO("mmap");
+		return 1;
+	}
+	close(fd);
+
+	if ((p_hdr->magic != RECORD_MAGIC) || (p_hdr->version != RECORD_VERSION) || (p_hdr->size != (unsigned long long)st.st_size))
+	{
+		PERR("%s is not an RTDB recording", argv[optind]);
+		return 1;
+	}
+
+	printf("# agent %d of team %d, %llu bytes recorded, %llu writes dropped\n",
+		p_hdr->agent, p_hdr->team, p_hdr->tail < p_hdr->size - p_hdr->data ? p_hdr->tail : p_hdr->size - p_hdr->data, p_hdr->dropped);
+
+	off = (start > 0) ? seek(p_hdr, p_hdr->mono0 + (unsigned long long)(start * 1E9)) : 0;
+
+	for (;;)
+	{
+		end = __atomic_load_n(&p_hdr->tail, __ATOMIC_ACQUIRE);
+		if (end > p_hdr->size - p_hdr->data)
+			end = p_hdr->size - p_hdr->data;
+
+		while (off + sizeof(RTDBrec_entry) <= end)
+		{
+			p_entry = RECORD_ENTRY(p_hdr, off);
+			if (__atomic_load_n(&p_entry->ready, __ATOMIC_ACQUIRE) != RECORD_READY)
+				break;
+			if (((agent == -1) || (p_entry->agent == agent)) && ((id == -1) || (p_entry->id == id)))
+				print_entry(p_hdr, p_entry, hex);
+			off += p_entry->length;
+		}
+
+		if (!follow)
+		{
+			// an entry left incomplete (writer killed while copying) is skipped
+			if ((off + sizeof(RTDBrec_entry) <= end) && (RECORD_ENTRY(p_hdr, off)->length != 0))
+			{
+				off += RECORD_ENTRY(p_hdr, off)->length;
+				continue;
+			}
+			break;
+		}
+
+		fflush(stdout);
+		usleep(FOLLOW_PERIOD);
+	}
+
+	munmap(p_hdr, p_hdr->size);
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2009-2015,
+ * Intelligent Robotics and Intelligent Systems (IRIS) Lab
+ * CAMBADA robotic soccer team – http://robotica.ua.pt/CAMBADA/
+ * University of Aveiro, Portugal
+ *
+ * This file is part of the CAMBADA RTDB
+ *
+ * CAMBADA RTDB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CAMBADA RTDB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this package.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RTDB_RECORD_H
+#define __RTDB_RECORD_H
+
+// flight recorder: when RTDB_RECORD names a directory, every write committed
+// in the RTDB of an agent (by any of its processes) is appended to
+// <RTDB_RECORD>/rtdb.<team>.<agent>.rec
+//
+// the file is mapped by every process of the agent and laid out as
+//	[ RTDBrec_header | index | entries ... ]
+// writers reserve their entry with an atomic add on the tail, so they never
+// wait for each other; readers stop at the first entry not ready yet.
+// The index keeps the entry found every RECORD_INDEX_STEP bytes, for seeking
+// by time without reading the whole file.
+//
+// Neither the entries nor the index slots are strictly ordered by time: a
+// writer reads the clock before reserving its entry, and the slots are
+// filled by whichever writer crosses them, so a slot may still be empty
+// (time 0) while a later one is written, and a time may be a little older
+// than the one of the slot before. Readers skip empty slots and only trust
+// a slot whose time, and the times of every slot before it, are not newer
+// than the time sought.
+//
+// Entry times are CLOCK_MONOTONIC, which restarts on every boot: a file of
+// another boot (boot_id, /proc/sys/kernel/random/boot_id) is renamed to
+// rtdb.<team>.<agent>.<real0 seconds>.rec and a new one is started.
+//
+// Every recording process prefaults its mapping RECORD_PREFAULT_STEPS index
+// steps ahead of the tail, in a SCHED_OTHER thread woken (futex on step) by
+// the writer that crosses a step, so the writers do not take the faults.
+
+#define RECORD_MAGIC		0x52544452	// "RTDR"
+#define RECORD_VERSION		2
+#define RECORD_READY		0x52454459	// entry completely written
+#define RECORD_INDEX_STEP	(1024 * 1024)
+#define RECORD_SIZE_MB		1024		// default file size (RTDB_RECORD_SIZE, in MB)
+#define RECORD_PREFAULT_STEPS	4		// index steps mapped ahead of the tail
+#define RECORD_BOOT_ID		"/proc/sys/kernel/random/boot_id"
+#define RECORD_ALIGN(size)	(((size) + 7) & ~7ULL)
+
+typedef struct
+{
+	unsigned int magic;				// RECORD_MAGIC once the file is initialized
+	int version;					// RECORD_VERSION
+	int team;						// equipa do agente
+	int agent;						// numero do agente
+	unsigned long long size;		// file size
+	unsigned long long data;		// offset of the first entry in the file
+	unsigned long long tail;		// bytes of entries reserved so far
+	unsigned long long dropped;		// writes not recorded because the file was full
+	unsigned long long mono0;		// CLOCK_MONOTONIC when the file was created (ns)
+	unsigned long long real0;		// CLOCK_REALTIME at the same instant (ns)
+	int n_index;					// index slots
+	unsigned int step;				// index step of the last entry that crossed one (futex word)
+	char boot_id[40];				// boot the file was created in (RECORD_BOOT_ID)
+} RTDBrec_header;
+
+typedef struct
+{
+	unsigned long long time;		// time of the entry (0 = slot not written yet)
+	unsigned long long offset;		// offset of the entry, from the first entry
+} RTDBrec_index;
+
+typedef struct
+{
+	unsigned int length;			// entry size, with this header (0 = not reserved yet)
+	unsigned int ready;				// RECORD_READY once the data is written
+	int agent;						// agente a que pertence o registo
+	int id;							// identificador da 'variavel'
+	unsigned int seq;				// record sequence after the write
+	int life;						// tempo de vida da 'variavel' em ms, when written
+	int len;						// bytes of data
+	int pad;
+	unsigned long long time;		// CLOCK_MONOTONIC (ns)
+} RTDBrec_entry;
+
+#define RECORD_INDEX(p_hdr)		((RTDBrec_index*)((p_hdr) + 1))
+#define RECORD_ENTRY(p_hdr, off)	((RTDBrec_entry*)((char*)(p_hdr) + (p_hdr)->data + (off)))
+
+#endif
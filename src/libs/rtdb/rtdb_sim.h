@@ -27,23 +27,51 @@
 extern "C" {
 #endif
 
+#include <sys/time.h>
 #include "rtdbdefs.h"
 
 //	*************************
-//	DB_init_all: Aloca acesso a base de dados
+//	DB_init_all: Aloca acesso a base de dados de todos os agentes de uma equipa
 //
 //	Saida:
 //		0 = OK
 //		-1 = erro
 //
-int DB_init_all (int _second_rtdb);
+int DB_init_all (int _team);
 
-void DB_free_all (int _second_rtdb);
+void DB_free_all (int _team);
+
+//	*************************
+//	DB_instance: memoria de um agente, o primeiro parametro das funcoes seguintes
+//
+//	Saida:
+//		agent memory
+//		-1 = erro (equipa nao inicializada)
+//
+int DB_instance (int _team, int _agent);
 
 int DB_put_in (int _agent, int _to_agent, int _id, void *_value, int life);
 
+int DB_put_in_len (int _agent, int _to_agent, int _id, void *_value, int _len, int life);
+
 int DB_get_from (int _agent, int _from_agent, int _id, void *_value);
 
+int DB_put_many_in (int _agent, RTDBitem *_items, int _n);
+
+int DB_get_many_from (int _agent, RTDBitem *_items, int _n);
+
+const void *DB_get_ref_from (int _agent, int _from_agent, int _id, int *_life, RTDBref *_ref);
+
+void *DB_put_begin_in (int _agent, int _to_agent, int _id, int life, RTDBref *_ref);
+
+int DB_get_at_from (int _agent, int _from_agent, int _id, struct timeval *_time, void *_value);
+
+int DB_get_range_from (int _agent, int _from_agent, int _id, struct timeval *_from, struct timeval *_to, void *_values, struct timeval *_stamps, int _max);
+
+unsigned int DB_get_seq_from (int _agent, int _from_agent, int _id);
+
+int DB_wait_from (int _agent, int _from_agent, int _id, unsigned int _last_seq, int _timeout);
+
 void DB_set_config_file(const char* cf);
 
 #ifdef __cplusplus
@@ -0,0 +1,81 @@
+/* AUTOGEN FILE : rtdb_typed.h */
+
+#ifndef _CAMBADA_RTDB_TYPED_
+#define _CAMBADA_RTDB_TYPED_
+
+#include "rtdb_access.h"
+#include "rtdb_user.h"
+
+#include "Robot.h"
+#include "SystemInfo.h"
+#include "CoachInfo.h"
+#include "VisionInfo.h"
+#include "HWcomm_rtdb.h"
+#include "stdio.h"
+#include "KickCalibData.h"
+#include "GridView.h"
+#include "CoachLogModeInfo.h"
+#include "LinkInfo.h"
+#include "common.h"
+
+/* items section */
+
+namespace rtdb
+{
+using namespace cambada;
+
+template<> struct item<ROBOT_WS> { typedef Robot type; };
+template<> struct item<LAPTOP_INFO> { typedef LaptopInfo type; };
+template<> struct item<COACH_INFO> { typedef CoachInfo type; };
+template<> struct item<VISION_INFO> { typedef VisionInfo type; };
+template<> struct item<FRONT_VISION_INFO> { typedef FrontVisionInfo type; };
+template<> struct item<FORMATION_INFO> { typedef FormationInfo type; };
+template<> struct item<CMD_VEL> { typedef CMD_Vel type; };
+template<> struct item<CMD_POS> { typedef CMD_Pos type; };
+template<> struct item<CMD_KICKER> { typedef CMD_Kicker type; };
+template<> struct item<CMD_INFO> { typedef CMD_Info type; };
+template<> struct item<CMD_HWERRORS> { typedef CMD_HWerrors type; };
+template<> struct item<CMD_GRABBER> { typedef CMD_Grabber type; };
+template<> struct item<LAST_CMD_VEL> { typedef CMD_Vel type; };
+template<> struct item<CMD_IMU> { typedef CMD_Imu type; };
+template<> struct item<CMD_SYNCIMU> { typedef int type; };
+template<> struct item<CMD_GRABBER_INFO> { typedef CMD_Grabber_Info type; };
+template<> struct item<CMD_GRABBER_CONFIG> { typedef CMD_Grabber_Config type; };
+template<> struct item<KICKCALIB_APP> { typedef KickCalibAppData type; };
+template<> struct item<KICKCALIB_ROB> { typedef KickCalibRobData type; };
+template<> struct item<GRIDVIEW> { typedef GridView type; };
+template<> struct item<COACHLOGROBOTSINFO> { typedef CoachLogRobotsInfo type; };
+template<> struct item<COACHLOGMODEFLAG> { typedef CoachLogModeFlag type; };
+template<> struct item<LINK_QUALITY> { typedef LinkInfo type; };
+
+}
+
+/* sizes section */
+
+RTDB_CHECK_SIZE(ROBOT_WS, 408);
+RTDB_CHECK_SIZE(LAPTOP_INFO, 2);
+RTDB_CHECK_SIZE(COACH_INFO, 260);
+RTDB_CHECK_SIZE(VISION_INFO, 8052);
+RTDB_CHECK_SIZE(FRONT_VISION_INFO, 80);
+RTDB_CHECK_SIZE(FORMATION_INFO, 88);
+RTDB_CHECK_SIZE(CMD_VEL, 16);
+RTDB_CHECK_SIZE(CMD_POS, 24);
+RTDB_CHECK_SIZE(CMD_KICKER, 3);
+RTDB_CHECK_SIZE(CMD_INFO, 10);
+RTDB_CHECK_SIZE(CMD_HWERRORS, 80);
+RTDB_CHECK_SIZE(CMD_GRABBER, 1);
+RTDB_CHECK_SIZE(LAST_CMD_VEL, 16);
+RTDB_CHECK_SIZE(CMD_IMU, 12);
+RTDB_CHECK_SIZE(CMD_SYNCIMU, 4);
+RTDB_CHECK_SIZE(CMD_GRABBER_INFO, 12);
+RTDB_CHECK_SIZE(CMD_GRABBER_CONFIG, 4);
+RTDB_CHECK_SIZE(KICKCALIB_APP, 16);
+RTDB_CHECK_SIZE(KICKCALIB_ROB, 12);
+RTDB_CHECK_SIZE(GRIDVIEW, 60004);
+RTDB_CHECK_SIZE(COACHLOGROBOTSINFO, 2448);
+RTDB_CHECK_SIZE(COACHLOGMODEFLAG, 1);
+RTDB_CHECK_SIZE(LINK_QUALITY, 204);
+
+#endif
+
+/* EOF : rtdb_typed.h */
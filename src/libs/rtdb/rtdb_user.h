@@ -40,8 +40,9 @@
 #define GRIDVIEW	20
 #define COACHLOGROBOTSINFO	21
 #define COACHLOGMODEFLAG	22
+#define LINK_QUALITY	23
 
-#define N_ITEMS	23
+#define N_ITEMS	24
 
 #endif
 
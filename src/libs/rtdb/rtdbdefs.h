@@ -33,24 +33,58 @@ extern "C" {
 
 #define CONFIG_FILE	"../config/rtdb.ini"
 
-#define SHMEM_KEY 0x2000
-#define SHMEM_SECOND_TEAM_KEY 0x3000
+// one POSIX shared memory segment per agent: /dev/shm/rtdb.<team>.<agent>
+#define SHMEM_NAME "/rtdb"
+
+// comm listens for urgent records in the abstract unix socket rtdb.urgent.<team>.<agent>
+#define URGENT_NAME "rtdb.urgent"
 
 // definicoes hard-coded
 // alterar de acordo com a utilizacao pretendida
 
-#define MAX_AGENTS 7	// numero maximo de agentes
-#define MAX_RECS 100	// numero maximo de 'variaveis' (shared + local)
+#define MAX_AGENTS 7	// numero maximo de agentes na trama do comm (o RTDB usa o rtdb.ini)
 
 // fim das definicoes hard-coded
 
 typedef struct
 {
 	int id;				// identificador da 'variavel'
-	int size;			// tamanho de dados
+	int size;			// tamanho de dados (maximo, cada escrita pode usar menos)
 	int period;			// periodicidade de refrescamento via wireless
+	int history;		// numero de amostras antigas guardadas (alem da actual)
+	int channel;		// canal do comm (0 = default)
+	unsigned int layout;	// hash do layout do tipo de dados (xrtdb, 0 = desconhecido)
 } RTDBconf_var;
 
+// comm channel, one multicast group each (CHANNEL in rtdb.conf)
+typedef struct
+{
+	int number;			// 1-n, 0 is the default channel
+	char name[32];
+	char group[16];		// multicast address
+	int port;
+	int period;			// transmission period, in comm cycles
+	int ttl;			// multicast TTL (0 = system default)
+} RTDBchannel;
+
+typedef struct
+{
+	void *p_rec;		// record header in the shared segment
+	unsigned int seq;	// record sequence when the reference was taken
+	int bank;			// bank being read or written
+	int length;			// bytes in use in the bank (reads only)
+	int life;			// tempo de vida da 'variavel' em ms (writes only)
+} RTDBref;
+
+typedef struct
+{
+	int agent;			// numero do agente (ou SELF)
+	int id;				// identificador da 'variavel'
+	void *value;		// ponteiro para os dados
+	int len;			// bytes in use (-1 = whole record on writes)
+	int life;			// tempo de vida da 'variavel' em ms (-1 = erro on reads)
+} RTDBitem;
+
 #ifdef __cplusplus
 }
 #endif
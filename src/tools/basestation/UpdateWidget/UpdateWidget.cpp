@@ -84,19 +84,29 @@ void UpdateWidget::UpdateInfo(void)
 	}
 	//return;
 	
-	Robot temp_info;
+	Robot temp_info[NROBOTS];
 	LaptopInfo lpBatTemp[NROBOTS];
 	CoachInfo coach_temp;
     FormationInfo formation_temp;
 
-	int CoachLifetime;
+	// everything shown by the basestation in one batch: coach data, then
+	// the world state and laptop info of each robot
+	RTDBitem items[2 + 2*NROBOTS];
+	items[0].agent = Whoami(); items[0].id = COACH_INFO; items[0].value = (void*)&coach_temp;
+	items[1].agent = Whoami(); items[1].id = FORMATION_INFO; items[1].value = (void*)&formation_temp;
+	for(int i=0; i<NROBOTS;i++)
+	{
+		items[2+2*i].agent = i+1; items[2+2*i].id = ROBOT_WS; items[2+2*i].value = (void*)&temp_info[i];
+		items[3+2*i].agent = i+1; items[3+2*i].id = LAPTOP_INFO; items[3+2*i].value = (void*)&lpBatTemp[i];
+	}
+	DB_get_many(items, 2 + 2*NROBOTS);
+
 	bool valid_info=true;
-	if( (CoachLifetime=DB_get( Whoami(), COACH_INFO, (void*)&coach_temp)) == -1 )
-		if((CoachLifetime=DB_get( Whoami(), COACH_INFO, (void*)&coach_temp)) == -1 )
-		{
-			printf("RtDB read coach info error\n");
-			valid_info=false;
-		}
+	if( items[0].life == -1 )
+	{
+		printf("RtDB read coach info error\n");
+		valid_info=false;
+	}
 
 	if(valid_info)
 	{
@@ -105,12 +115,11 @@ void UpdateWidget::UpdateInfo(void)
             formationCombo->setCurrentIndex(coach_temp.half);
     }
 
-    if( (CoachLifetime=DB_get( Whoami(), FORMATION_INFO, (void*)&formation_temp)) == -1 )
-        if((CoachLifetime=DB_get( Whoami(), FORMATION_INFO, (void*)&formation_temp)) == -1 )
-        {
-            printf("RtDB read coach info error\n");
-            valid_info=false;
-        }
+    if( items[1].life == -1 )
+    {
+        printf("RtDB read coach info error\n");
+        valid_info=false;
+    }
 
     if(valid_info)
     {
@@ -123,20 +132,18 @@ void UpdateWidget::UpdateInfo(void)
 	{
 		long lifetime;
 		valid_info = true;
-		if( (lifetime=DB_get( i+1, ROBOT_WS, (void*)&temp_info)) == -1 )
-			if( (lifetime=DB_get( i+1, ROBOT_WS, (void*)&temp_info)) == -1 )
-			{
-				valid_info=false;
-				Robots_info.Robot_status[i] = STATUS_KO;
-				printf("RtDB read error\n");
-			}
+		if( (lifetime=items[2+2*i].life) == -1 )
+		{
+			valid_info=false;
+			Robots_info.Robot_status[i] = STATUS_KO;
+			printf("RtDB read error\n");
+		}
 
 		int batteryLifetime;
-		if( (batteryLifetime=DB_get( i+1, LAPTOP_INFO, (void*)&lpBatTemp[i])) == -1 )
-			if( (batteryLifetime=DB_get( i+1, LAPTOP_INFO, (void*)&lpBatTemp[i])) == -1 )
-			{
-				printf("RtDB read bat info error\n");
-			}
+		if( (batteryLifetime=items[3+2*i].life) == -1 )
+		{
+			printf("RtDB read bat info error\n");
+		}
 
 
 		if( batteryLifetime <0 || batteryLifetime > 30000 )
@@ -153,7 +160,7 @@ void UpdateWidget::UpdateInfo(void)
         //fprintf(stderr, "RTDB: robot %d -> validinfo = %d lifetime = %d\n", i, valid_info, lifetime);
 		if(valid_info )
 		{
-			memcpy(&Robots_info.Robot_info[i], &temp_info, sizeof(Robot));
+			memcpy(&Robots_info.Robot_info[i], &temp_info[i], sizeof(Robot));
 			if (lifetime < NOT_RUNNING_TIMEOUT)
 			{
 
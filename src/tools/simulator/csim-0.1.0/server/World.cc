@@ -320,6 +320,9 @@ void World::Update()
   /// Update all the sensors
   SensorManager::Instance()->Update();
 
+  /// Agents in lockstep finish their cycle before the physics moves on
+  SensorManager::Instance()->Sync();
+
   if (!Simulator::Instance()->IsPaused() &&
        Simulator::Instance()->GetPhysicsEnabled())
   {
@@ -97,13 +97,8 @@ void Comm::InitChild()
   if ( this->rtdbConfigFile != "" )
     DB_set_config_file( this->rtdbConfigFile.c_str() );
   
-  int _second_rtdb;
-  if ( this->rtdbNum == 1)
-    _second_rtdb = 1;
-  else
-    _second_rtdb = 0;
-    
-  if ( DB_init_all( _second_rtdb ) == -1 )
+  // one team per comm controller
+  if ( DB_init_all( this->rtdbNum ) == -1 )
       gzthrow("Unable to init rtdb");
   
   // Flag rtdb clean up
@@ -116,19 +111,17 @@ void Comm::UpdateChild()
 {
 
   // Share robots World State
-  Robot rws;
+  Robot rws[N_AGENTS];
 	CoachInfo cInfo;
   FormationInfo fInfo;
   KickCalibAppData kcAppData;
-  KickCalibRobData kcRobData;
+  KickCalibRobData kcRobData[N_AGENTS];
   GridView gv;
   
   int offset;
   unsigned int FINFO_Lifetime;
-  if ( this->rtdbNum == 1 )
-    offset = MAX_AGENTS;
-  else
-    offset = 0;
+  // agent memory of the first agent of the team, the others follow it
+  offset = DB_instance( this->rtdbNum, 0 );
   
   // Fetch coach data
   DB_get_from(0 + offset, 0, COACH_INFO, (void*)&cInfo);
@@ -137,24 +130,42 @@ void Comm::UpdateChild()
 
 //  fprintf(stderr,"csim_comm finfo size %d fid %d msg %s\n", sizeof(fInfo), fInfo.formationID, fInfo.setplayMessage);
 
+  // Fetch the shared data of every robot, each one from its own memory
+  RTDBitem shared[2 * N_AGENTS];
   for(int ag1=1; ag1 < N_AGENTS; ag1++) {
-    DB_put_in(ag1 + offset , 0, COACH_INFO, (void*)&cInfo,0);
-    if(FINFO_Lifetime < 1000){    
-	DB_put_in(ag1 + offset, 0, FORMATION_INFO, (void*)&fInfo,0);
+    RTDBitem *item = &shared[2 * ag1];
+    item[0].agent = ag1;
+    item[0].id = ROBOT_WS;
+    item[0].value = (void*)&rws[ag1];
+    item[1].agent = ag1;
+    item[1].id = KICKCALIB_ROB;
+    item[1].value = (void*)&kcRobData[ag1];
+    //GRIDVIEW is not shared
+    DB_get_many_from(ag1 + offset, item, 2);
+  }
+
+  // and write it, with the coach data, in one batch per agent memory
+  RTDBitem batch[3 + 2 * N_AGENTS];
+  for(int ag2=0; ag2 < N_AGENTS; ag2++) {
+    int n = 0;
+    if(ag2 != 0) {
+      batch[n].agent = 0; batch[n].id = COACH_INFO; batch[n].value = (void*)&cInfo; batch[n].len = -1; batch[n].life = 0; n++;
+      if(FINFO_Lifetime < 1000) {
+        batch[n].agent = 0; batch[n].id = FORMATION_INFO; batch[n].value = (void*)&fInfo; batch[n].len = -1; batch[n].life = 0; n++;
+      }
+      batch[n].agent = 0; batch[n].id = KICKCALIB_APP; batch[n].value = (void*)&kcAppData; batch[n].len = -1; batch[n].life = 0; n++;
     }
-    DB_put_in(ag1 + offset, 0, KICKCALIB_APP, (void*)&kcAppData,0);
-
-    int lt = DB_get_from(ag1 + offset, ag1, ROBOT_WS, (void*)&rws);
-    int lt2 = DB_get_from(ag1 + offset, ag1, KICKCALIB_ROB, (void*)&kcRobData);
-    //int lt3 = DB_get_from(ag1 + offset, ag1, GRIDVIEW, (void*)&gv);
-    for(int ag2=0; ag2 < N_AGENTS; ag2++) {
-      if(ag1!=ag2) {
-        DB_put_in(ag2 + offset, ag1, ROBOT_WS, (void*)&rws, lt );
-        DB_put_in(ag2 + offset, ag1, KICKCALIB_ROB, (void*)&kcRobData, lt2 );
-        //DB_put_in(ag2 + offset, ag1, GRIDVIEW, (void*)&gv, lt3 );
+    for(int ag1=1; ag1 < N_AGENTS; ag1++) {
+      if(ag1 != ag2) {
+        for(int k=0; k < 2; k++) {
+          // items that could not be read are not copied
+          if(shared[2 * ag1 + k].life != -1)
+            batch[n++] = shared[2 * ag1 + k];
+        }
       }
-    } // end for( ag2 )
-  } // end for( ag1 )
+    } // end for( ag1 )
+    DB_put_many_in(ag2 + offset, batch, n);
+  } // end for( ag2 )
 
 }
 
@@ -163,12 +174,6 @@ void Comm::UpdateChild()
 void Comm::FiniChild()
 {
   if ( this->fRTDB ) {
-    int _second_rtdb;
-    if ( this->rtdbNum == 1)
-      _second_rtdb = 1;
-    else
-      _second_rtdb = 0;
-      
-    DB_free_all(_second_rtdb);
+    DB_free_all( this->rtdbNum );
   }
 }
@@ -140,6 +140,13 @@ void Sensor::Update()
     this->controller->Update();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Wait for what the update started
+void Sensor::Sync()
+{
+  this->SyncChild();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Finalize the sensor
 void Sensor::Fini()
@@ -67,6 +67,9 @@ namespace gazebo
   
     /// \brief  Update the sensor
     public: void Update();
+
+    /// \brief  Wait for what the update started, before the world steps
+    public: void Sync();
   
     /// \brief  Finalize the sensor
     public: void Fini();
@@ -92,6 +95,9 @@ namespace gazebo
   
     /// \brief  Update the child
     protected: virtual void UpdateChild() {};
+
+    /// \brief  Sync the child
+    protected: virtual void SyncChild() {};
   
     /// \brief Finalize the child
     protected: virtual void FiniChild() {};
@@ -53,6 +53,15 @@ void SensorManager::Update()
     
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Wait for what the sensors started in Update
+void SensorManager::Sync()
+{
+  std::list<Sensor*>::iterator iter;
+  for (iter = this->sensors.begin(); iter != this->sensors.end(); iter++)
+    (*iter)->Sync();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Init all the sensors
 void SensorManager::Init()
@@ -48,6 +48,10 @@ namespace gazebo
     /// \brief Update all the sensors
     public: void Update();
 
+    /// \brief Wait for what the sensors started in Update (e.g. lockstep
+    ///        agents) before the world steps
+    public: void Sync();
+
     /// \brief Init all the sensors
     public: void Init();
 
@@ -83,6 +83,8 @@ SensorVision::SensorVision(Body *body)
 {
   this->omniQueue = NULL;
   this->typeName  = "vision";
+  this->fPMAN     = false;
+  this->lockstep  = false;
 }
 
 
@@ -114,6 +116,8 @@ void SensorVision::LoadChild( XMLConfigNode *node )
 
   this->PMANConfigFile = node->GetFilename("PMANConf", std::string(), 0);
   if ( this->PMANConfigFile == "" ) this->PMANConfigFile = std::string("../config/pman.conf"); 
+  this->lockstep        = node->GetBool("lockstep", false, 0);
+  this->lockstepTimeout = node->GetInt("lockstepTimeout", 1000, 0);
 
   this->selfID = this->GetParentModel()->GetSelfID();
   
@@ -167,13 +171,12 @@ void SensorVision::InitChild()
   }
   
   // Init PMAN
-  FILE *fpPman = NULL;
-	int pmanstat, pprio;
+	int pmanstat;
 
   this->fPMAN = false;
 	// PMAN initializations
   pmanstat = PMAN_init2(SHMEM_OCAM_PMAN_KEY + 2*this->selfID, SEM_OCAM_PMAN_KEY + 2*this->selfID,
-                       (void *)dummyShed, sizeof(pprio), PMAN_NEW);
+                       (void *)dummyShed, sizeof(PMAN_QOS_TYPE), PMAN_NEW);
 
 	if( pmanstat < 0 ) {
 	 /* 
@@ -196,22 +199,14 @@ void SensorVision::InitChild()
     this->fPMAN = true;
     pman_save_ids( this->selfID );
     
-		if(!(fpPman = fopen( this->PMANConfigFile.c_str() , "r"))) {
+		// process- {name, period, phase, deadline, priority [, policy, cpus]}; the QoS
+		// is ignored (dummyShed), the simulator does not change the scheduling
+		if( PMAN_conf_load( this->PMANConfigFile.c_str() ) < 0 ) {
   		gzthrow("Couldn't open PMAN configuration file");
 		}
-		else {
-			do {
-				char pname[32];
-				int pper, ppha, pddln, pprio;
-				// process- {name, period, phase, deadline, priority}
-				int nv = fscanf(fpPman,"%s %d %d %d %d",pname,&pper,&ppha,&pddln,&pprio);
-				if( nv == 5 ) {
-					PMAN_procadd(pname,PMAN_NOPID,pper,ppha,pddln,&pprio,sizeof(pprio));
-				}
-			} while( !feof(fpPman) );
-
-			fclose(fpPman);
-		}
+
+    if ( this->lockstep )
+      PMAN_sim_mode( PMAN_SIM_LOCKSTEP );
 	}
 	// end PAMN init
 	
@@ -253,11 +248,26 @@ void SensorVision::UpdateChild()
   }
   
   // Send data to RTDB
-  DB_put_in( this->selfID, this->selfID, VISION_INFO, &(this->visionInfo), 0 );
+  DB_put_in_len( this->selfID, this->selfID, VISION_INFO, &(this->visionInfo), this->visionInfo.usedSize(), 0 );
   
   // awake Agent
   pman_switch_id( this->selfID );
-  PMAN_tick();
+  if ( this->lockstep )
+    PMAN_sim_tick( (long long)(this->simulator->GetSimTime().Double() * 1e6) );
+  else
+    PMAN_tick();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Wait for the agent processes woken by the last update
+void SensorVision::SyncChild()
+{
+  if ( !this->fPMAN || !this->lockstep ) return;
+
+  pman_switch_id( this->selfID );
+  if ( PMAN_sim_wait( this->lockstepTimeout ) == -3 )
+    gzerr(0) << "Agent " << this->selfID << " did not finish its cycle in "
+             << this->lockstepTimeout << " ms, the simulation goes on\n";
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -84,6 +84,9 @@ class SensorVision : public Sensor
   /// \brief Update the sensor information
   protected: virtual void UpdateChild();
 
+  /// \brief Wait for the agent cycle (lockstep)
+  protected: virtual void SyncChild();
+
   /// Finalize the camera
   protected: virtual void FiniChild();
 
@@ -131,6 +134,9 @@ class SensorVision : public Sensor
     // PMAN config file
     std::string PMANConfigFile;
     bool fPMAN;
+    // PMAN in lockstep: the agents run at simulated time, the world waits for them
+    bool lockstep;
+    int lockstepTimeout; // ms
 };
 
 /// \}
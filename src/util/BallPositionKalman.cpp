@@ -21,6 +21,7 @@
  */
 
 #include "BallPositionKalman.h"
+#include "Clock.h"
 #include <cstdio>
 
 using namespace cambada;
@@ -42,7 +43,7 @@ BallPositionKalman::BallPositionKalman( double readingDeviation )
 	lastVel		= Vec::zero_vector;
 	
 	struct timeval tmpTime;
-	gettimeofday( &tmpTime , NULL );
+	cambada::util::Clock::gettime( &tmpTime );
 	
 	lastTime = tmpTime.tv_sec*1000 + tmpTime.tv_usec/1000;
 	
@@ -21,6 +21,7 @@
  */
 
 #include "BallPositionParticle.h"
+#include "Clock.h"
 
 #define sqrt2pi 2.506628274631000
 
@@ -40,7 +41,7 @@ BallPositionParticle::BallPositionParticle()
 BallPositionParticle::BallPositionParticle( double readingDeviation, int squareBase )
 {
 	struct timeval tmpTime;
-	gettimeofday( &tmpTime , NULL );
+	cambada::util::Clock::gettime( &tmpTime );
 	
 	lastTime = tmpTime.tv_sec*1000 + tmpTime.tv_usec/1000;		//initialize the last time instant as the creation time
 	lastPosition = Vec::zero_vector;
@@ -331,7 +332,7 @@ void BallPositionParticle::updateFilter( unsigned long instant, Vec readPosition
 void BallPositionParticle::resetFilter( Vec initialPosition )
 {
 	struct timeval tmpTime;
-	gettimeofday( &tmpTime , NULL );
+	cambada::util::Clock::gettime( &tmpTime );
 	
 	lastTime = tmpTime.tv_sec*1000 + tmpTime.tv_usec/1000;
 	lastPosition = Vec::zero_vector;
@@ -25,6 +25,13 @@
 #include <sys/time.h>
 #include <time.h>
 
+static int wallclock(struct timeval *tv)
+{
+	return gettimeofday( tv , NULL );
+}
+
+cambada::util::Clock::Source cambada::util::Clock::source = wallclock;
+
 cambada::util::Clock::Clock()
 {
 	// TODO Auto-generated constructor stub
@@ -39,9 +46,19 @@ cambada::util::Clock::~Clock()
 float cambada::util::Clock::now()
 {
 	struct timeval tv;
-	gettimeofday( &tv , NULL );
+	gettime( &tv );
 	return tv.tv_sec*1000+tv.tv_usec/1000;
 }
 
 
 
+
+void cambada::util::Clock::setSource(Source source)
+{
+	cambada::util::Clock::source = source != 0 ? source : wallclock;
+}
+
+void cambada::util::Clock::gettime(struct timeval *tv)
+{
+	source( tv );
+}
@@ -23,6 +23,8 @@
 #ifndef CLOCK_H_
 #define CLOCK_H_
 
+struct timeval;
+
 namespace cambada
 {
 
@@ -35,6 +37,15 @@ public:
 	Clock();
 	virtual ~Clock();
 	static float now();
+
+	/* Time source of now() and gettime(), gettimeofday by default; the agent
+	 * sets PMAN_gettime so that it follows the simulated time in lockstep */
+	typedef int (*Source)(struct timeval *tv);
+	static void setSource(Source source);
+	static void gettime(struct timeval *tv);
+
+private:
+	static Source source;
 };
 
 }  // namespace util
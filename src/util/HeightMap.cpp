@@ -21,6 +21,7 @@
  */
 
 #include "HeightMap.h"
+#include "rtdb_typed.h"
 
 using namespace cambada::geom;
 
@@ -78,20 +79,25 @@ void HeightMap::fillRtdb()
 {
 	if(Whoami() == 0)
 	{
-		GridView gv;
+		// write straight into the RTDB bank, the grid is too big to be copied every cycle
+		RTDBref ref;
+		GridView* gv = rtdb::put_begin<GRIDVIEW>(&ref);
+		if( gv == NULL )
+			return;
+
 		int count= 0;
 
 		for (int x=0; x < SAMPLE_SCREEN_WIDTH; x++ ) {
 			for (int y=0; y < SAMPLE_SCREEN_LENGTH; y++ ) {
-				gv.grid[count].pos = grid2world(x, y);
-				//fprintf(stderr, "FILL x %.2f %.2f\n", gv.grid[count].pos.x, gv.grid[count].pos.y);
-				gv.grid[count].val = map->getValue(x, y);
+				gv->grid[count].pos = grid2world(x, y);
+				//fprintf(stderr, "FILL x %.2f %.2f\n", gv->grid[count].pos.x, gv->grid[count].pos.y);
+				gv->grid[count].val = map->getValue(x, y);
 				count++;
 			}
 		}
 
-		gv.count = count;
-		DB_put(GRIDVIEW, (void*)&gv);
+		gv->count = count;
+		DB_put_commit(&ref);
 	}
 }
 